@@ -31,6 +31,8 @@ typedef struct {
 
     UINTN LoadedFileCount;
     LOADED_FILE LoadedFiles[MAX_LOADED_FILES];
+
+    uint64_t AcpiRsdp;
 } BOOT_INFO;
 
 typedef struct {
@@ -340,6 +342,17 @@ EFI_STATUS EFIAPI efi_main(
     );
     CHECK(Status, L"ELF Load");
 
+    for (UINTN i = 0; i < ST->NumberOfTableEntries; i++) {
+        EFI_CONFIGURATION_TABLE *Table = &ST->ConfigurationTable[i];
+        if (CompareGuid(&Table->VendorGuid, &Acpi20TableGuid) == 0) {
+            BootInfo.AcpiRsdp = (uint64_t)Table->VendorTable;
+            break;
+        }
+        if (CompareGuid(&Table->VendorGuid, &AcpiTableGuid) == 0) {
+            BootInfo.AcpiRsdp = (uint64_t)Table->VendorTable;
+        }
+    }
+
     Print(L"[LOADER] Jumping to kernel\n");
 
     Status = ExitBootServicesComplete(
@@ -0,0 +1,158 @@
+#include "ACPI_Main.h"
+#include "../Serial.h"
+#include <stddef.h>
+
+#define MADT_ENTRY_LAPIC          0
+#define MADT_ENTRY_IOAPIC         1
+#define MADT_ENTRY_IRQ_OVERRIDE   2
+#define MADT_ENTRY_LAPIC_OVERRIDE 5
+#define MADT_LAPIC_ENABLED        (1u << 0)
+#define MADT_LAPIC_ONLINE_CAPABLE (1u << 1)
+
+typedef struct __attribute__((packed)) {
+    char signature[8];
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+    uint32_t length;
+    uint64_t xsdt_address;
+    uint8_t extended_checksum;
+    uint8_t reserved[3];
+} acpi_rsdp_t;
+
+typedef struct __attribute__((packed)) {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} acpi_sdt_header_t;
+
+typedef struct __attribute__((packed)) {
+    acpi_sdt_header_t header;
+    uint32_t lapic_address;
+    uint32_t flags;
+} acpi_madt_t;
+
+static acpi_madt_info_t g_madt_info;
+
+static bool acpi_checksum_ok(const void *table, uint32_t length) {
+    const uint8_t *bytes = (const uint8_t *)table;
+    uint8_t sum = 0;
+    for (uint32_t i = 0; i < length; ++i) {
+        sum = (uint8_t)(sum + bytes[i]);
+    }
+    return sum == 0;
+}
+
+static bool acpi_signature_is(const char *signature, const char *expected, uint32_t length) {
+    for (uint32_t i = 0; i < length; ++i) {
+        if (signature[i] != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static const acpi_sdt_header_t *acpi_find_table(const acpi_rsdp_t *rsdp, const char *signature) {
+    const acpi_sdt_header_t *root;
+    uint32_t entry_size;
+
+    if (rsdp->revision >= 2 && rsdp->xsdt_address != 0) {
+        root = (const acpi_sdt_header_t *)(uintptr_t)rsdp->xsdt_address;
+        entry_size = 8;
+    } else {
+        root = (const acpi_sdt_header_t *)(uintptr_t)rsdp->rsdt_address;
+        entry_size = 4;
+    }
+    if (root == NULL || !acpi_checksum_ok(root, root->length)) {
+        return NULL;
+    }
+
+    uint32_t entries = (root->length - (uint32_t)sizeof(acpi_sdt_header_t)) / entry_size;
+    const uint8_t *entry = (const uint8_t *)root + sizeof(acpi_sdt_header_t);
+    for (uint32_t i = 0; i < entries; ++i, entry += entry_size) {
+        uint64_t address = (entry_size == 8) ? *(const uint64_t *)entry : *(const uint32_t *)entry;
+        const acpi_sdt_header_t *table = (const acpi_sdt_header_t *)(uintptr_t)address;
+        if (table != NULL && acpi_signature_is(table->signature, signature, 4)) {
+            return table;
+        }
+    }
+    return NULL;
+}
+
+static void acpi_parse_madt(const acpi_madt_t *madt) {
+    g_madt_info.lapic_address = madt->lapic_address;
+
+    const uint8_t *entry = (const uint8_t *)madt + sizeof(acpi_madt_t);
+    const uint8_t *end = (const uint8_t *)madt + madt->header.length;
+    while (entry + 2 <= end && entry[1] >= 2 && entry + entry[1] <= end) {
+        switch (entry[0]) {
+        case MADT_ENTRY_LAPIC: {
+            uint32_t flags = *(const uint32_t *)(entry + 4);
+            if ((flags & (MADT_LAPIC_ENABLED | MADT_LAPIC_ONLINE_CAPABLE)) != 0 &&
+                g_madt_info.cpu_count < ACPI_MAX_CPUS) {
+                g_madt_info.lapic_ids[g_madt_info.cpu_count++] = entry[3];
+            }
+            break;
+        }
+        case MADT_ENTRY_IOAPIC:
+            if (g_madt_info.ioapic_count < ACPI_MAX_IOAPICS) {
+                acpi_ioapic_t *ioapic = &g_madt_info.ioapics[g_madt_info.ioapic_count++];
+                ioapic->id = entry[2];
+                ioapic->address = *(const uint32_t *)(entry + 4);
+                ioapic->gsi_base = *(const uint32_t *)(entry + 8);
+            }
+            break;
+        case MADT_ENTRY_IRQ_OVERRIDE:
+            if (g_madt_info.override_count < ACPI_MAX_OVERRIDES) {
+                acpi_irq_override_t *iso = &g_madt_info.overrides[g_madt_info.override_count++];
+                iso->source_irq = entry[3];
+                iso->gsi = *(const uint32_t *)(entry + 4);
+                iso->flags = *(const uint16_t *)(entry + 8);
+            }
+            break;
+        case MADT_ENTRY_LAPIC_OVERRIDE:
+            g_madt_info.lapic_address = *(const uint64_t *)(entry + 4);
+            break;
+        default:
+            break;
+        }
+        entry += entry[1];
+    }
+}
+
+bool acpi_init(uint64_t rsdp_address) {
+    g_madt_info.lapic_address = 0;
+    g_madt_info.cpu_count = 0;
+    g_madt_info.ioapic_count = 0;
+    g_madt_info.override_count = 0;
+
+    const acpi_rsdp_t *rsdp = (const acpi_rsdp_t *)(uintptr_t)rsdp_address;
+    if (rsdp == NULL || !acpi_signature_is(rsdp->signature, "RSD PTR ", 8) ||
+        !acpi_checksum_ok(rsdp, 20)) {
+        serial_write_string("[OS] [ACPI] RSDP not found\n");
+        return false;
+    }
+
+    const acpi_madt_t *madt = (const acpi_madt_t *)acpi_find_table(rsdp, "APIC");
+    if (madt == NULL || !acpi_checksum_ok(madt, madt->header.length)) {
+        serial_write_string("[OS] [ACPI] MADT not found\n");
+        return false;
+    }
+
+    acpi_parse_madt(madt);
+    serial_write_string("[OS] [ACPI] MADT parsed, CPUs: ");
+    serial_write_uint32(g_madt_info.cpu_count);
+    serial_write_string("\n");
+    return true;
+}
+
+const acpi_madt_info_t *acpi_get_madt_info(void) {
+    return &g_madt_info;
+}
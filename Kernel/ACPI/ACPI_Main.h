@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ACPI_MAX_CPUS 64
+#define ACPI_MAX_IOAPICS 4
+#define ACPI_MAX_OVERRIDES 16
+
+typedef struct {
+    uint8_t id;
+    uint32_t address;
+    uint32_t gsi_base;
+} acpi_ioapic_t;
+
+typedef struct {
+    uint8_t source_irq;
+    uint32_t gsi;
+    uint16_t flags;
+} acpi_irq_override_t;
+
+typedef struct {
+    uint64_t lapic_address;
+    uint32_t cpu_count;
+    uint8_t lapic_ids[ACPI_MAX_CPUS];
+    uint32_t ioapic_count;
+    acpi_ioapic_t ioapics[ACPI_MAX_IOAPICS];
+    uint32_t override_count;
+    acpi_irq_override_t overrides[ACPI_MAX_OVERRIDES];
+} acpi_madt_info_t;
+
+bool acpi_init(uint64_t rsdp_address);
+const acpi_madt_info_t *acpi_get_madt_info(void);
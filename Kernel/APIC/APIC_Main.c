@@ -0,0 +1,242 @@
+#include "APIC_Main.h"
+#include "../ACPI/ACPI_Main.h"
+#include "../CPU/CPU_Main.h"
+#include "../IO/IO_Main.h"
+#include "../Paging/Paging_Main.h"
+#include "../Serial.h"
+#include <stddef.h>
+
+#define LAPIC_REG_ID       0x020
+#define LAPIC_REG_TPR      0x080
+#define LAPIC_REG_EOI      0x0B0
+#define LAPIC_REG_SVR      0x0F0
+#define LAPIC_REG_ICR_LOW  0x300
+#define LAPIC_REG_ICR_HIGH 0x310
+#define LAPIC_REG_LVT_TIMER 0x320
+#define LAPIC_REG_TIMER_INITIAL 0x380
+#define LAPIC_REG_TIMER_CURRENT 0x390
+#define LAPIC_REG_TIMER_DIVIDE  0x3E0
+
+#define LAPIC_SVR_ENABLE        (1u << 8)
+#define LAPIC_ICR_PENDING       (1u << 12)
+#define LAPIC_ICR_LEVEL_ASSERT  (1u << 14)
+#define LAPIC_ICR_DELIVERY_INIT    (5u << 8)
+#define LAPIC_ICR_DELIVERY_STARTUP (6u << 8)
+#define LAPIC_TIMER_MODE_TSC_DEADLINE (2u << 17)
+#define LAPIC_TIMER_DIVIDE_BY_16 0x3u
+
+#define APIC_BASE_ADDRESS_MASK 0xFFFFFFFFFF000ULL
+#define APIC_BASE_ENABLE       (1ULL << 11)
+
+#define PIT_CHANNEL2_PORT 0x42
+#define PIT_COMMAND_PORT  0x43
+#define PIT_GATE_PORT     0x61
+#define PIT_FREQUENCY_HZ  1193182u
+
+#define IOAPIC_REG_SELECT 0x00
+#define IOAPIC_REG_WINDOW 0x10
+#define IOAPIC_REG_VERSION 0x01
+#define IOAPIC_REG_REDIRECT 0x10
+
+#define IOAPIC_REDIRECT_LEVEL      (1u << 15)
+#define IOAPIC_REDIRECT_ACTIVE_LOW (1u << 13)
+
+#define MADT_POLARITY_MASK 0x3u
+#define MADT_POLARITY_LOW  0x3u
+#define MADT_TRIGGER_MASK  0xCu
+#define MADT_TRIGGER_LEVEL 0xCu
+
+#define PIC_MASTER_DATA 0x21
+#define PIC_SLAVE_DATA  0xA1
+
+static volatile uint32_t *g_lapic = NULL;
+static volatile uint32_t *g_ioapics[ACPI_MAX_IOAPICS];
+
+static inline uint32_t lapic_read(uint32_t reg) {
+    return g_lapic[reg / 4];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+    g_lapic[reg / 4] = value;
+}
+
+static void lapic_wait_icr_idle(void) {
+    while (lapic_read(LAPIC_REG_ICR_LOW) & LAPIC_ICR_PENDING) {
+        __asm__ volatile ("pause");
+    }
+}
+
+static void lapic_send_icr(uint32_t lapic_id, uint32_t low) {
+    lapic_wait_icr_idle();
+    lapic_write(LAPIC_REG_ICR_HIGH, lapic_id << 24);
+    lapic_write(LAPIC_REG_ICR_LOW, low);
+    lapic_wait_icr_idle();
+}
+
+bool apic_init(uint64_t lapic_address) {
+    uint64_t base_msr = rdmsr(IA32_APIC_BASE);
+    if (lapic_address == 0) {
+        lapic_address = base_msr & APIC_BASE_ADDRESS_MASK;
+    }
+    wrmsr(IA32_APIC_BASE, base_msr | APIC_BASE_ENABLE);
+
+    g_lapic = (volatile uint32_t *)map_mmio_virt(lapic_address);
+    if (g_lapic == NULL) {
+        serial_write_string("[OS] [APIC] Local APIC mapping failed\n");
+        return false;
+    }
+
+    apic_init_cpu();
+    serial_write_string("[OS] [APIC] Local APIC enabled at ");
+    serial_write_uint64(lapic_address);
+    serial_write_string("\n");
+    return true;
+}
+
+void apic_init_cpu(void) {
+    if (g_lapic == NULL) {
+        return;
+    }
+    wrmsr(IA32_APIC_BASE, rdmsr(IA32_APIC_BASE) | APIC_BASE_ENABLE);
+    lapic_write(LAPIC_REG_TPR, 0);
+    lapic_write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | APIC_VECTOR_SPURIOUS);
+}
+
+bool apic_is_ready(void) {
+    return g_lapic != NULL;
+}
+
+uint32_t apic_id(void) {
+    if (g_lapic == NULL) {
+        return cpu_initial_apic_id();
+    }
+    return lapic_read(LAPIC_REG_ID) >> 24;
+}
+
+void apic_eoi(void) {
+    if (g_lapic != NULL) {
+        lapic_write(LAPIC_REG_EOI, 0);
+    }
+}
+
+void apic_send_ipi(uint32_t lapic_id, uint8_t vector) {
+    if (g_lapic == NULL) {
+        return;
+    }
+    lapic_send_icr(lapic_id, vector);
+}
+
+void apic_send_init(uint32_t lapic_id) {
+    lapic_send_icr(lapic_id, LAPIC_ICR_DELIVERY_INIT | LAPIC_ICR_LEVEL_ASSERT);
+}
+
+void apic_send_startup(uint32_t lapic_id, uint8_t page) {
+    lapic_send_icr(lapic_id, LAPIC_ICR_DELIVERY_STARTUP | page);
+}
+
+void apic_delay_us(uint32_t microseconds) {
+    while (microseconds > 0) {
+        uint32_t chunk = microseconds > 50000 ? 50000 : microseconds;
+        uint32_t count = (uint32_t)(((uint64_t)PIT_FREQUENCY_HZ * chunk) / 1000000u);
+        if (count == 0) {
+            count = 1;
+        }
+
+        uint8_t gate = inb(PIT_GATE_PORT);
+        outb(PIT_GATE_PORT, (uint8_t)((gate & ~0x02u) | 0x01u));
+        outb(PIT_COMMAND_PORT, 0xB0);
+        outb(PIT_CHANNEL2_PORT, (uint8_t)(count & 0xFF));
+        outb(PIT_CHANNEL2_PORT, (uint8_t)(count >> 8));
+        gate = inb(PIT_GATE_PORT);
+        outb(PIT_GATE_PORT, (uint8_t)(gate & ~0x01u));
+        outb(PIT_GATE_PORT, (uint8_t)(gate | 0x01u));
+        while ((inb(PIT_GATE_PORT) & 0x20) == 0) {
+            __asm__ volatile ("pause");
+        }
+
+        microseconds -= chunk;
+    }
+}
+
+void apic_timer_init_cpu(bool tsc_deadline) {
+    if (g_lapic == NULL) {
+        return;
+    }
+    lapic_write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_BY_16);
+    lapic_write(LAPIC_REG_LVT_TIMER,
+                APIC_VECTOR_TIMER | (tsc_deadline ? LAPIC_TIMER_MODE_TSC_DEADLINE : 0));
+    lapic_write(LAPIC_REG_TIMER_INITIAL, 0);
+}
+
+void apic_timer_oneshot(uint32_t count) {
+    if (g_lapic != NULL) {
+        lapic_write(LAPIC_REG_TIMER_INITIAL, count);
+    }
+}
+
+uint32_t apic_timer_current(void) {
+    if (g_lapic == NULL) {
+        return 0;
+    }
+    return lapic_read(LAPIC_REG_TIMER_CURRENT);
+}
+
+static uint32_t ioapic_read(volatile uint32_t *ioapic, uint32_t reg) {
+    ioapic[IOAPIC_REG_SELECT / 4] = reg;
+    return ioapic[IOAPIC_REG_WINDOW / 4];
+}
+
+static void ioapic_write(volatile uint32_t *ioapic, uint32_t reg, uint32_t value) {
+    ioapic[IOAPIC_REG_SELECT / 4] = reg;
+    ioapic[IOAPIC_REG_WINDOW / 4] = value;
+}
+
+// Sends a legacy ISA interrupt to one CPU, honouring the MADT source
+// overrides. ISA lines default to edge triggered, active high.
+bool apic_route_isa_irq(uint8_t irq, uint8_t vector, uint32_t lapic_id) {
+    const acpi_madt_info_t *madt = acpi_get_madt_info();
+    if (g_lapic == NULL || madt == NULL) {
+        return false;
+    }
+
+    uint32_t gsi = irq;
+    uint32_t low = vector;
+    for (uint32_t i = 0; i < madt->override_count; ++i) {
+        const acpi_irq_override_t *iso = &madt->overrides[i];
+        if (iso->source_irq != irq) {
+            continue;
+        }
+        gsi = iso->gsi;
+        if ((iso->flags & MADT_POLARITY_MASK) == MADT_POLARITY_LOW) {
+            low |= IOAPIC_REDIRECT_ACTIVE_LOW;
+        }
+        if ((iso->flags & MADT_TRIGGER_MASK) == MADT_TRIGGER_LEVEL) {
+            low |= IOAPIC_REDIRECT_LEVEL;
+        }
+        break;
+    }
+
+    for (uint32_t i = 0; i < madt->ioapic_count; ++i) {
+        const acpi_ioapic_t *info = &madt->ioapics[i];
+        if (g_ioapics[i] == NULL) {
+            g_ioapics[i] = (volatile uint32_t *)map_mmio_virt(info->address);
+            if (g_ioapics[i] == NULL) {
+                continue;
+            }
+        }
+        uint32_t entries = ((ioapic_read(g_ioapics[i], IOAPIC_REG_VERSION) >> 16) & 0xFF) + 1;
+        if (gsi < info->gsi_base || gsi >= info->gsi_base + entries) {
+            continue;
+        }
+
+        // The 8259s stay masked so the line is only delivered once.
+        outb(PIC_MASTER_DATA, 0xFF);
+        outb(PIC_SLAVE_DATA, 0xFF);
+
+        uint32_t reg = IOAPIC_REG_REDIRECT + (gsi - info->gsi_base) * 2;
+        ioapic_write(g_ioapics[i], reg + 1, lapic_id << 24);
+        ioapic_write(g_ioapics[i], reg, low);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define APIC_VECTOR_SERIAL     0x40
+#define APIC_VECTOR_TIMER      0xEF
+#define APIC_VECTOR_RESCHEDULE 0xF0
+#define APIC_VECTOR_SPURIOUS   0xFF
+
+bool apic_init(uint64_t lapic_address);
+void apic_init_cpu(void);
+bool apic_is_ready(void);
+uint32_t apic_id(void);
+void apic_eoi(void);
+void apic_send_ipi(uint32_t lapic_id, uint8_t vector);
+void apic_send_init(uint32_t lapic_id);
+void apic_send_startup(uint32_t lapic_id, uint8_t page);
+void apic_delay_us(uint32_t microseconds);
+void apic_timer_init_cpu(bool tsc_deadline);
+void apic_timer_oneshot(uint32_t count);
+uint32_t apic_timer_current(void);
+bool apic_route_isa_irq(uint8_t irq, uint8_t vector, uint32_t lapic_id);
@@ -0,0 +1,261 @@
+#include "CPU_Main.h"
+#include "../Serial.h"
+#include <stddef.h>
+
+#define CPUID_1_ECX_MONITOR (1u << 3)
+#define CPUID_7_EBX_FSGSBASE (1u << 0)
+#define CR4_FSGSBASE (1ULL << 16)
+#define CPUID_TOPOLOGY_SMT 1
+#define CPUID_CACHE_MAX_SUBLEAF 8
+
+static cpu_local_t g_cpus[CPU_MAX];
+static uint32_t g_cpu_count = 0;
+static uint32_t g_cpu_has_mwait = 0;
+static uint32_t g_cpu_has_fsgsbase = 0;
+
+cpu_local_t *cpu_register(uint32_t lapic_id) {
+    for (uint32_t i = 0; i < g_cpu_count; ++i) {
+        if (g_cpus[i].lapic_id == lapic_id) {
+            return &g_cpus[i];
+        }
+    }
+    if (g_cpu_count >= CPU_MAX) {
+        serial_write_string("[OS] [CPU] Too many CPUs, ignoring LAPIC ");
+        serial_write_uint32(lapic_id);
+        serial_write_string("\n");
+        return NULL;
+    }
+
+    cpu_local_t *cpu = &g_cpus[g_cpu_count];
+    cpu->user_rsp = 0;
+    cpu->kernel_rsp = 0;
+    cpu->self = cpu;
+    cpu->index = g_cpu_count;
+    cpu->lapic_id = lapic_id;
+    cpu->current_pid = -1;
+    cpu->online = 0;
+    cpu->current_task = NULL;
+    cpu->need_resched = 0;
+    cpu->interrupts = 0;
+    cpu->idle_wakeups = 0;
+    cpu->fs_base = 0;
+    cpu->fpu_owner = NULL;
+    cpu->fpu_kernel_depth = 0;
+    cpu->fpu_irq_flags = 0;
+    cpu->idle_rsp = 0;
+    cpu->switch_prev = NULL;
+    cpu->switch_requeue = 0;
+    cpu->interrupt_stack = NULL;
+    cpu->x2apic_id = lapic_id;
+    cpu->core_id = lapic_id;
+    cpu->package_id = 0;
+    cpu->l2_id = lapic_id;
+    cpu->llc_id = 0;
+    g_cpu_count++;
+    return cpu;
+}
+
+static uint32_t cpu_log2_ceil(uint32_t value) {
+    uint32_t shift = 0;
+    while ((1u << shift) < value) {
+        shift++;
+    }
+    return shift;
+}
+
+// Leaf 0x1F (or 0x0B) reports the APIC id shift for each level; the last
+// valid level's shift separates packages.
+static bool cpu_read_topology_leaf(uint32_t leaf, uint32_t *smt_shift, uint32_t *package_shift,
+                                   uint32_t *x2apic_id) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(leaf, 0, &eax, &ebx, &ecx, &edx);
+    if (ebx == 0) {
+        return false;
+    }
+    *x2apic_id = edx;
+    *smt_shift = 0;
+    *package_shift = 0;
+    for (uint32_t subleaf = 0; subleaf < 8; ++subleaf) {
+        cpuid(leaf, subleaf, &eax, &ebx, &ecx, &edx);
+        uint32_t type = (ecx >> 8) & 0xFF;
+        if (type == 0) {
+            break;
+        }
+        if (type == CPUID_TOPOLOGY_SMT) {
+            *smt_shift = eax & 0x1F;
+        }
+        *package_shift = eax & 0x1F;
+    }
+    return true;
+}
+
+// Intel leaf 4 and AMD leaf 0x8000001D share a layout: EAX[7:5] is the
+// cache level and EAX[25:14] the number of logical CPUs sharing it - 1.
+static bool cpu_read_cache_leaf(uint32_t leaf, uint32_t *l2_shift, uint32_t *llc_shift) {
+    uint32_t eax, ebx, ecx, edx;
+    uint32_t llc_level = 0;
+    bool found = false;
+    for (uint32_t subleaf = 0; subleaf < CPUID_CACHE_MAX_SUBLEAF; ++subleaf) {
+        cpuid(leaf, subleaf, &eax, &ebx, &ecx, &edx);
+        if ((eax & 0x1F) == 0) {
+            break;
+        }
+        uint32_t level = (eax >> 5) & 0x7;
+        uint32_t shift = cpu_log2_ceil(((eax >> 14) & 0xFFF) + 1);
+        if (level == 2) {
+            *l2_shift = shift;
+            found = true;
+        }
+        if (level >= llc_level) {
+            llc_level = level;
+            *llc_shift = shift;
+        }
+    }
+    return found;
+}
+
+static void cpu_detect_topology(cpu_local_t *cpu) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+    uint32_t max_leaf = eax;
+    bool intel = ebx == 0x756E6547;
+    cpuid(0x80000000, 0, &eax, &ebx, &ecx, &edx);
+    uint32_t max_ext_leaf = eax;
+
+    uint32_t smt_shift = 0;
+    uint32_t package_shift = 0;
+    uint32_t apic_id = cpu_initial_apic_id();
+    bool found = max_leaf >= 0x1F && cpu_read_topology_leaf(0x1F, &smt_shift, &package_shift, &apic_id);
+    if (!found && max_leaf >= 0x0B) {
+        found = cpu_read_topology_leaf(0x0B, &smt_shift, &package_shift, &apic_id);
+    }
+    if (!found) {
+        cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+        package_shift = cpu_log2_ceil((ebx >> 16) & 0xFF);
+    }
+
+    // Without cache leaves assume a private L2 and a package-wide LLC.
+    uint32_t l2_shift = smt_shift;
+    uint32_t llc_shift = package_shift;
+    if (!(intel && max_leaf >= 4 && cpu_read_cache_leaf(4, &l2_shift, &llc_shift)) &&
+        max_ext_leaf >= 0x8000001D) {
+        cpu_read_cache_leaf(0x8000001D, &l2_shift, &llc_shift);
+    }
+
+    cpu->x2apic_id = apic_id;
+    cpu->core_id = apic_id >> smt_shift;
+    cpu->package_id = apic_id >> package_shift;
+    cpu->l2_id = apic_id >> l2_shift;
+    cpu->llc_id = apic_id >> llc_shift;
+}
+
+void cpu_activate(cpu_local_t *cpu) {
+    if (g_cpu_has_fsgsbase) {
+        uint64_t cr4;
+        __asm__ volatile ("mov %%cr4, %0" : "=r"(cr4));
+        __asm__ volatile ("mov %0, %%cr4" :: "r"(cr4 | CR4_FSGSBASE));
+    }
+    wrmsr(IA32_GS_BASE, (uint64_t)cpu);
+    wrmsr(IA32_KERNEL_GS_BASE, 0);
+    wrmsr(IA32_FS_BASE, 0);
+    cpu_detect_topology(cpu);
+    cpu->online = 1;
+}
+
+uint32_t cpu_initial_apic_id(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    return ebx >> 24;
+}
+
+void cpu_init_bsp(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    g_cpu_has_mwait = (ecx & CPUID_1_ECX_MONITOR) != 0;
+    cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+    g_cpu_has_fsgsbase = (ebx & CPUID_7_EBX_FSGSBASE) != 0;
+
+    g_cpu_count = 0;
+    cpu_local_t *bsp = cpu_register(cpu_initial_apic_id());
+    cpu_activate(bsp);
+}
+
+cpu_local_t *cpu_get(uint32_t index) {
+    if (index >= g_cpu_count) {
+        return NULL;
+    }
+    return &g_cpus[index];
+}
+
+uint32_t cpu_count(void) {
+    return g_cpu_count;
+}
+
+uint32_t cpu_online_count(void) {
+    uint32_t online = 0;
+    for (uint32_t i = 0; i < g_cpu_count; ++i) {
+        if (g_cpus[i].online) {
+            online++;
+        }
+    }
+    return online;
+}
+
+uint64_t cpu_online_mask(void) {
+    uint64_t mask = 0;
+    for (uint32_t i = 0; i < g_cpu_count; ++i) {
+        if (g_cpus[i].online) {
+            mask |= 1ULL << i;
+        }
+    }
+    return mask;
+}
+
+int32_t cpu_get_topology(uint32_t index, cpu_topology_t *out) {
+    if (index >= g_cpu_count || out == NULL) {
+        return -1;
+    }
+    cpu_local_t *cpu = &g_cpus[index];
+    out->index = index;
+    out->online = cpu->online;
+    out->apic_id = cpu->x2apic_id;
+    out->core_id = cpu->core_id;
+    out->package_id = cpu->package_id;
+    out->l2_id = cpu->l2_id;
+    out->llc_id = cpu->llc_id;
+    return 0;
+}
+
+void cpu_idle_wait(volatile uint32_t *watch) {
+    if (g_cpu_has_mwait) {
+        __asm__ volatile ("monitor" :: "a"(watch), "c"(0), "d"(0));
+        if (*watch == 0) {
+            __asm__ volatile ("mwait" :: "a"(0), "c"(1));
+        }
+        __asm__ volatile ("sti; nop" ::: "memory");
+    } else {
+        __asm__ volatile ("sti; hlt" ::: "memory");
+    }
+}
+
+bool cpu_has_fsgsbase(void) {
+    return g_cpu_has_fsgsbase != 0;
+}
+
+uint64_t cpu_read_fs_base(void) {
+    cpu_local_t *cpu = cpu_current();
+    if (g_cpu_has_fsgsbase) {
+        __asm__ volatile ("rdfsbase %0" : "=r"(cpu->fs_base));
+    }
+    return cpu->fs_base;
+}
+
+void cpu_write_fs_base(uint64_t fs_base) {
+    cpu_local_t *cpu = cpu_current();
+    if (g_cpu_has_fsgsbase) {
+        __asm__ volatile ("wrfsbase %0" :: "r"(fs_base));
+    } else if (cpu->fs_base != fs_base) {
+        wrmsr(IA32_FS_BASE, fs_base);
+    }
+    cpu->fs_base = fs_base;
+}
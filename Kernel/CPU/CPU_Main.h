@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CPU_MAX 16
+
+#define IA32_APIC_BASE      0x0000001B
+#define IA32_EFER           0xC0000080
+#define IA32_STAR           0xC0000081
+#define IA32_LSTAR          0xC0000082
+#define IA32_FMASK          0xC0000084
+#define IA32_FS_BASE        0xC0000100
+#define IA32_GS_BASE        0xC0000101
+#define IA32_KERNEL_GS_BASE 0xC0000102
+
+typedef struct cpu_local {
+    uint64_t user_rsp;
+    uint64_t kernel_rsp;
+    struct cpu_local *self;
+    uint32_t index;
+    uint32_t lapic_id;
+    int32_t current_pid;
+    volatile uint32_t online;
+    void *current_task;
+    volatile uint32_t need_resched;
+    uint64_t interrupts;
+    uint64_t idle_wakeups;
+    uint64_t fs_base;
+    uint8_t *fpu_owner;
+    uint32_t fpu_kernel_depth;
+    uint64_t fpu_irq_flags;
+    uint64_t idle_rsp;
+    void *switch_prev;
+    uint32_t switch_requeue;
+    uint8_t *interrupt_stack;
+    uint32_t x2apic_id;
+    uint32_t core_id;
+    uint32_t package_id;
+    uint32_t l2_id;
+    uint32_t llc_id;
+} cpu_local_t;
+
+// Topology ids are APIC ids shifted past the lower levels, so two CPUs
+// share a core, package or cache exactly when the matching ids are equal.
+typedef struct {
+    uint32_t index;
+    uint32_t online;
+    uint32_t apic_id;
+    uint32_t core_id;
+    uint32_t package_id;
+    uint32_t l2_id;
+    uint32_t llc_id;
+} cpu_topology_t;
+
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t low, high;
+    __asm__ volatile ("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
+    return ((uint64_t)high << 32) | low;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    uint32_t low = value & 0xFFFFFFFF;
+    uint32_t high = value >> 32;
+    __asm__ volatile ("wrmsr" :: "c"(msr), "a"(low), "d"(high));
+}
+
+static inline void cpuid(uint32_t leaf, uint32_t subleaf,
+                         uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
+    __asm__ volatile ("cpuid"
+                      : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                      : "a"(leaf), "c"(subleaf));
+}
+
+static inline uint64_t rdtsc(void) {
+    uint32_t low, high;
+    __asm__ volatile ("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+static inline cpu_local_t *cpu_current(void) {
+    cpu_local_t *cpu;
+    __asm__ volatile ("mov %%gs:16, %0" : "=r"(cpu));
+    return cpu;
+}
+
+void cpu_init_bsp(void);
+uint32_t cpu_initial_apic_id(void);
+cpu_local_t *cpu_register(uint32_t lapic_id);
+void cpu_activate(cpu_local_t *cpu);
+cpu_local_t *cpu_get(uint32_t index);
+uint32_t cpu_count(void);
+uint32_t cpu_online_count(void);
+uint64_t cpu_online_mask(void);
+int32_t cpu_get_topology(uint32_t index, cpu_topology_t *out);
+void cpu_idle_wait(volatile uint32_t *watch);
+bool cpu_has_fsgsbase(void);
+uint64_t cpu_read_fs_base(void);
+void cpu_write_fs_base(uint64_t fs_base);
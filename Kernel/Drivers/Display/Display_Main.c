@@ -1,7 +1,21 @@
 #include "Display_Main.h"
 #include "VirtIO/VirtIO.h"
+#include "../../ProcessManager/ProcessManager.h"
+#include "../../WorkQueue/WorkQueue_Main.h"
+
+static sleep_lock_t g_display_lock;
+static work_item_t g_present_work;
+
+static void display_present_work(work_item_t *work) {
+    (void)work;
+    sleep_lock_acquire(&g_display_lock);
+    virtio_gpu_present();
+    sleep_lock_release(&g_display_lock);
+}
 
 bool display_init(void) {
+    sleep_lock_init(&g_display_lock);
+    work_init(&g_present_work, display_present_work);
     return virtio_gpu_init();
 }
 
@@ -18,13 +32,19 @@ uint32_t display_height(void) {
 }
 
 void display_draw_pixel(uint32_t x, uint32_t y, uint32_t color) {
+    sleep_lock_acquire(&g_display_lock);
     virtio_gpu_draw_pixel(x, y, color);
+    sleep_lock_release(&g_display_lock);
 }
 
 void display_fill_rect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color) {
+    sleep_lock_acquire(&g_display_lock);
     virtio_gpu_fill_rect(x, y, w, h, color);
+    sleep_lock_release(&g_display_lock);
 }
 
+// The transfer and flush run on a worker; presents requested while one is
+// still queued fold into it.
 void display_present(void) {
-    virtio_gpu_present();
+    workqueue_queue(&g_present_work);
 }
@@ -8,6 +8,9 @@
 #include "../../../Memory/Memory_Main.h"
 #include "../../../Memory/Other_Utils.h"
 #include "../../../Paging/Paging_Main.h"
+#include "../../../FPU/FPU_Main.h"
+#include "../../../ProcessManager/ProcessManager.h"
+#include "../../../Trace/Trace_Main.h"
 #include "../../PCI/PCI_Main.h"
 
 #define VIRTIO_VENDOR_ID 0x1AF4
@@ -26,6 +29,7 @@
 #define VIRTIO_STATUS_FAILED      0x80
 
 #define VIRTIO_F_VERSION_1 (1u << 0)
+#define VIRTIO_FILL_ROWS_PER_BATCH 32
 
 #define VIRTQ_DESC_F_NEXT  1
 #define VIRTQ_DESC_F_WRITE 2
@@ -455,6 +459,7 @@ static int virtqueue_submit_sync(virtqueue_t *vq, void *cmd, uint32_t cmd_len, v
     if (vq->queue_size < 2) {
         return 0;
     }
+    TRACE(VIRTIO_SUBMIT, vq->queue_index, ((virtio_gpu_ctrl_hdr_t *)cmd)->type, cmd_len);
 
     vq->desc[0].addr = (uint64_t)(uintptr_t)cmd;
     vq->desc[0].len = cmd_len;
@@ -477,11 +482,13 @@ static int virtqueue_submit_sync(virtqueue_t *vq, void *cmd, uint32_t cmd_len, v
     uint32_t timeout = VIRTIO_MMIO_TIMEOUT;
     while ((uint16_t)(vq->used->idx - vq->used_idx_seen) == 0) {
         if (--timeout == 0) {
+            TRACE(VIRTIO_COMPLETE, vq->queue_index, 0, 0);
             return 0;
         }
     }
 
     vq->used_idx_seen = vq->used->idx;
+    TRACE(VIRTIO_COMPLETE, vq->queue_index, 1, 0);
     return 1;
 }
 
@@ -715,11 +722,26 @@ void virtio_gpu_fill_rect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32
         y_end = g_gpu_height;
     }
 
-    for (uint32_t py = y; py < y_end; ++py) {
-        uint64_t row = (uint64_t)py * g_gpu_width;
-        for (uint32_t px = x; px < x_end; ++px) {
-            g_gpu_fb[row + px] = color;
+    // Fill in row batches so the SIMD section keeps interrupts off only
+    // briefly and a long fill can yield between batches.
+    bool simd = kernel_fpu_usable();
+    for (uint32_t py = y; py < y_end; ) {
+        uint32_t batch_end = y_end - py > VIRTIO_FILL_ROWS_PER_BATCH ? py + VIRTIO_FILL_ROWS_PER_BATCH : y_end;
+        if (simd) {
+            kernel_fpu_begin();
+            for (; py < batch_end; ++py) {
+                simd_fill32(&g_gpu_fb[(uint64_t)py * g_gpu_width + x], color, x_end - x);
+            }
+            kernel_fpu_end();
+        } else {
+            for (; py < batch_end; ++py) {
+                uint64_t row = (uint64_t)py * g_gpu_width;
+                for (uint32_t px = x; px < x_end; ++px) {
+                    g_gpu_fb[row + px] = color;
+                }
+            }
         }
+        process_preempt_point();
     }
 }
 
@@ -1,5 +1,6 @@
 #include "FAT32_Main.h"
 #include "../../../Serial.h"
+#include "../../../ProcessManager/ProcessManager.h"
 #include <string.h>
 
 static FAT32_BPB bpb;
@@ -136,6 +137,7 @@ bool fat32_find_file(const char *filename, FAT32_FILE *file) {
         uint32_t next = fat_get_next_cluster(cluster);
         if (next < 2 || next >= 0x0FFFFFF8) break;
         cluster = next;
+        process_preempt_point();
     }
 
     return false;
@@ -221,27 +223,37 @@ bool fat32_read_file(FAT32_FILE *file, uint8_t *buffer) {
 
     uint32_t cluster = file->first_cluster;
     uint32_t bytes_left = file->size;
-    uint32_t cluster_size = bpb.sectors_per_cluster * bpb.bytes_per_sector;
-    uint8_t buf[cluster_size];
+    uint8_t buf[bpb.bytes_per_sector];
 
     while (bytes_left) {
         uint32_t lba = cluster_to_lba(cluster);
         if (!lba) return false;
-        
-        uint32_t n_read = bytes_left > cluster_size ? cluster_size : bytes_left;
-        
-        if (!disk_read(lba, buf, bpb.sectors_per_cluster)) {
+
+        // Whole sectors land straight in the caller's buffer; only the
+        // partial tail sector goes through the bounce buffer.
+        uint32_t full = bytes_left / bpb.bytes_per_sector;
+        if (full > bpb.sectors_per_cluster) full = bpb.sectors_per_cluster;
+        if (full && !disk_read(lba, buffer, full)) {
             serial_write_string("[OS] [FAT32] Disk read failed\n");
             return false;
         }
-        
-        memcpy(buffer, buf, n_read);
-        buffer += n_read;
-        bytes_left -= n_read;
+        buffer += full * bpb.bytes_per_sector;
+        bytes_left -= full * bpb.bytes_per_sector;
+
+        if (bytes_left && full < bpb.sectors_per_cluster) {
+            if (!disk_read(lba + full, buf, 1)) {
+                serial_write_string("[OS] [FAT32] Disk read failed\n");
+                return false;
+            }
+            memcpy(buffer, buf, bytes_left);
+            bytes_left = 0;
+        }
+        if (!bytes_left) break;
 
         uint32_t next = fat_get_next_cluster(cluster);
         if (next < 2 || next >= 0x0FFFFFF8) break;
         cluster = next;
+        process_preempt_point();
     }
 
     return bytes_left == 0;
@@ -278,6 +290,7 @@ bool fat32_write_file(FAT32_FILE *file, const uint8_t *buffer) {
         uint32_t next = fat_get_next_cluster(cluster);
         if (next < 2 || next >= 0x0FFFFFF8) break;
         cluster = next;
+        process_preempt_point();
     }
 
     return bytes_left == 0;
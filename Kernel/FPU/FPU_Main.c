@@ -0,0 +1,236 @@
+#include "FPU_Main.h"
+#include "../CPU/CPU_Main.h"
+#include "../Memory/Memory_Main.h"
+#include "../Sync/Sync_Main.h"
+#include "../Serial.h"
+#include <stddef.h>
+
+#define CPUID_1_ECX_XSAVE (1u << 26)
+#define CPUID_1_ECX_AVX   (1u << 28)
+#define CPUID_D1_EAX_XSAVEOPT (1u << 0)
+#define CPUID_D1_EAX_XSAVES   (1u << 3)
+
+#define CR0_MP (1ULL << 1)
+#define CR0_EM (1ULL << 2)
+#define CR0_TS (1ULL << 3)
+#define CR0_NE (1ULL << 5)
+#define CR4_OSFXSR     (1ULL << 9)
+#define CR4_OSXMMEXCPT (1ULL << 10)
+#define CR4_OSXSAVE    (1ULL << 18)
+
+#define XFEATURE_X87    (1ULL << 0)
+#define XFEATURE_SSE    (1ULL << 1)
+#define XFEATURE_AVX    (1ULL << 2)
+#define XFEATURE_AVX512 (7ULL << 5)
+#define XCOMP_BV_COMPACTED (1ULL << 63)
+
+#define IA32_XSS 0x00000DA0
+
+#define FPU_LEGACY_AREA_SIZE 512
+#define FPU_XSAVE_HEADER_OFFSET 512
+#define FPU_XSAVE_HEADER_SIZE 64
+#define FPU_DEFAULT_FCW   0x037F
+#define FPU_DEFAULT_MXCSR 0x1F80
+
+static uint32_t g_fpu_mode = FPU_MODE_FXSAVE;
+static uint64_t g_fpu_xcr0 = 0;
+static uint32_t g_fpu_state_size = FPU_LEGACY_AREA_SIZE;
+static uint32_t g_fpu_state_pages = 1;
+static uint32_t g_fpu_ready = 0;
+
+static inline uint64_t read_cr0(void) {
+    uint64_t value;
+    __asm__ volatile ("mov %%cr0, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr0(uint64_t value) {
+    __asm__ volatile ("mov %0, %%cr0" :: "r"(value) : "memory");
+}
+
+static inline uint64_t read_cr4(void) {
+    uint64_t value;
+    __asm__ volatile ("mov %%cr4, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr4(uint64_t value) {
+    __asm__ volatile ("mov %0, %%cr4" :: "r"(value) : "memory");
+}
+
+static inline void xsetbv(uint32_t index, uint64_t value) {
+    __asm__ volatile ("xsetbv" :: "c"(index), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+void fpu_init_cpu(void) {
+    write_cr0((read_cr0() & ~CR0_EM) | CR0_MP | CR0_NE);
+    uint64_t cr4 = read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT;
+    if (g_fpu_mode != FPU_MODE_FXSAVE) {
+        cr4 |= CR4_OSXSAVE;
+    }
+    write_cr4(cr4);
+
+    if (g_fpu_mode != FPU_MODE_FXSAVE) {
+        xsetbv(0, g_fpu_xcr0);
+    }
+    if (g_fpu_mode == FPU_MODE_XSAVES) {
+        wrmsr(IA32_XSS, 0);
+    }
+    __asm__ volatile ("fninit");
+    fpu_trap_next_use();
+}
+
+void fpu_init(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    uint32_t leaf1_ecx = ecx;
+
+    if (leaf1_ecx & CPUID_1_ECX_XSAVE) {
+        uint32_t supported_low, supported_high;
+        cpuid(0xD, 0, &supported_low, &ebx, &ecx, &supported_high);
+        uint64_t supported = ((uint64_t)supported_high << 32) | supported_low;
+
+        g_fpu_xcr0 = XFEATURE_X87 | XFEATURE_SSE;
+        if ((supported & XFEATURE_AVX) && (leaf1_ecx & CPUID_1_ECX_AVX)) {
+            g_fpu_xcr0 |= XFEATURE_AVX;
+            if ((supported & XFEATURE_AVX512) == XFEATURE_AVX512) {
+                g_fpu_xcr0 |= XFEATURE_AVX512;
+            }
+        }
+
+        cpuid(0xD, 1, &eax, &ebx, &ecx, &edx);
+        if (eax & CPUID_D1_EAX_XSAVES) {
+            g_fpu_mode = FPU_MODE_XSAVES;
+        } else if (eax & CPUID_D1_EAX_XSAVEOPT) {
+            g_fpu_mode = FPU_MODE_XSAVEOPT;
+        } else {
+            g_fpu_mode = FPU_MODE_XSAVE;
+        }
+    }
+
+    fpu_init_cpu();
+
+    if (g_fpu_mode != FPU_MODE_FXSAVE) {
+        cpuid(0xD, g_fpu_mode == FPU_MODE_XSAVES ? 1 : 0, &eax, &ebx, &ecx, &edx);
+        g_fpu_state_size = ebx;
+    }
+    g_fpu_state_pages = (g_fpu_state_size + 4095) / 4096;
+    g_fpu_ready = 1;
+
+    static const char *const mode_names[] = {"FXSAVE", "XSAVE", "XSAVEOPT", "XSAVES"};
+    serial_write_string("[OS] [FPU] Using ");
+    serial_write_string(mode_names[g_fpu_mode]);
+    serial_write_string(", XCR0=");
+    serial_write_uint64(g_fpu_xcr0);
+    serial_write_string(", area ");
+    serial_write_uint32(g_fpu_state_size);
+    serial_write_string(" bytes\n");
+}
+
+uint32_t fpu_mode(void) {
+    return g_fpu_mode;
+}
+
+uint32_t fpu_state_size(void) {
+    return g_fpu_state_size;
+}
+
+uint8_t *fpu_state_alloc(void) {
+    uint8_t *state = (uint8_t *)alloc_pages(g_fpu_state_pages);
+    if (state == NULL) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < FPU_LEGACY_AREA_SIZE + FPU_XSAVE_HEADER_SIZE; ++i) {
+        state[i] = 0;
+    }
+    *(uint16_t *)(state + 0) = FPU_DEFAULT_FCW;
+    *(uint32_t *)(state + 24) = FPU_DEFAULT_MXCSR;
+    if (g_fpu_mode == FPU_MODE_XSAVES) {
+        *(uint64_t *)(state + FPU_XSAVE_HEADER_OFFSET + 8) = XCOMP_BV_COMPACTED | g_fpu_xcr0;
+    }
+    return state;
+}
+
+void fpu_state_free(uint8_t *state) {
+    if (state != NULL) {
+        free_pages(state, g_fpu_state_pages);
+    }
+}
+
+void fpu_save(uint8_t *state) {
+    uint32_t low = (uint32_t)g_fpu_xcr0;
+    uint32_t high = (uint32_t)(g_fpu_xcr0 >> 32);
+    switch (g_fpu_mode) {
+    case FPU_MODE_XSAVES:
+        __asm__ volatile ("xsaves64 (%0)" :: "r"(state), "a"(low), "d"(high) : "memory");
+        break;
+    case FPU_MODE_XSAVEOPT:
+        __asm__ volatile ("xsaveopt64 (%0)" :: "r"(state), "a"(low), "d"(high) : "memory");
+        break;
+    case FPU_MODE_XSAVE:
+        __asm__ volatile ("xsave64 (%0)" :: "r"(state), "a"(low), "d"(high) : "memory");
+        break;
+    default:
+        __asm__ volatile ("fxsave64 (%0)" :: "r"(state) : "memory");
+        break;
+    }
+}
+
+void fpu_restore(uint8_t *state) {
+    uint32_t low = (uint32_t)g_fpu_xcr0;
+    uint32_t high = (uint32_t)(g_fpu_xcr0 >> 32);
+    switch (g_fpu_mode) {
+    case FPU_MODE_XSAVES:
+        __asm__ volatile ("xrstors64 (%0)" :: "r"(state), "a"(low), "d"(high) : "memory");
+        break;
+    case FPU_MODE_XSAVEOPT:
+    case FPU_MODE_XSAVE:
+        __asm__ volatile ("xrstor64 (%0)" :: "r"(state), "a"(low), "d"(high) : "memory");
+        break;
+    default:
+        __asm__ volatile ("fxrstor64 (%0)" :: "r"(state) : "memory");
+        break;
+    }
+}
+
+void fpu_trap_next_use(void) {
+    uint64_t cr0 = read_cr0();
+    if (!(cr0 & CR0_TS)) {
+        write_cr0(cr0 | CR0_TS);
+    }
+}
+
+void fpu_clear_trap(void) {
+    __asm__ volatile ("clts" ::: "memory");
+}
+
+bool kernel_fpu_usable(void) {
+#ifdef KERNEL_NO_SIMD
+    return false;
+#else
+    return g_fpu_ready != 0;
+#endif
+}
+
+void kernel_fpu_begin(void) {
+    uint64_t flags = irq_save_disable();
+    cpu_local_t *cpu = cpu_current();
+    if (cpu->fpu_kernel_depth++ != 0) {
+        return;
+    }
+    cpu->fpu_irq_flags = flags;
+    fpu_clear_trap();
+    if (cpu->fpu_owner != NULL) {
+        fpu_save(cpu->fpu_owner);
+        cpu->fpu_owner = NULL;
+    }
+}
+
+void kernel_fpu_end(void) {
+    cpu_local_t *cpu = cpu_current();
+    if (--cpu->fpu_kernel_depth != 0) {
+        return;
+    }
+    fpu_trap_next_use();
+    irq_restore(cpu->fpu_irq_flags);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FPU_MODE_FXSAVE   0
+#define FPU_MODE_XSAVE    1
+#define FPU_MODE_XSAVEOPT 2
+#define FPU_MODE_XSAVES   3
+
+void fpu_init(void);
+void fpu_init_cpu(void);
+uint32_t fpu_mode(void);
+uint32_t fpu_state_size(void);
+
+uint8_t *fpu_state_alloc(void);
+void fpu_state_free(uint8_t *state);
+void fpu_save(uint8_t *state);
+void fpu_restore(uint8_t *state);
+
+void fpu_trap_next_use(void);
+void fpu_clear_trap(void);
+
+bool kernel_fpu_usable(void);
+void kernel_fpu_begin(void);
+void kernel_fpu_end(void);
+
+void simd_memcpy(void *dst, const void *src, size_t n);
+void simd_fill32(uint32_t *dst, uint32_t value, size_t count);
@@ -0,0 +1,96 @@
+#include "FPU_Main.h"
+
+#define SIMD_STREAM_THRESHOLD (256 * 1024)
+
+typedef uint32_t simd_u32x4_t __attribute__((vector_size(16)));
+
+__attribute__((target("sse2")))
+void simd_memcpy(void *dst, const void *src, size_t n) {
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+
+    while (n != 0 && ((uintptr_t)d & 15) != 0) {
+        *d++ = *s++;
+        n--;
+    }
+
+    int stream = n >= SIMD_STREAM_THRESHOLD;
+    while (n >= 64) {
+        if (stream) {
+            __asm__ volatile (
+                "movdqu 0(%1), %%xmm0\n\t"
+                "movdqu 16(%1), %%xmm1\n\t"
+                "movdqu 32(%1), %%xmm2\n\t"
+                "movdqu 48(%1), %%xmm3\n\t"
+                "movntdq %%xmm0, 0(%0)\n\t"
+                "movntdq %%xmm1, 16(%0)\n\t"
+                "movntdq %%xmm2, 32(%0)\n\t"
+                "movntdq %%xmm3, 48(%0)"
+                :: "r"(d), "r"(s) : "xmm0", "xmm1", "xmm2", "xmm3", "memory");
+        } else {
+            __asm__ volatile (
+                "movdqu 0(%1), %%xmm0\n\t"
+                "movdqu 16(%1), %%xmm1\n\t"
+                "movdqu 32(%1), %%xmm2\n\t"
+                "movdqu 48(%1), %%xmm3\n\t"
+                "movdqa %%xmm0, 0(%0)\n\t"
+                "movdqa %%xmm1, 16(%0)\n\t"
+                "movdqa %%xmm2, 32(%0)\n\t"
+                "movdqa %%xmm3, 48(%0)"
+                :: "r"(d), "r"(s) : "xmm0", "xmm1", "xmm2", "xmm3", "memory");
+        }
+        d += 64;
+        s += 64;
+        n -= 64;
+    }
+    if (stream) {
+        __asm__ volatile ("sfence" ::: "memory");
+    }
+
+    while (n != 0) {
+        *d++ = *s++;
+        n--;
+    }
+}
+
+__attribute__((target("sse2")))
+void simd_fill32(uint32_t *dst, uint32_t value, size_t count) {
+    while (count != 0 && ((uintptr_t)dst & 15) != 0) {
+        *dst++ = value;
+        count--;
+    }
+
+    simd_u32x4_t fill;
+    __asm__ ("movd %1, %0\n\t"
+             "pshufd $0, %0, %0"
+             : "=x"(fill) : "r"(value));
+
+    int stream = count * sizeof(uint32_t) >= SIMD_STREAM_THRESHOLD;
+    while (count >= 16) {
+        if (stream) {
+            __asm__ volatile (
+                "movntdq %1, 0(%0)\n\t"
+                "movntdq %1, 16(%0)\n\t"
+                "movntdq %1, 32(%0)\n\t"
+                "movntdq %1, 48(%0)"
+                :: "r"(dst), "x"(fill) : "memory");
+        } else {
+            __asm__ volatile (
+                "movdqa %1, 0(%0)\n\t"
+                "movdqa %1, 16(%0)\n\t"
+                "movdqa %1, 32(%0)\n\t"
+                "movdqa %1, 48(%0)"
+                :: "r"(dst), "x"(fill) : "memory");
+        }
+        dst += 16;
+        count -= 16;
+    }
+    if (stream) {
+        __asm__ volatile ("sfence" ::: "memory");
+    }
+
+    while (count != 0) {
+        *dst++ = value;
+        count--;
+    }
+}
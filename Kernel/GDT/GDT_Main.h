@@ -46,3 +46,5 @@ struct __attribute__((packed)) TSS {
 };
 
 void init_gdt(void);
+void gdt_init_cpu(uint32_t cpu_index, uint64_t kernel_stack_top);
+void gdt_set_kernel_stack(uint32_t cpu_index, uint64_t kernel_stack_top);
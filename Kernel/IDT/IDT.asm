@@ -3,8 +3,15 @@ BITS 64
 global load_idt
 global isr_default
 global isr_page_fault
+global isr_device_not_available
+global isr_irq_stub_table
 
 extern page_fault_handler
+extern irq_handler
+extern process_check_resched
+
+%define IRQ_STUB_FIRST 32
+%define IRQ_STUB_COUNT 224
 
 SECTION .data
 
@@ -95,10 +102,91 @@ isr_page_fault:
 
     iretq
 
+isr_device_not_available:
+    push 7
+    jmp isr_irq_common
+
+%macro IRQ_STUB 1
+isr_irq_%1:
+    push %1
+    jmp isr_irq_common
+%endmacro
+
+%assign vector IRQ_STUB_FIRST
+%rep IRQ_STUB_COUNT
+IRQ_STUB vector
+%assign vector vector + 1
+%endrep
+
+isr_irq_common:
+    test qword [rsp + 16], 3
+    jz .from_kernel
+    swapgs
+.from_kernel:
+    push rax
+    push rbx
+    push rcx
+    push rdx
+    push rsi
+    push rdi
+    push rbp
+    push r8
+    push r9
+    push r10
+    push r11
+    push r12
+    push r13
+    push r14
+    push r15
+
+    mov rdi, [rsp + 15 * 8]
+    cld
+    sub rsp, 8
+    call irq_handler
+    add rsp, 8
+
+    test qword [rsp + 17 * 8], 3
+    jz .no_resched
+    sub rsp, 8
+    call process_check_resched
+    add rsp, 8
+.no_resched:
+    pop r15
+    pop r14
+    pop r13
+    pop r12
+    pop r11
+    pop r10
+    pop r9
+    pop r8
+    pop rbp
+    pop rdi
+    pop rsi
+    pop rdx
+    pop rcx
+    pop rbx
+    pop rax
+
+    test qword [rsp + 16], 3
+    jz .to_kernel
+    swapgs
+.to_kernel:
+    add rsp, 8
+    iretq
+
 load_idt:
     cli
     lidt [rdi]
     sti
     ret
 
+SECTION .rodata
+align 8
+isr_irq_stub_table:
+%assign vector IRQ_STUB_FIRST
+%rep IRQ_STUB_COUNT
+    dq isr_irq_%+vector
+%assign vector vector + 1
+%endrep
+
 section .note.GNU-stack noalloc noexec nowrite progbits
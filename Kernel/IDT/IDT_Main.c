@@ -1,5 +1,7 @@
 #include "IDT_Main.h"
 #include "../IO/IO_Main.h"
+#include "../APIC/APIC_Main.h"
+#include "../CPU/CPU_Main.h"
 #include "../Serial.h"
 
 #define MAX_IRQS 256
@@ -10,15 +12,23 @@ static isr_t irq_routines[MAX_IRQS] = {0};
 
 extern void isr_default(void);
 extern void isr_page_fault(void);
+extern void isr_device_not_available(void);
 extern void load_idt(IDT_Ptr* idt_ptr);
+extern const uint64_t isr_irq_stub_table[];
 
 void register_interrupt_handler(uint16_t irq, isr_t handler) {
     if (irq < MAX_IRQS) {
         irq_routines[irq] = handler;
+        if (irq >= IRQ_STUB_FIRST) {
+            set_interrupt_handler(irq, (void (*)(void))isr_irq_stub_table[irq - IRQ_STUB_FIRST]);
+        } else if (irq == IDT_VECTOR_DEVICE_NOT_AVAILABLE) {
+            set_interrupt_handler(irq, isr_device_not_available);
+        }
     }
 }
 
 void irq_handler(uint16_t irq_num) {
+    cpu_current()->interrupts++;
     if (irq_num < MAX_IRQS && irq_routines[irq_num]) {
         irq_routines[irq_num]();
     }
@@ -28,6 +38,8 @@ void irq_handler(uint16_t irq_num) {
         if (irq_num >= 40) {
             outb(0xA0, 0x20);
         }
+    } else if (irq_num >= 48 && irq_num != APIC_VECTOR_SPURIOUS) {
+        apic_eoi();
     }
 }
 
@@ -60,7 +72,12 @@ void init_idt(void) {
     serial_write_string("[OS] [IDT] Successfully Initialize IDT.\n");
 }
 
+void idt_load_cpu(void) {
+    load_idt(&idt_ptr);
+}
+
 void page_fault_handler(uint64_t error_code, uint64_t rip, uint64_t rsp, uint64_t cr2) {
+    serial_panic_flush();
     serial_write_string("[OS] [PF] Page fault\n");
     serial_write_string("[OS] [PF] CR2: ");
     serial_write_uint64(cr2);
@@ -4,6 +4,8 @@
 #include <stdint.h>
 
 #define IDT_ENTRIES 256
+#define IRQ_STUB_FIRST 32
+#define IDT_VECTOR_DEVICE_NOT_AVAILABLE 7
 
 typedef struct {
     uint16_t offset_low;
@@ -23,6 +25,7 @@ typedef void(*isr_t)(void);
 
 void register_interrupt_handler(uint16_t irq, isr_t handler);
 void init_idt(void);
+void idt_load_cpu(void);
 void set_interrupt_handler(uint16_t n, void (*handler)(void));
 
 extern void load_idt(IDT_Ptr*);
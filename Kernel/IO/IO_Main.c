@@ -1,6 +1,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "../Serial.h"
+#include "../ProcessManager/ProcessManager.h"
+#include "../Trace/Trace_Main.h"
 
 #define ATA_DATA     0x1F0
 #define ATA_SECCOUNT 0x1F2
@@ -52,10 +54,11 @@ static inline void insw(uint16_t port, void* addr, int count){
 }
 
 
-bool disk_read(uint32_t lba, uint8_t *buffer, uint32_t sectors){
+static bool disk_read_sectors(uint32_t lba, uint8_t *buffer, uint32_t sectors){
     if (sectors == 0) return false;
 
     for (uint32_t s = 0; s < sectors; s++) {
+        process_preempt_point();
         uint32_t real_lba = FAT32_START_LBA + lba + s;
 
         outb(ATA_HDDEVSEL, 0xE0 | ((real_lba >> 24) & 0x0F));
@@ -71,6 +74,7 @@ bool disk_read(uint32_t lba, uint8_t *buffer, uint32_t sectors){
                 serial_write_string("[OS] [IO] Timeout waiting for BSY clear\n");
                 return false;
             }
+            process_preempt_point();
         }
 
         timeout = 10000000;
@@ -95,10 +99,11 @@ bool disk_read(uint32_t lba, uint8_t *buffer, uint32_t sectors){
     return true;
 }
 
-bool disk_write(uint32_t lba, const uint8_t *buffer, uint32_t sectors){
+static bool disk_write_sectors(uint32_t lba, const uint8_t *buffer, uint32_t sectors){
     if (sectors == 0) return false;
 
     for (uint32_t s = 0; s < sectors; s++) {
+        process_preempt_point();
         uint32_t real_lba = FAT32_START_LBA + lba + s;
 
         outb(ATA_HDDEVSEL, 0xE0 | ((real_lba >> 24) & 0x0F));
@@ -111,6 +116,7 @@ bool disk_write(uint32_t lba, const uint8_t *buffer, uint32_t sectors){
         uint32_t timeout = 10000000;
         while(inb(ATA_STATUS) & ATA_SR_BSY) {
             if (--timeout == 0) return false;
+            process_preempt_point();
         }
 
         timeout = 10000000;
@@ -124,6 +130,20 @@ bool disk_write(uint32_t lba, const uint8_t *buffer, uint32_t sectors){
     return true;
 }
 
+bool disk_read(uint32_t lba, uint8_t *buffer, uint32_t sectors){
+    TRACE(DISK_BEGIN, 0, lba, sectors);
+    bool ok = disk_read_sectors(lba, buffer, sectors);
+    TRACE(DISK_END, 0, lba, ok);
+    return ok;
+}
+
+bool disk_write(uint32_t lba, const uint8_t *buffer, uint32_t sectors){
+    TRACE(DISK_BEGIN, 1, lba, sectors);
+    bool ok = disk_write_sectors(lba, buffer, sectors);
+    TRACE(DISK_END, 1, lba, ok);
+    return ok;
+}
+
 void outl(uint16_t port, uint32_t val) {
     __asm__ volatile ("outl %0, %1" : : "a"(val), "Nd"(port));
 }
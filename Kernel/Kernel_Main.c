@@ -3,17 +3,24 @@
 #include "Paging/Paging_Main.h"
 #include "IDT/IDT_Main.h"
 #include "GDT/GDT_Main.h"
-#include "IO/IO_Main.h"
 #include "Drivers/FileSystem/FAT32/FAT32_Main.h"
 #include "Drivers/Display/Display_Main.h"
 #include "Memory/Other_Utils.h"
 #include "Syscall/Syscall_Main.h"
 #include "Syscall/Syscall_File.h"
+#include "Syscall/Syscall_Ring.h"
+#include "Syscall/Syscall_Memory.h"
 #include "ProcessManager/ProcessManager.h"
+#include "CPU/CPU_Main.h"
+#include "FPU/FPU_Main.h"
+#include "ACPI/ACPI_Main.h"
+#include "APIC/APIC_Main.h"
+#include "SMP/SMP_Main.h"
+#include "Timer/Timer_Main.h"
+#include "WorkQueue/WorkQueue_Main.h"
+#include "Trace/Trace_Main.h"
 #include "Serial.h"
 
-#define COM1_PORT 0x3F8
-
 #define GDT_KERNEL_CODE 0x08
 #define GDT_KERNEL_DATA 0x10
 #define GDT_USER_COMPAT_CODE 0x18
@@ -56,46 +63,6 @@ typedef struct {
 } Elf64_Phdr;
 
 static uint64_t user_entry = 0;
-
-void serial_init(void) {
-    outb(COM1_PORT + 1, 0x00);
-    outb(COM1_PORT + 3, 0x80);
-    outb(COM1_PORT + 0, 0x03);
-    outb(COM1_PORT + 1, 0x00);
-    outb(COM1_PORT + 3, 0x03);
-    outb(COM1_PORT + 2, 0xC7);
-    outb(COM1_PORT + 4, 0x0B);
-}
-
-void serial_write_char(char c) {
-    while ((inb(COM1_PORT + 5) & 0x20) == 0);
-    outb(COM1_PORT, c);
-}
-
-void serial_write_string(const char* str) {
-    while (*str) {
-        if (*str == '\n')
-            serial_write_char('\r');
-        serial_write_char(*str++);
-    }
-}
-
-void serial_write_uint64(uint64_t value) {
-    char hex[] = "0123456789ABCDEF";
-    serial_write_string("0x");
-    for (int i = 60; i >= 0; i -= 4) {
-        serial_write_char(hex[(value >> i) & 0xF]);
-    }
-}
-
-void serial_write_uint32(uint32_t value) {
-    serial_write_uint64((uint64_t)value);
-}
-
-void serial_write_uint16(uint16_t value) {
-    serial_write_uint64((uint64_t)value);
-}
-
 void all_fs_initialize() {
     fat32_init();
 }
@@ -188,47 +155,6 @@ static bool load_userland_elf(uint64_t *entry_out) {
     return true;
 }
 
-__attribute__((noreturn))
-void entry_user_mode() {
-    serial_write_string("[OS] Entering user mode...\n");
-    serial_write_string("[OS] User entry: ");
-    serial_write_uint64(user_entry);
-    serial_write_string("\n");
-
-    uint64_t user_rip = user_entry;
-    uint64_t user_rsp = ((uint64_t)user_stack + USER_STACK_SIZE) & ~0xFULL;
-    uint64_t rflags   = 0x202;
-
-    uint64_t user_ss = GDT_USER_DATA | 3;
-    uint64_t user_cs = GDT_USER_CODE | 3;
-
-    __asm__ volatile (
-        "cli\n"
-
-        "mov %0, %%ax\n"
-        "mov %%ax, %%ds\n"
-        "mov %%ax, %%es\n"
-        "mov %%ax, %%fs\n"
-        "mov %%ax, %%gs\n"
-
-        "pushq %1\n"
-        "pushq %2\n"
-        "pushq %3\n"
-        "pushq %4\n"
-        "pushq %5\n"
-        "iretq\n"
-        :
-        : "r"((uint16_t)(user_ss)),
-          "r"(user_ss),
-          "r"(user_rsp),
-          "r"(rflags),
-          "r"(user_cs),
-          "r"(user_rip)
-        : "rax", "memory"
-    );
-    __builtin_unreachable();
-}
-
 __attribute__((noreturn))
 void kernel_main(BOOT_INFO *boot_info) {
     serial_init();
@@ -253,26 +179,47 @@ void kernel_main(BOOT_INFO *boot_info) {
     serial_write_string("[OS] Initializing GDT...\n");
     init_gdt();
 
+    serial_write_string("[OS] Initializing per-CPU state...\n");
+    cpu_init_bsp();
+    fpu_init();
+    trace_init();
+
     serial_write_string("[OS] Initializing display...\n");
     if (!display_init()) {
         serial_write_string("[OS] [WARN] Display init failed\n");
     }
     
+    serial_write_string("[OS] Initializing ACPI and local APIC...\n");
+    if (acpi_init(boot_info->AcpiRsdp)) {
+        apic_init(acpi_get_madt_info()->lapic_address);
+        timer_init();
+        serial_init_irq(apic_id());
+    } else {
+        serial_write_string("[OS] [WARN] ACPI unavailable, running on the boot CPU only\n");
+    }
+
     serial_write_string("[OS] Initializing syscall...\n");
     syscall_init(); 
 
     serial_write_string("[OS] Initializing process manager...\n");
     process_manager_init();
+    register_interrupt_handler(IDT_VECTOR_DEVICE_NOT_AVAILABLE, process_fpu_trap);
+
+    serial_write_string("[OS] Initializing work queues...\n");
+    workqueue_init();
 
     serial_write_string("[OS] Initializing file system...\n");
     all_fs_initialize();
 
     syscall_file_init();
+    syscall_ring_init();
+    syscall_memory_init();
 
     serial_write_string("[OS] Loading userland ELF...\n");
     if (!load_userland_elf(&user_entry)) {
         serial_write_string("[OS] [ERROR] Failed to load userland ELF\n");
         serial_write_string("[OS] [ERROR] System halted\n");
+        serial_panic_flush();
         while (1) {
             __asm__("hlt");
         }
@@ -283,11 +230,13 @@ void kernel_main(BOOT_INFO *boot_info) {
 
     if (process_register_boot_process(user_entry, (uint64_t)user_stack + USER_STACK_SIZE) < 0) {
         serial_write_string("[OS] [ERROR] Failed to register boot process\n");
+        serial_panic_flush();
         while (1) {
             __asm__("hlt");
         }
     }
-    
-    entry_user_mode();
-    __builtin_unreachable();
+
+    smp_start_aps();
+
+    process_idle_loop();
 }
@@ -1,6 +1,8 @@
 #include "Memory_Main.h"
 #include "../Serial.h"
 #include "../Kernel_Main.h"
+#include "../Sync/Sync_Main.h"
+#include "../Trace/Trace_Main.h"
 #include <stddef.h>
 #include <stdint.h>
 
@@ -34,37 +36,13 @@ static uint32_t total_freed = 0;
 #define HEAP_PAGE_COUNT 4096
 
 static uint32_t heap_start_page = 0;
-static volatile uint32_t heap_lock = 0;
-static volatile uint32_t page_lock = 0;
+static spinlock_t heap_lock = SPINLOCK_INIT;
+static spinlock_t page_lock = SPINLOCK_INIT;
 static uint32_t page_alloc_hint = 0;
 
 #define MIN_ALLOC_ALIGN 8u
 #define MIN_SPLIT_REMAINDER 64u
 
-static inline uint64_t irq_save_disable(void) {
-    uint64_t flags;
-    __asm__ volatile ("pushfq; popq %0; cli" : "=r"(flags) :: "memory");
-    return flags;
-}
-
-static inline void irq_restore(uint64_t flags) {
-    if (flags & (1ull << 9)) {
-        __asm__ volatile ("sti" ::: "memory");
-    }
-}
-
-static inline void spin_lock(volatile uint32_t *lock) {
-    while (__sync_lock_test_and_set(lock, 1) != 0) {
-        while (*lock != 0) {
-            __asm__ volatile ("pause");
-        }
-    }
-}
-
-static inline void spin_unlock(volatile uint32_t *lock) {
-    __sync_lock_release(lock);
-}
-
 static inline uint32_t align_up(uint32_t value, uint32_t align) {
     return (value + align - 1u) & ~(align - 1u);
 }
@@ -220,11 +198,12 @@ void* kmalloc(uint32_t size) {
     size = align_up(size, MIN_ALLOC_ALIGN);
 
     uint64_t irq_flags = irq_save_disable();
-    spin_lock(&heap_lock);
+    spinlock_acquire(&heap_lock);
     void *ptr = kmalloc_locked(size);
-    spin_unlock(&heap_lock);
+    spinlock_release(&heap_lock);
     irq_restore(irq_flags);
     if (ptr != NULL) {
+        TRACE(KMALLOC, size, ptr, 0);
         return ptr;
     }
     
@@ -236,6 +215,7 @@ void* kmalloc(uint32_t size) {
 
 void kfree(void* ptr) {
     if (ptr == NULL) return;
+    TRACE(KFREE, 0, ptr, 0);
     
     if (!heap_initialized || heap_start == NULL) {
         serial_write_string("[OS] [Memory] kfree: Heap not initialized\n");
@@ -252,18 +232,18 @@ void kfree(void* ptr) {
     }
 
     uint64_t irq_flags = irq_save_disable();
-    spin_lock(&heap_lock);
+    spinlock_acquire(&heap_lock);
     memory_block_t* prev = NULL;
     memory_block_t* block = find_block_by_payload(ptr, &prev);
     if (block == NULL) {
-        spin_unlock(&heap_lock);
+        spinlock_release(&heap_lock);
         irq_restore(irq_flags);
         serial_write_string("[OS] [Memory] kfree: Pointer not tracked\n");
         return;
     }
 
     if (block->is_free) {
-        spin_unlock(&heap_lock);
+        spinlock_release(&heap_lock);
         irq_restore(irq_flags);
         serial_write_string("[OS] [Memory] kfree: Double free detected\n");
         return;
@@ -284,7 +264,7 @@ void kfree(void* ptr) {
     }
 
     heap_search_hint = block;
-    spin_unlock(&heap_lock);
+    spinlock_release(&heap_lock);
     irq_restore(irq_flags);
 }
 
@@ -320,10 +300,10 @@ void* krealloc(void* ptr, uint32_t new_size) {
 
     uint32_t old_size = 0;
     uint64_t irq_flags = irq_save_disable();
-    spin_lock(&heap_lock);
+    spinlock_acquire(&heap_lock);
     memory_block_t* block = find_block_by_payload(ptr, NULL);
     if (block == NULL || block->is_free) {
-        spin_unlock(&heap_lock);
+        spinlock_release(&heap_lock);
         irq_restore(irq_flags);
         serial_write_string("[OS] [Memory] krealloc: Invalid pointer\n");
         return NULL;
@@ -332,7 +312,7 @@ void* krealloc(void* ptr, uint32_t new_size) {
 
     if (new_size <= old_size) {
         split_block_if_needed(block, new_size);
-        spin_unlock(&heap_lock);
+        spinlock_release(&heap_lock);
         irq_restore(irq_flags);
         return ptr;
     }
@@ -343,11 +323,11 @@ void* krealloc(void* ptr, uint32_t new_size) {
         block->size += sizeof(memory_block_t) + block->next->size;
         block->next = block->next->next;
         split_block_if_needed(block, new_size);
-        spin_unlock(&heap_lock);
+        spinlock_release(&heap_lock);
         irq_restore(irq_flags);
         return ptr;
     }
-    spin_unlock(&heap_lock);
+    spinlock_release(&heap_lock);
     irq_restore(irq_flags);
     
     void* new_ptr = kmalloc(new_size);
@@ -370,7 +350,7 @@ uint32_t get_free_memory(void) {
     if (!heap_initialized) return 0;
     
     uint64_t irq_flags = irq_save_disable();
-    spin_lock(&heap_lock);
+    spinlock_acquire(&heap_lock);
     uint32_t free_memory = 0;
     memory_block_t* current = heap_start;
     
@@ -380,16 +360,16 @@ uint32_t get_free_memory(void) {
         }
         current = current->next;
     }
-    spin_unlock(&heap_lock);
+    spinlock_release(&heap_lock);
     irq_restore(irq_flags);
     return free_memory;
 }
 
 uint32_t get_used_memory(void) {
     uint64_t irq_flags = irq_save_disable();
-    spin_lock(&heap_lock);
+    spinlock_acquire(&heap_lock);
     uint32_t used = total_allocated - total_freed;
-    spin_unlock(&heap_lock);
+    spinlock_release(&heap_lock);
     irq_restore(irq_flags);
     return used;
 }
@@ -401,7 +381,7 @@ void debug_print_memory_info(void) {
     }
     
     uint64_t irq_flags = irq_save_disable();
-    spin_lock(&heap_lock);
+    spinlock_acquire(&heap_lock);
     memory_block_t* current = heap_start;
     int block_count = 0;
     uint32_t free_blocks = 0;
@@ -424,40 +404,82 @@ void debug_print_memory_info(void) {
     serial_write_string(", Used: ");
     serial_write_uint32(used_blocks);
     serial_write_string(")\n");
-    spin_unlock(&heap_lock);
+    spinlock_release(&heap_lock);
     irq_restore(irq_flags);
 }
 
 void* alloc_page(void) {
     uint64_t irq_flags = irq_save_disable();
-    spin_lock(&page_lock);
+    spinlock_acquire(&page_lock);
     for (size_t offset = 0; offset < MAX_PAGES; offset++) {
         size_t i = (page_alloc_hint + offset) % MAX_PAGES;
         if (page_bitmap[i] == 0) {
             page_bitmap[i] = 1;
             page_alloc_hint = (uint32_t)((i + 1) % MAX_PAGES);
-            spin_unlock(&page_lock);
+            spinlock_release(&page_lock);
             irq_restore(irq_flags);
             return (void*)(i * PAGE_SIZE);
         }
     }
-    spin_unlock(&page_lock);
+    spinlock_release(&page_lock);
     irq_restore(irq_flags);
     return NULL;
 }
 
+void* alloc_pages(uint32_t count) {
+    if (count == 0) return NULL;
+    if (count == 1) return alloc_page();
+
+    uint64_t irq_flags = irq_save_disable();
+    spinlock_acquire(&page_lock);
+    size_t run_start = 0;
+    uint32_t run_length = 0;
+    for (size_t i = page_alloc_hint; i < MAX_PAGES; i++) {
+        if (page_bitmap[i] != 0) {
+            run_length = 0;
+            continue;
+        }
+        if (run_length == 0) {
+            run_start = i;
+        }
+        if (++run_length == count) {
+            mark_pages(run_start, count, 1);
+            spinlock_release(&page_lock);
+            irq_restore(irq_flags);
+            return (void*)(run_start * PAGE_SIZE);
+        }
+    }
+    spinlock_release(&page_lock);
+    irq_restore(irq_flags);
+    return NULL;
+}
+
+void free_pages(void* addr, uint32_t count) {
+    if (addr == NULL || count == 0) return;
+
+    uintptr_t page_num = (uintptr_t)addr / PAGE_SIZE;
+    uint64_t irq_flags = irq_save_disable();
+    spinlock_acquire(&page_lock);
+    mark_pages(page_num, count, 0);
+    if (page_num < page_alloc_hint) {
+        page_alloc_hint = (uint32_t)page_num;
+    }
+    spinlock_release(&page_lock);
+    irq_restore(irq_flags);
+}
+
 void free_page(void* addr) {
     if (addr == NULL) return;
 
     uintptr_t page_num = (uintptr_t)addr / PAGE_SIZE;
     uint64_t irq_flags = irq_save_disable();
-    spin_lock(&page_lock);
+    spinlock_acquire(&page_lock);
     if (page_num < MAX_PAGES) {
         page_bitmap[page_num] = 0;
         if (page_num < page_alloc_hint) {
             page_alloc_hint = (uint32_t)page_num;
         }
     }
-    spin_unlock(&page_lock);
+    spinlock_release(&page_lock);
     irq_restore(irq_flags);
 }
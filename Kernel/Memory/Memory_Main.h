@@ -14,6 +14,8 @@ void init_physical_memory(void *memory_map, size_t map_size, size_t desc_size);
 
 void* alloc_page(void);
 void free_page(void* addr);
+void* alloc_pages(uint32_t count);
+void free_pages(void* addr, uint32_t count);
 
 uint32_t get_free_memory(void);
 uint32_t get_used_memory(void);
@@ -1,6 +1,10 @@
 #include <stddef.h>
 #include <stdint.h>
 #include "Memory_Main.h"
+#include "../FPU/FPU_Main.h"
+
+#define MEMCPY_SIMD_THRESHOLD 512
+#define MEMCPY_SIMD_CHUNK (256 * 1024)
 
 void* malloc(size_t size) {
     if (size > UINT32_MAX) return NULL;
@@ -12,6 +16,21 @@ void free(void* ptr) {
 }
 
 void* memcpy(void* dst, const void* src, size_t n) {
+    if (n >= MEMCPY_SIMD_THRESHOLD && kernel_fpu_usable()) {
+        // kernel_fpu_begin masks interrupts; reopen the window every chunk.
+        uint8_t* d = dst;
+        const uint8_t* s = src;
+        while (n != 0) {
+            size_t chunk = n > MEMCPY_SIMD_CHUNK ? MEMCPY_SIMD_CHUNK : n;
+            kernel_fpu_begin();
+            simd_memcpy(d, s, chunk);
+            kernel_fpu_end();
+            d += chunk;
+            s += chunk;
+            n -= chunk;
+        }
+        return dst;
+    }
     uint8_t* d = dst;
     const uint8_t* s = src;
     for(size_t i=0;i<n;i++) d[i]=s[i];
@@ -53,17 +72,4 @@ long strtol(const char *nptr, char **endptr, int base){
     return val;
 }
 
-double pow(double x, double y){
-    double r = 1;
-    int yi = (int)y;
-    for(int i=0;i<yi;i++) r*=x;
-    return r;
-}
-
-double ldexp(double x, int exp){
-    while(exp>0){ x*=2; exp--; }
-    while(exp<0){ x/=2; exp++; }
-    return x;
-}
-
 int abs(int x){ return x<0?-x:x; }
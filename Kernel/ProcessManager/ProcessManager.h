@@ -1,12 +1,145 @@
 #pragma once
 
 #include <stdint.h>
+#include "../Sync/Sync_Main.h"
+
+struct process;
+
+#define PROCESS_POLICY_NORMAL   0
+#define PROCESS_POLICY_FIFO     1
+#define PROCESS_POLICY_RR       2
+#define PROCESS_POLICY_DEADLINE 3
+#define PROCESS_RT_PRIORITY_MAX 32
+
+typedef struct wait_queue {
+    spinlock_t lock;
+    struct process *head;
+    struct process *tail;
+} wait_queue_t;
+
+typedef struct sleep_lock {
+    wait_queue_t waiters;
+    volatile uint32_t held;
+} sleep_lock_t;
+
+typedef struct {
+    int32_t pid;
+    int32_t tgid;
+    int32_t parent_pid;
+    uint8_t state;
+    uint8_t cpu;
+    uint8_t kernel;
+    int8_t nice;
+    uint64_t user_ns;
+    uint64_t system_ns;
+    uint64_t wait_ns;
+    uint64_t voluntary_switches;
+    uint64_t involuntary_switches;
+    uint64_t syscalls;
+} process_info_t;
+
+#define POLL_IN  0x001
+#define POLL_OUT 0x004
+#define POLL_ERR 0x008
+#define POLL_HUP 0x010
+
+#define POLL_EDGE 0x1
+
+#define POLL_SOURCE_FD      0
+#define POLL_SOURCE_CHANNEL 1
+#define POLL_SOURCE_PROCESS 2
+
+#define POLL_CTL_ADD 1
+#define POLL_CTL_DEL 2
+#define POLL_CTL_MOD 3
+
+#define POLL_WAIT_FOREVER UINT64_MAX
+
+// Embedded in anything that can be watched; poll returns its POLL_* mask.
+struct poll_item;
+typedef struct poll_source {
+    struct poll_item *watchers;
+    uint32_t (*poll)(struct poll_source *source);
+} poll_source_t;
+
+// events is the interest mask on POLL_CTL_*, the ready mask from a wait.
+typedef struct {
+    uint32_t source;
+    int32_t id;
+    uint32_t events;
+    uint32_t flags;
+    uint64_t user_data;
+} poll_event_t;
+
+#define CHANNEL_INLINE_MAX 104
+
+// Small payloads travel inline; a mem_map region named by page_addr and
+// pages changes owner to the receiver instead of being copied.
+typedef struct {
+    uint64_t tag;
+    uint32_t len;
+    uint32_t pages;
+    uint64_t page_addr;
+    uint8_t data[CHANNEL_INLINE_MAX];
+} channel_msg_t;
+
+void wait_queue_init(wait_queue_t *wq);
+uint64_t process_sleep_locked(wait_queue_t *wq, spinlock_t *held);
+uint64_t process_sleep_on(wait_queue_t *wq);
+uint32_t wait_queue_wake(wait_queue_t *wq, uint32_t count, uint64_t result);
+void sleep_lock_init(sleep_lock_t *lock);
+void sleep_lock_acquire(sleep_lock_t *lock);
+void sleep_lock_release(sleep_lock_t *lock);
 
 void process_manager_init(void);
 int32_t process_register_boot_process(uint64_t entry, uint64_t user_stack_top);
 int32_t process_create_user(uint64_t entry);
-void process_exit_current(void);
-uint64_t process_schedule_on_syscall(uint64_t current_saved_rsp,
-                                     uint64_t current_user_rsp,
-                                     int request_switch,
-                                     uint64_t *next_user_rsp_out);
+int32_t thread_create_user(uint64_t entry, uint64_t arg0, uint64_t arg1);
+int32_t kernel_thread_create(void (*entry)(uint64_t arg), uint64_t arg);
+int32_t thread_join(int32_t tid, int32_t *exit_code_out);
+int32_t thread_set_fs_base(uint64_t fs_base);
+int32_t process_current_tid(void);
+int32_t process_current_tgid(void);
+__attribute__((noreturn)) void process_exit_current(int32_t exit_code);
+int32_t process_wait(int32_t pid, int32_t *exit_code_out);
+int32_t process_sleep_ns(uint64_t ns);
+
+#define FUTEX_RESULT_MISMATCH (-1)
+#define FUTEX_RESULT_TIMEOUT  (-2)
+
+int32_t futex_wait(uint32_t *addr, uint32_t expected, uint64_t timeout_ns);
+int32_t futex_wake(uint32_t *addr, uint32_t count);
+void poll_source_init(poll_source_t *source, uint32_t (*poll)(poll_source_t *source));
+void poll_source_notify(poll_source_t *source);
+void poll_source_detach(poll_source_t *source);
+int32_t poll_attach(int32_t set_id, const poll_event_t *event, poll_source_t *source, uint32_t fixed_mask);
+int32_t poll_create(void);
+int32_t poll_destroy(int32_t set_id);
+int32_t poll_ctl(int32_t set_id, uint32_t op, const poll_event_t *event);
+int32_t poll_wait(int32_t set_id, poll_event_t *out, uint32_t max, uint64_t timeout_ns);
+void poll_release_owner(int32_t tgid);
+int32_t channel_poll_attach(int32_t id, int32_t set_id, const poll_event_t *event);
+int32_t process_poll_attach(int32_t pid, int32_t set_id, const poll_event_t *event);
+int32_t channel_create(void);
+int32_t channel_destroy(int32_t id);
+void channel_release_owner(int32_t tgid);
+int32_t channel_send(int32_t id, const channel_msg_t *msg);
+int32_t channel_call(int32_t id, const channel_msg_t *msg, channel_msg_t *reply);
+int32_t channel_receive(int32_t id, const channel_msg_t *reply, channel_msg_t *out);
+int32_t process_set_priority(int32_t pid, int32_t nice);
+int32_t process_get_priority(int32_t pid);
+int32_t process_set_affinity(int32_t pid, uint64_t mask);
+int32_t process_get_affinity(int32_t pid, uint64_t *mask_out);
+uint32_t process_current_cpu(void);
+void process_reschedule_ipi(void);
+void process_fpu_trap(void);
+void process_account_syscall_enter(void);
+void process_account_syscall_fast(void);
+void process_account_syscall_exit(void);
+int32_t process_snapshot(process_info_t *out, uint32_t max_entries);
+int32_t process_sched_set(int32_t policy, uint64_t param, uint64_t period_ns);
+void process_sched_yield(void);
+void process_yield_current(void);
+void process_check_resched(void);
+void process_preempt_point(void);
+__attribute__((noreturn)) void process_idle_loop(void);
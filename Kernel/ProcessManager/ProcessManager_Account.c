@@ -0,0 +1,97 @@
+#include "ProcessManager_Internal.h"
+#include "../CPU/CPU_Main.h"
+#include <stddef.h>
+
+// Time between two marks is charged to user or system time depending on
+// where the task was; a zero mark means the task is not on a CPU.
+static void process_account_charge(process_t *process, uint64_t now) {
+    if (process->account_mark != 0 && now > process->account_mark) {
+        uint64_t delta = now - process->account_mark;
+        if (process->in_kernel) {
+            process->system_tsc += delta;
+        } else {
+            process->user_tsc += delta;
+        }
+    }
+    process->account_mark = now;
+}
+
+void process_account_syscall_enter(void) {
+    process_t *current = process_current();
+    if (current == NULL) {
+        return;
+    }
+    process_account_charge(current, rdtsc());
+    current->in_kernel = 1;
+    current->syscall_count++;
+}
+
+// Short calls stay charged to user time; only the call itself is counted.
+void process_account_syscall_fast(void) {
+    process_t *current = process_current();
+    if (current != NULL) {
+        current->syscall_count++;
+    }
+}
+
+void process_account_syscall_exit(void) {
+    process_t *current = process_current();
+    if (current == NULL || current->kernel_thread) {
+        return;
+    }
+    process_account_charge(current, rdtsc());
+    current->in_kernel = 0;
+}
+
+void process_account_switch_in(process_t *process, uint64_t now) {
+    if (process->ready_since != 0 && now > process->ready_since) {
+        process->wait_tsc += now - process->ready_since;
+    }
+    process->ready_since = 0;
+    process->account_mark = now;
+}
+
+// Yields and preemptions leave the task runnable and count as involuntary,
+// blocking and exit count as voluntary.
+void process_account_switch_out(process_t *process, int requeue) {
+    process_account_charge(process, rdtsc());
+    process->account_mark = 0;
+    if (requeue) {
+        process->involuntary_switches++;
+    } else {
+        process->voluntary_switches++;
+    }
+}
+
+// Adds the slice still in progress so a running task does not look idle.
+void process_account_fill(const process_t *process, process_info_t *info, uint64_t now) {
+    uint64_t user = process->user_tsc;
+    uint64_t system = process->system_tsc;
+    uint64_t wait = process->wait_tsc;
+    uint64_t mark = process->account_mark;
+    uint64_t ready_since = process->ready_since;
+
+    if (process->state == PROCESS_STATE_RUNNING && mark != 0 && now > mark) {
+        if (process->in_kernel) {
+            system += now - mark;
+        } else {
+            user += now - mark;
+        }
+    } else if (process->state == PROCESS_STATE_READY && ready_since != 0 && now > ready_since) {
+        wait += now - ready_since;
+    }
+
+    info->pid = process->pid;
+    info->tgid = process->tgid;
+    info->parent_pid = process->parent_pid;
+    info->state = process->state;
+    info->cpu = process->run_cpu;
+    info->kernel = process->kernel_thread;
+    info->nice = (int8_t)((int32_t)process->priority - PROCESS_PRIORITY_LEVELS / 2);
+    info->user_ns = timer_tsc_to_ns(user);
+    info->system_ns = timer_tsc_to_ns(system);
+    info->wait_ns = timer_tsc_to_ns(wait);
+    info->voluntary_switches = process->voluntary_switches;
+    info->involuntary_switches = process->involuntary_switches;
+    info->syscalls = process->syscall_count;
+}
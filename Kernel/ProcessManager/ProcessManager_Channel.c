@@ -0,0 +1,297 @@
+#include "ProcessManager_Internal.h"
+#include "../Syscall/Syscall_Memory.h"
+#include <stddef.h>
+
+#define CHANNEL_MAX 16
+#define CHANNEL_QUEUE_LEN 16
+
+typedef struct {
+    channel_msg_t msg;
+    process_t *caller;
+    channel_msg_t *reply;
+    int32_t sender_tgid;
+} channel_entry_t;
+
+// One receiving thread per channel. A call stays "being served" from the
+// receive that picked it up until that thread's next receive replies.
+typedef struct {
+    spinlock_t lock;
+    uint8_t used;
+    int32_t owner;
+    uint32_t head;
+    uint32_t count;
+    channel_entry_t queue[CHANNEL_QUEUE_LEN];
+    process_t *receiver;
+    channel_msg_t *receiver_buf;
+    process_t *caller;
+    channel_msg_t *caller_reply;
+    poll_source_t poll;
+} channel_t;
+
+static channel_t g_channels[CHANNEL_MAX];
+
+static channel_t *channel_get(int32_t id) {
+    if (id < 0 || id >= CHANNEL_MAX) {
+        return NULL;
+    }
+    return &g_channels[id];
+}
+
+// Pages ride along by ownership: the sender's region is parked while the
+// message is queued and given to whoever receives it.
+static int channel_take_pages(channel_msg_t *msg, int32_t tgid) {
+    if (msg->len > CHANNEL_INLINE_MAX) {
+        return 0;
+    }
+    if (msg->pages == 0) {
+        msg->page_addr = 0;
+        return 1;
+    }
+    return syscall_memory_transfer((void *)msg->page_addr, msg->pages, tgid, MEM_OWNER_IN_FLIGHT) == 0;
+}
+
+static void channel_give_pages(const channel_msg_t *msg, int32_t tgid) {
+    if (msg->pages != 0) {
+        syscall_memory_transfer((void *)msg->page_addr, msg->pages, MEM_OWNER_IN_FLIGHT, tgid);
+    }
+}
+
+static void channel_deliver_locked(channel_t *channel, const channel_entry_t *entry, channel_msg_t *out,
+                                   int32_t receiver_tgid) {
+    *out = entry->msg;
+    channel_give_pages(&entry->msg, receiver_tgid);
+    channel->caller = entry->caller;
+    channel->caller_reply = entry->reply;
+}
+
+static void channel_push_locked(channel_t *channel, const channel_entry_t *entry) {
+    channel->queue[(channel->head + channel->count) % CHANNEL_QUEUE_LEN] = *entry;
+    channel->count++;
+}
+
+static int channel_accepts_locked(const channel_t *channel) {
+    return channel->used && (channel->receiver != NULL || channel->count < CHANNEL_QUEUE_LEN);
+}
+
+// Readable with messages queued, writable while the queue has room.
+static uint32_t channel_poll(poll_source_t *source) {
+    channel_t *channel = (channel_t *)((uint8_t *)source - offsetof(channel_t, poll));
+    if (!channel->used) {
+        return POLL_HUP;
+    }
+    uint32_t count = __atomic_load_n(&channel->count, __ATOMIC_RELAXED);
+    return (count != 0 ? POLL_IN : 0) | (count < CHANNEL_QUEUE_LEN ? POLL_OUT : 0);
+}
+
+int32_t channel_poll_attach(int32_t id, int32_t set_id, const poll_event_t *event) {
+    channel_t *channel = channel_get(id);
+    if (channel == NULL) {
+        return -1;
+    }
+    uint64_t flags = spinlock_acquire_irqsave(&channel->lock);
+    int32_t rc = channel->used ? poll_attach(set_id, event, &channel->poll, 0) : -1;
+    spinlock_release_irqrestore(&channel->lock, flags);
+    return rc;
+}
+
+int32_t channel_create(void) {
+    for (int32_t id = 0; id < CHANNEL_MAX; ++id) {
+        channel_t *channel = &g_channels[id];
+        uint64_t flags = spinlock_acquire_irqsave(&channel->lock);
+        if (!channel->used) {
+            channel->used = 1;
+            channel->owner = process_current_tgid();
+            channel->head = 0;
+            channel->count = 0;
+            channel->receiver = NULL;
+            channel->caller = NULL;
+            poll_source_init(&channel->poll, channel_poll);
+            spinlock_release_irqrestore(&channel->lock, flags);
+            return id;
+        }
+        spinlock_release_irqrestore(&channel->lock, flags);
+    }
+    return -1;
+}
+
+// Everyone still waiting on the channel fails with -1 and queued pages go
+// back to their senders.
+static int32_t channel_free(channel_t *channel, int32_t owner) {
+    uint64_t flags = spinlock_acquire_irqsave(&channel->lock);
+    if (!channel->used || channel->owner != owner) {
+        spinlock_release_irqrestore(&channel->lock, flags);
+        return -1;
+    }
+    channel->used = 0;
+    channel->owner = -1;
+    if (channel->receiver != NULL) {
+        process_wake(channel->receiver, (uint64_t)-1);
+        channel->receiver = NULL;
+    }
+    if (channel->caller != NULL) {
+        process_wake(channel->caller, (uint64_t)-1);
+        channel->caller = NULL;
+    }
+    while (channel->count != 0) {
+        channel_entry_t *entry = &channel->queue[channel->head];
+        channel_give_pages(&entry->msg, entry->sender_tgid);
+        if (entry->caller != NULL) {
+            process_wake(entry->caller, (uint64_t)-1);
+        }
+        channel->head = (channel->head + 1) % CHANNEL_QUEUE_LEN;
+        channel->count--;
+    }
+    poll_source_detach(&channel->poll);
+    spinlock_release_irqrestore(&channel->lock, flags);
+    return 0;
+}
+
+// Only the thread group that created a channel may destroy it.
+int32_t channel_destroy(int32_t id) {
+    channel_t *channel = channel_get(id);
+    if (channel == NULL) {
+        return -1;
+    }
+    return channel_free(channel, process_current_tgid());
+}
+
+// Called once the last thread of tgid has exited.
+void channel_release_owner(int32_t tgid) {
+    for (int32_t id = 0; id < CHANNEL_MAX; ++id) {
+        if (g_channels[id].used && g_channels[id].owner == tgid) {
+            channel_free(&g_channels[id], tgid);
+        }
+    }
+}
+
+// Fire and forget; fails instead of blocking when the queue is full.
+int32_t channel_send(int32_t id, const channel_msg_t *msg) {
+    channel_t *channel = channel_get(id);
+    if (channel == NULL || msg == NULL) {
+        return -1;
+    }
+    int32_t tgid = process_current_tgid();
+    channel_entry_t entry = { .msg = *msg, .caller = NULL, .reply = NULL, .sender_tgid = tgid };
+    if (!channel_take_pages(&entry.msg, tgid)) {
+        return -1;
+    }
+
+    uint64_t flags = spinlock_acquire_irqsave(&channel->lock);
+    if (!channel_accepts_locked(channel)) {
+        spinlock_release_irqrestore(&channel->lock, flags);
+        channel_give_pages(&entry.msg, tgid);
+        return -1;
+    }
+    process_t *server = channel->receiver;
+    if (server != NULL) {
+        channel->receiver = NULL;
+        channel_deliver_locked(channel, &entry, channel->receiver_buf, server->tgid);
+    } else {
+        channel_push_locked(channel, &entry);
+    }
+    spinlock_release(&channel->lock);
+    if (server != NULL) {
+        process_wake(server, 0);
+    } else {
+        poll_source_notify(&channel->poll);
+    }
+    irq_restore(flags);
+    return 0;
+}
+
+// Sends a request and sleeps until it is answered. A receiver already
+// waiting gets this CPU directly instead of being queued for it.
+int32_t channel_call(int32_t id, const channel_msg_t *msg, channel_msg_t *reply) {
+    channel_t *channel = channel_get(id);
+    if (channel == NULL || msg == NULL || reply == NULL) {
+        return -1;
+    }
+    int32_t tgid = process_current_tgid();
+    channel_entry_t entry = { .msg = *msg, .caller = NULL, .reply = reply, .sender_tgid = tgid };
+    if (!channel_take_pages(&entry.msg, tgid)) {
+        return -1;
+    }
+
+    uint64_t flags = spinlock_acquire_irqsave(&channel->lock);
+    if (!channel_accepts_locked(channel)) {
+        spinlock_release_irqrestore(&channel->lock, flags);
+        channel_give_pages(&entry.msg, tgid);
+        return -1;
+    }
+    entry.caller = process_block_prepare();
+    process_t *server = channel->receiver;
+    uint64_t result;
+    if (server != NULL) {
+        channel->receiver = NULL;
+        channel_deliver_locked(channel, &entry, channel->receiver_buf, server->tgid);
+        spinlock_release(&channel->lock);
+        result = process_block_handoff(server, 0);
+    } else {
+        channel_push_locked(channel, &entry);
+        spinlock_release(&channel->lock);
+        poll_source_notify(&channel->poll);
+        result = process_block_commit();
+    }
+    irq_restore(flags);
+    return (int32_t)(int64_t)result;
+}
+
+// Answers the call being served, if any, then waits for the next message.
+// With nothing queued the CPU goes straight back to the caller, so a
+// call/reply round trip costs two direct switches. A served call left
+// without a reply fails with -1.
+int32_t channel_receive(int32_t id, const channel_msg_t *reply, channel_msg_t *out) {
+    channel_t *channel = channel_get(id);
+    if (channel == NULL || out == NULL) {
+        return -1;
+    }
+    int32_t tgid = process_current_tgid();
+    channel_msg_t answer;
+    if (reply != NULL) {
+        answer = *reply;
+        if (!channel_take_pages(&answer, tgid)) {
+            return -1;
+        }
+    }
+
+    uint64_t flags = spinlock_acquire_irqsave(&channel->lock);
+    if (!channel->used || channel->receiver != NULL) {
+        spinlock_release_irqrestore(&channel->lock, flags);
+        if (reply != NULL) {
+            channel_give_pages(&answer, tgid);
+        }
+        return -1;
+    }
+
+    process_t *client = channel->caller;
+    uint64_t client_result = (uint64_t)-1;
+    channel->caller = NULL;
+    if (client != NULL && reply != NULL) {
+        *channel->caller_reply = answer;
+        channel_give_pages(&answer, client->tgid);
+        client_result = 0;
+    } else if (reply != NULL) {
+        channel_give_pages(&answer, tgid);
+    }
+
+    if (channel->count != 0) {
+        channel_entry_t *entry = &channel->queue[channel->head];
+        channel->head = (channel->head + 1) % CHANNEL_QUEUE_LEN;
+        channel->count--;
+        channel_deliver_locked(channel, entry, out, tgid);
+        spinlock_release(&channel->lock);
+        poll_source_notify(&channel->poll);
+        if (client != NULL) {
+            process_wake(client, client_result);
+        }
+        irq_restore(flags);
+        return 0;
+    }
+
+    channel->receiver = process_block_prepare();
+    channel->receiver_buf = out;
+    spinlock_release(&channel->lock);
+    uint64_t result = client != NULL ? process_block_handoff(client, client_result) : process_block_commit();
+    irq_restore(flags);
+    return (int32_t)(int64_t)result;
+}
@@ -1,181 +1,470 @@
-#include "ProcessManager.h"
+#include "ProcessManager_Internal.h"
+#include "../CPU/CPU_Main.h"
+#include "../FPU/FPU_Main.h"
 #include "../Memory/Memory_Main.h"
 #include "../Serial.h"
-#include "../Syscall/Syscall_Main.h"
+#include "../Syscall/Syscall_Ring.h"
 #include <stddef.h>
 
-#define PROCESS_MAX_COUNT 16
-#define PROCESS_STACK_SIZE (16 * 1024)
-#define PROCESS_RFLAGS_DEFAULT 0x202ULL
-#define PROCESS_STATE_UNUSED 0
-#define PROCESS_STATE_READY  1
-#define PROCESS_STATE_RUNNING 2
-#define PROCESS_STATE_DEAD 3
-#define PROCESS_CONTEXT_QWORDS SYSCALL_FRAME_QWORDS
-
-typedef struct {
-    uint8_t state;
-    uint64_t entry;
-    uint64_t saved_rsp;
-    uint64_t saved_user_rsp;
-    uint8_t *stack_base;
-} process_t;
-
-static process_t g_processes[PROCESS_MAX_COUNT];
-static int32_t g_current_pid = -1;
-
-static void halt_forever(void) {
-    while (1) {
-        __asm__ volatile ("hlt");
+#define PROCESS_TABLE_INITIAL_CAPACITY 16
+
+static process_t **g_process_table = NULL;
+static uint32_t g_process_capacity = 0;
+static uint32_t g_process_count = 0;
+static process_t *g_process_free_list = NULL;
+spinlock_t g_process_table_lock = SPINLOCK_INIT;
+
+static int process_table_grow(void) {
+    uint32_t new_capacity = g_process_capacity ? g_process_capacity * 2 : PROCESS_TABLE_INITIAL_CAPACITY;
+    process_t **table = (process_t **)krealloc(g_process_table, new_capacity * sizeof(process_t *));
+    if (table == NULL) {
+        return 0;
+    }
+    for (uint32_t i = g_process_capacity; i < new_capacity; ++i) {
+        table[i] = NULL;
     }
+    g_process_table = table;
+    g_process_capacity = new_capacity;
+    return 1;
 }
 
-static int32_t find_free_slot(void) {
-    for (int32_t i = 0; i < PROCESS_MAX_COUNT; ++i) {
-        if (g_processes[i].state == PROCESS_STATE_UNUSED ||
-            g_processes[i].state == PROCESS_STATE_DEAD) {
-            return i;
+static uint32_t process_exit_poll(poll_source_t *source) {
+    process_t *process = (process_t *)((uint8_t *)source - offsetof(process_t, exit_poll));
+    return process->state == PROCESS_STATE_ZOMBIE ? POLL_IN | POLL_HUP : 0;
+}
+
+static process_t *process_alloc(void) {
+    process_t *process = g_process_free_list;
+    if (process != NULL) {
+        g_process_free_list = process->run_next;
+    } else {
+        if (g_process_count == g_process_capacity && !process_table_grow()) {
+            return NULL;
+        }
+        process = (process_t *)kmalloc(sizeof(process_t));
+        if (process == NULL) {
+            return NULL;
         }
+        process->pid = (int32_t)g_process_count;
+        g_process_table[g_process_count++] = process;
     }
-    return -1;
+
+    int32_t pid = process->pid;
+    uint8_t *bytes = (uint8_t *)process;
+    for (uint32_t i = 0; i < sizeof(process_t); ++i) {
+        bytes[i] = 0;
+    }
+    process->pid = pid;
+    process->tgid = pid;
+    process->parent_pid = -1;
+    process->priority = PROCESS_PRIORITY_DEFAULT;
+    process->affinity = PROCESS_AFFINITY_ALL;
+    process->run_cpu = (uint8_t)cpu_current()->index;
+    poll_source_init(&process->exit_poll, process_exit_poll);
+    return process;
 }
 
-static int32_t pick_next_ready(int32_t current_pid) {
-    if (current_pid < 0) {
-        for (int32_t i = 0; i < PROCESS_MAX_COUNT; ++i) {
-            if (g_processes[i].state == PROCESS_STATE_READY ||
-                g_processes[i].state == PROCESS_STATE_RUNNING) {
-                return i;
-            }
+process_t *process_lookup(int32_t pid) {
+    if (pid < 0 || (uint32_t)pid >= g_process_count) {
+        return NULL;
+    }
+    process_t *process = g_process_table[pid];
+    if (process == NULL || process->state == PROCESS_STATE_UNUSED) {
+        return NULL;
+    }
+    return process;
+}
+
+process_t *process_current(void) {
+    return (process_t *)cpu_current()->current_task;
+}
+
+void process_set_current(process_t *process) {
+    cpu_local_t *cpu = cpu_current();
+    cpu->current_task = process;
+    cpu->current_pid = process != NULL ? process->pid : -1;
+}
+
+static void process_free_resources(process_t *process) {
+    if (process->stack_base != NULL) {
+        free_pages(process->stack_base, PROCESS_STACK_PAGES);
+        process->stack_base = NULL;
+    }
+    if (process->kernel_stack != NULL) {
+        free_pages(process->kernel_stack, PROCESS_KERNEL_STACK_PAGES);
+        process->kernel_stack = NULL;
+    }
+    fpu_state_free(process->fpu_state);
+    process->fpu_state = NULL;
+}
+
+static void process_release_locked(process_t *process) {
+    poll_source_detach(&process->exit_poll);
+    process_free_resources(process);
+    process->state = PROCESS_STATE_UNUSED;
+    process->run_prev = NULL;
+    process->run_next = g_process_free_list;
+    g_process_free_list = process;
+}
+
+void process_release(process_t *process) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_release_locked(process);
+    spinlock_release_irqrestore(&g_process_table_lock, flags);
+}
+
+static void process_orphan_children_locked(process_t *parent) {
+    for (uint32_t i = 0; i < g_process_count && parent->child_count != 0; ++i) {
+        process_t *child = g_process_table[i];
+        if (child == NULL || child->state == PROCESS_STATE_UNUSED || child->parent_pid != parent->pid) {
+            continue;
+        }
+        child->parent_pid = -1;
+        parent->child_count--;
+        if (child->state == PROCESS_STATE_ZOMBIE) {
+            process_release_locked(child);
         }
-        return -1;
     }
+}
+
+// Kernel objects are owned by a thread group and die with its last thread.
+// This runs in the scheduler's finish path, so nothing here may sleep.
+static void process_release_group_objects(int32_t tgid) {
+    poll_release_owner(tgid);
+    syscall_ring_release_owner(tgid);
+    channel_release_owner(tgid);
+}
+
+static int process_is_thread(const process_t *process) {
+    return process->tgid != process->pid;
+}
+
+// Exiting tasks that have not retired yet still count, so the last one to
+// retire is the one that cleans up.
+static int process_group_live_locked(const process_t *self) {
+    for (uint32_t i = 0; i < g_process_count; ++i) {
+        process_t *other = g_process_table[i];
+        if (other != NULL && other != self && other->tgid == self->tgid &&
+            other->state != PROCESS_STATE_UNUSED && other->state != PROCESS_STATE_ZOMBIE) {
+            return 1;
+        }
+    }
+    return 0;
+}
 
-    for (int32_t step = 1; step <= PROCESS_MAX_COUNT; ++step) {
-        int32_t idx = (current_pid + step) % PROCESS_MAX_COUNT;
-        if (g_processes[idx].state == PROCESS_STATE_READY) {
-            return idx;
+// Nobody is left to join these, so their exit codes are dropped.
+static void process_release_thread_zombies_locked(int32_t tgid) {
+    for (uint32_t i = 0; i < g_process_count; ++i) {
+        process_t *thread = g_process_table[i];
+        if (thread != NULL && thread->tgid == tgid && process_is_thread(thread) &&
+            thread->state == PROCESS_STATE_ZOMBIE) {
+            process_release_locked(thread);
         }
     }
-    if (g_processes[current_pid].state == PROCESS_STATE_RUNNING ||
-        g_processes[current_pid].state == PROCESS_STATE_READY) {
-        return current_pid;
+}
+
+// A thread is reaped by any thread of its group through thread_join, so it
+// stays a zombie while the group has live threads. A process is reaped by
+// its parent through process_wait.
+void process_retire(process_t *process) {
+    process_sched_release(process);
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_orphan_children_locked(process);
+
+    int32_t tgid = process->tgid;
+    int group_live = process_group_live_locked(process);
+    if (!group_live) {
+        process_release_thread_zombies_locked(process->tgid);
+    }
+    process_t *parent = process_is_thread(process) ? NULL : process_lookup(process->parent_pid);
+    if (process_is_thread(process) ? !group_live : parent == NULL) {
+        process_release_locked(process);
+    } else {
+        process_free_resources(process);
+        process->state = PROCESS_STATE_ZOMBIE;
+        if (parent != NULL) {
+            wait_queue_wake(&parent->child_wait, UINT32_MAX, 0);
+        }
+        poll_source_notify(&process->exit_poll);
+    }
+    wait_queue_wake(&process->exit_wait, UINT32_MAX, 0);
+    spinlock_release_irqrestore(&g_process_table_lock, flags);
+
+    if (!group_live) {
+        process_release_group_objects(tgid);
+    }
+}
+
+int32_t process_wait(int32_t pid, int32_t *exit_code_out) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_t *self = process_current();
+    uint32_t first = pid < 0 ? 0 : (uint32_t)pid;
+
+    while (1) {
+        uint32_t last = pid < 0 ? g_process_count : (uint32_t)pid + 1;
+        int found = 0;
+        for (uint32_t i = first; i < last && i < g_process_count; ++i) {
+            process_t *child = g_process_table[i];
+            if (child == NULL || child->state == PROCESS_STATE_UNUSED || child->parent_pid != self->pid ||
+                process_is_thread(child)) {
+                continue;
+            }
+            if (child->state == PROCESS_STATE_ZOMBIE) {
+                int32_t reaped = child->pid;
+                if (exit_code_out != NULL) {
+                    *exit_code_out = child->exit_code;
+                }
+                self->child_count--;
+                process_release_locked(child);
+                spinlock_release_irqrestore(&g_process_table_lock, flags);
+                return reaped;
+            }
+            found = 1;
+        }
+        if (!found) {
+            spinlock_release_irqrestore(&g_process_table_lock, flags);
+            return -1;
+        }
+        process_sleep_locked(&self->child_wait, &g_process_table_lock);
+    }
+}
+
+int32_t thread_join(int32_t tid, int32_t *exit_code_out) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_t *self = process_current();
+
+    while (1) {
+        process_t *target = process_lookup(tid);
+        if (target == NULL || target == self || target->tgid != self->tgid || !process_is_thread(target)) {
+            spinlock_release_irqrestore(&g_process_table_lock, flags);
+            return -1;
+        }
+        if (target->state == PROCESS_STATE_ZOMBIE) {
+            if (exit_code_out != NULL) {
+                *exit_code_out = target->exit_code;
+            }
+            process_release_locked(target);
+            spinlock_release_irqrestore(&g_process_table_lock, flags);
+            return tid;
+        }
+        process_sleep_locked(&target->exit_wait, &g_process_table_lock);
     }
-    return -1;
+}
+
+// Ready once pid has exited and is waiting to be reaped; a process that
+// is reaped or released while watched reports POLL_HUP.
+int32_t process_poll_attach(int32_t pid, int32_t set_id, const poll_event_t *event) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_t *process = process_lookup(pid);
+    int32_t rc = process != NULL ? poll_attach(set_id, event, &process->exit_poll, 0) : -1;
+    spinlock_release_irqrestore(&g_process_table_lock, flags);
+    return rc;
 }
 
 void process_manager_init(void) {
-    for (int32_t i = 0; i < PROCESS_MAX_COUNT; ++i) {
-        g_processes[i].state = PROCESS_STATE_UNUSED;
-        g_processes[i].entry = 0;
-        g_processes[i].saved_rsp = 0;
-        g_processes[i].saved_user_rsp = 0;
-        g_processes[i].stack_base = NULL;
+    g_process_table = NULL;
+    g_process_capacity = 0;
+    g_process_count = 0;
+    g_process_free_list = NULL;
+    process_set_current(NULL);
+    runqueue_init();
+    futex_init();
+    if (!process_table_grow()) {
+        serial_write_string("[OS] [PROC] Process table allocation failed\n");
+    }
+}
+
+// Lays out what context_switch pops: r15, r14, r13, r12, rbx, rbp, return.
+static void process_init_switch_frame(process_t *process, uint64_t *top, void (*resume)(void),
+                                      uint64_t r12, uint64_t r13) {
+    uint64_t *switch_frame = top - 7;
+    for (uint32_t i = 0; i < 6; ++i) {
+        switch_frame[i] = 0;
+    }
+    switch_frame[2] = r13;
+    switch_frame[3] = r12;
+    switch_frame[6] = (uint64_t)resume;
+    process->kernel_rsp = (uint64_t)switch_frame;
+}
+
+static void process_init_kernel_stack(process_t *process, uint64_t entry, uint64_t user_rsp,
+                                      uint64_t arg0, uint64_t arg1) {
+    uint64_t *frame = (uint64_t *)(process->kernel_stack + PROCESS_KERNEL_STACK_SIZE) - SYSCALL_FRAME_QWORDS;
+    for (uint32_t i = 0; i < SYSCALL_FRAME_QWORDS; ++i) {
+        frame[i] = 0;
     }
-    g_current_pid = -1;
+    frame[SYSCALL_FRAME_RCX] = entry;
+    frame[SYSCALL_FRAME_R11] = PROCESS_RFLAGS_DEFAULT;
+    frame[SYSCALL_FRAME_RDI] = arg0;
+    frame[SYSCALL_FRAME_RSI] = arg1;
+    frame[SYSCALL_FRAME_USER_RSP] = user_rsp;
+    process_init_switch_frame(process, frame, process_thread_entry, 0, 0);
 }
 
 int32_t process_register_boot_process(uint64_t entry, uint64_t user_stack_top) {
-    int32_t pid = find_free_slot();
-    if (pid < 0) {
+    uint8_t *kernel_stack = (uint8_t *)alloc_pages(PROCESS_KERNEL_STACK_PAGES);
+    if (kernel_stack == NULL) {
+        serial_write_string("[OS] [PROC] Kernel stack allocation failed\n");
+        return -1;
+    }
+
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_t *process = process_alloc();
+    if (process == NULL) {
+        spinlock_release_irqrestore(&g_process_table_lock, flags);
+        free_pages(kernel_stack, PROCESS_KERNEL_STACK_PAGES);
         serial_write_string("[OS] [PROC] No free slot for boot process\n");
         return -1;
     }
 
-    g_processes[pid].state = PROCESS_STATE_RUNNING;
-    g_processes[pid].entry = entry;
-    g_processes[pid].saved_rsp = user_stack_top;
-    g_processes[pid].saved_user_rsp = user_stack_top;
-    g_processes[pid].stack_base = NULL;
-    g_current_pid = pid;
+    process->state = PROCESS_STATE_READY;
+    process->entry = entry;
+    process->stack_base = NULL;
+    process->kernel_stack = kernel_stack;
+    process_init_kernel_stack(process, entry, user_stack_top & ~0xFULL, 0, 0);
+    int32_t pid = process->pid;
+    spinlock_release_irqrestore(&g_process_table_lock, flags);
 
+    runqueue_enqueue(process);
     serial_write_string("[OS] [PROC] Boot process registered\n");
     return pid;
 }
 
-int32_t process_create_user(uint64_t entry) {
+static int32_t process_spawn(uint64_t entry, uint64_t arg0, uint64_t arg1, int thread) {
     if (entry == 0) {
         return -1;
     }
 
-    int32_t pid = find_free_slot();
-    if (pid < 0) {
-        serial_write_string("[OS] [PROC] No free slot for process create\n");
+    uint8_t *stack = (uint8_t *)alloc_pages(PROCESS_STACK_PAGES);
+    uint8_t *kernel_stack = (uint8_t *)alloc_pages(PROCESS_KERNEL_STACK_PAGES);
+    if (stack == NULL || kernel_stack == NULL) {
+        if (stack != NULL) {
+            free_pages(stack, PROCESS_STACK_PAGES);
+        }
+        if (kernel_stack != NULL) {
+            free_pages(kernel_stack, PROCESS_KERNEL_STACK_PAGES);
+        }
+        serial_write_string("[OS] [PROC] Stack allocation failed\n");
         return -1;
     }
 
-    uint8_t *stack = (uint8_t *)kmalloc(PROCESS_STACK_SIZE);
-    if (stack == NULL) {
-        serial_write_string("[OS] [PROC] Stack allocation failed\n");
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_t *process = process_alloc();
+    if (process == NULL) {
+        spinlock_release_irqrestore(&g_process_table_lock, flags);
+        free_pages(stack, PROCESS_STACK_PAGES);
+        free_pages(kernel_stack, PROCESS_KERNEL_STACK_PAGES);
+        serial_write_string("[OS] [PROC] No free slot for process create\n");
         return -1;
     }
 
     uint64_t stack_top = ((uint64_t)(stack + PROCESS_STACK_SIZE)) & ~0xFULL;
-    uint64_t *frame = (uint64_t *)(stack_top - (PROCESS_CONTEXT_QWORDS * sizeof(uint64_t)));
 
-    for (uint32_t i = 0; i < PROCESS_CONTEXT_QWORDS; ++i) {
-        frame[i] = 0;
+    process->state = PROCESS_STATE_READY;
+    process->entry = entry;
+    process->stack_base = stack;
+    process->kernel_stack = kernel_stack;
+    process_init_kernel_stack(process, entry, stack_top - sizeof(uint64_t), arg0, arg1);
+    process_t *parent = process_current();
+    if (parent != NULL) {
+        process->affinity = parent->affinity;
+        if (thread) {
+            process->tgid = parent->tgid;
+        } else {
+            process->parent_pid = parent->pid;
+            parent->child_count++;
+        }
     }
-    frame[SYSCALL_FRAME_RCX] = entry;
-    frame[SYSCALL_FRAME_R11] = PROCESS_RFLAGS_DEFAULT;
-
-    g_processes[pid].state = PROCESS_STATE_READY;
-    g_processes[pid].entry = entry;
-    g_processes[pid].saved_rsp = (uint64_t)frame;
-    g_processes[pid].saved_user_rsp = stack_top;
-    g_processes[pid].stack_base = stack;
+    int32_t pid = process->pid;
+    spinlock_release_irqrestore(&g_process_table_lock, flags);
 
+    runqueue_enqueue(process);
     return pid;
 }
 
-void process_exit_current(void) {
-    if (g_current_pid < 0 || g_current_pid >= PROCESS_MAX_COUNT) {
-        return;
+int32_t kernel_thread_create(void (*entry)(uint64_t arg), uint64_t arg) {
+    uint8_t *kernel_stack = (uint8_t *)alloc_pages(PROCESS_KERNEL_STACK_PAGES);
+    if (kernel_stack == NULL) {
+        serial_write_string("[OS] [PROC] Kernel stack allocation failed\n");
+        return -1;
     }
-    g_processes[g_current_pid].state = PROCESS_STATE_DEAD;
-}
 
-uint64_t process_schedule_on_syscall(uint64_t current_saved_rsp,
-                                     uint64_t current_user_rsp,
-                                     int request_switch,
-                                     uint64_t *next_user_rsp_out) {
-    if (next_user_rsp_out != NULL) {
-        *next_user_rsp_out = current_user_rsp;
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_t *process = process_alloc();
+    if (process == NULL) {
+        spinlock_release_irqrestore(&g_process_table_lock, flags);
+        free_pages(kernel_stack, PROCESS_KERNEL_STACK_PAGES);
+        serial_write_string("[OS] [PROC] No free slot for kernel thread\n");
+        return -1;
     }
 
-    if (g_current_pid < 0 || g_current_pid >= PROCESS_MAX_COUNT) {
-        serial_write_string("[OS] [PROC] Invalid current PID\n");
-        return current_saved_rsp;
-    }
+    process->state = PROCESS_STATE_READY;
+    process->kernel_thread = 1;
+    process->in_kernel = 1;
+    process->entry = (uint64_t)entry;
+    process->kernel_stack = kernel_stack;
+    // Keep the same stack alignment as a user thread sitting on its frame.
+    uint64_t *top = (uint64_t *)(kernel_stack + PROCESS_KERNEL_STACK_SIZE) - SYSCALL_FRAME_QWORDS;
+    process_init_switch_frame(process, top, process_kernel_thread_entry, (uint64_t)entry, arg);
+    int32_t pid = process->pid;
+    spinlock_release_irqrestore(&g_process_table_lock, flags);
 
-    process_t *current = &g_processes[g_current_pid];
-    if (current->state == PROCESS_STATE_RUNNING || current->state == PROCESS_STATE_READY) {
-        current->saved_rsp = current_saved_rsp;
-        current->saved_user_rsp = current_user_rsp;
-        if (current->state != PROCESS_STATE_DEAD) {
-            current->state = PROCESS_STATE_READY;
-        }
+    runqueue_enqueue(process);
+    return pid;
+}
+
+int32_t process_create_user(uint64_t entry) {
+    return process_spawn(entry, 0, 0, 0);
+}
+
+int32_t thread_create_user(uint64_t entry, uint64_t arg0, uint64_t arg1) {
+    return process_spawn(entry, arg0, arg1, 1);
+}
+
+int32_t thread_set_fs_base(uint64_t fs_base) {
+    process_t *current = process_current();
+    if (current == NULL || (fs_base >> 47) != 0) {
+        return -1;
     }
+    current->fs_base = fs_base;
+    cpu_write_fs_base(fs_base);
+    return 0;
+}
 
-    if (!request_switch && current->state != PROCESS_STATE_DEAD) {
-        current->state = PROCESS_STATE_RUNNING;
-        if (next_user_rsp_out != NULL) {
-            *next_user_rsp_out = current->saved_user_rsp;
+// Copies accounting for every live task; returns how many were written.
+int32_t process_snapshot(process_info_t *out, uint32_t max_entries) {
+    if (out == NULL) {
+        return -1;
+    }
+    uint32_t written = 0;
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    uint64_t now = rdtsc();
+    for (uint32_t i = 0; i < g_process_count && written < max_entries; ++i) {
+        process_t *process = g_process_table[i];
+        if (process == NULL || process->state == PROCESS_STATE_UNUSED) {
+            continue;
         }
-        return current->saved_rsp;
+        process_account_fill(process, &out[written++], now);
     }
+    spinlock_release_irqrestore(&g_process_table_lock, flags);
+    return (int32_t)written;
+}
 
-    int32_t next_pid = pick_next_ready(g_current_pid);
-    if (next_pid < 0) {
-        serial_write_string("[OS] [PROC] No runnable process. Halting.\n");
-        halt_forever();
-    }
+int32_t process_current_tid(void) {
+    process_t *current = process_current();
+    return current != NULL ? current->pid : -1;
+}
 
-    g_current_pid = next_pid;
-    process_t *next = &g_processes[g_current_pid];
-    next->state = PROCESS_STATE_RUNNING;
-    if (next_user_rsp_out != NULL) {
-        *next_user_rsp_out = next->saved_user_rsp;
-    }
-    return next->saved_rsp;
+int32_t process_current_tgid(void) {
+    process_t *current = process_current();
+    return current != NULL ? current->tgid : -1;
+}
+
+void process_exit_current(int32_t exit_code) {
+    irq_save_disable();
+    process_t *current = process_current();
+    current->exit_code = exit_code;
+    current->state = PROCESS_STATE_DEAD;
+    process_schedule(0);
+    __builtin_unreachable();
 }
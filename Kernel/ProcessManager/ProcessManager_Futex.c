@@ -0,0 +1,120 @@
+#include "ProcessManager_Internal.h"
+#include <stddef.h>
+
+#define FUTEX_HASH_BITS 8
+#define FUTEX_HASH_SIZE (1u << FUTEX_HASH_BITS)
+#define FUTEX_USER_LIMIT 0x800000000000ULL
+
+typedef struct {
+    spinlock_t lock;
+    process_t *head;
+} futex_bucket_t;
+
+static futex_bucket_t g_futex_buckets[FUTEX_HASH_SIZE];
+
+static futex_bucket_t *futex_bucket_for(uint64_t addr) {
+    uint64_t hash = (addr >> 2) * 0x9E3779B97F4A7C15ULL;
+    return &g_futex_buckets[hash >> (64 - FUTEX_HASH_BITS)];
+}
+
+static int futex_unlink_locked(futex_bucket_t *bucket, process_t *process) {
+    process_t **link = &bucket->head;
+    while (*link != NULL && *link != process) {
+        link = &(*link)->wait_next;
+    }
+    if (*link == NULL) {
+        return 0;
+    }
+    *link = process->wait_next;
+    process->wait_next = NULL;
+    process->futex_addr = 0;
+    return 1;
+}
+
+static void futex_timeout(timer_event_t *event) {
+    process_t *process = (process_t *)((uint8_t *)event - offsetof(process_t, sleep_timer));
+    uint64_t addr = process->futex_addr;
+    if (addr == 0) {
+        return;
+    }
+
+    futex_bucket_t *bucket = futex_bucket_for(addr);
+    spinlock_acquire(&bucket->lock);
+    int expired = process->wait_seq == event->cookie && futex_unlink_locked(bucket, process);
+    spinlock_release(&bucket->lock);
+    if (expired) {
+        process_wake(process, (uint64_t)(int64_t)FUTEX_RESULT_TIMEOUT);
+    }
+}
+
+void futex_init(void) {
+    for (uint32_t i = 0; i < FUTEX_HASH_SIZE; ++i) {
+        g_futex_buckets[i].lock.locked = 0;
+        g_futex_buckets[i].head = NULL;
+    }
+}
+
+int32_t futex_wait(uint32_t *addr, uint32_t expected, uint64_t timeout_ns) {
+    uint64_t key = (uint64_t)addr;
+    if (key == 0 || (key & 3) != 0 || key >= FUTEX_USER_LIMIT) {
+        return -1;
+    }
+
+    futex_bucket_t *bucket = futex_bucket_for(key);
+    uint64_t flags = spinlock_acquire_irqsave(&bucket->lock);
+    if (__atomic_load_n(addr, __ATOMIC_SEQ_CST) != expected) {
+        spinlock_release_irqrestore(&bucket->lock, flags);
+        return FUTEX_RESULT_MISMATCH;
+    }
+
+    process_t *process = process_block_prepare();
+    process->futex_addr = key;
+    process->wait_next = bucket->head;
+    bucket->head = process;
+    if (timeout_ns != 0 && timer_is_ready()) {
+        process->sleep_timer.callback = futex_timeout;
+        process->sleep_timer.cookie = process->wait_seq;
+        timer_event_add(&process->sleep_timer, rdtsc() + timer_ns_to_tsc(timeout_ns));
+    }
+    spinlock_release(&bucket->lock);
+
+    int32_t result = (int32_t)process_block_commit();
+    irq_restore(flags);
+    return result;
+}
+
+int32_t futex_wake(uint32_t *addr, uint32_t count) {
+    uint64_t key = (uint64_t)addr;
+    if (key == 0 || (key & 3) != 0 || key >= FUTEX_USER_LIMIT) {
+        return -1;
+    }
+
+    futex_bucket_t *bucket = futex_bucket_for(key);
+    process_t *woken = NULL;
+    uint32_t n = 0;
+
+    uint64_t flags = spinlock_acquire_irqsave(&bucket->lock);
+    process_t **link = &bucket->head;
+    while (*link != NULL && n < count) {
+        process_t *process = *link;
+        if (process->futex_addr != key) {
+            link = &process->wait_next;
+            continue;
+        }
+        *link = process->wait_next;
+        process->futex_addr = 0;
+        process->wait_next = woken;
+        woken = process;
+        n++;
+    }
+    spinlock_release_irqrestore(&bucket->lock, flags);
+
+    while (woken != NULL) {
+        process_t *next = woken->wait_next;
+        woken->wait_next = NULL;
+        timer_event_cancel(&woken->sleep_timer);
+        process_wake(woken, 0);
+        woken = next;
+    }
+    return (int32_t)n;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ProcessManager.h"
+#include "../Syscall/Syscall_Main.h"
+#include "../Sync/Sync_Main.h"
+#include "../Timer/Timer_Main.h"
+#include <stdint.h>
+
+#define PROCESS_STACK_PAGES 4
+#define PROCESS_STACK_SIZE (PROCESS_STACK_PAGES * 4096)
+#define PROCESS_KERNEL_STACK_PAGES 4
+#define PROCESS_KERNEL_STACK_SIZE (PROCESS_KERNEL_STACK_PAGES * 4096)
+#define PROCESS_RFLAGS_DEFAULT 0x202ULL
+#define PROCESS_STATE_UNUSED 0
+#define PROCESS_STATE_READY  1
+#define PROCESS_STATE_RUNNING 2
+#define PROCESS_STATE_DEAD 3
+#define PROCESS_STATE_BLOCKED 4
+#define PROCESS_STATE_ZOMBIE 5
+#define PROCESS_STATE_THROTTLED 6
+
+#define PROCESS_PRIORITY_LEVELS 40
+#define PROCESS_PRIORITY_DEFAULT (PROCESS_PRIORITY_LEVELS / 2)
+#define PROCESS_AFFINITY_ALL (~0ULL)
+
+typedef struct process {
+    int32_t pid;
+    int32_t tgid;
+    uint8_t state;
+    uint8_t priority;
+    uint8_t run_array;
+    uint8_t run_level;
+    uint8_t run_cpu;
+    uint8_t fpu_cpu;
+    volatile uint32_t on_cpu;
+    uint32_t wait_seq;
+    int32_t parent_pid;
+    int32_t exit_code;
+    uint64_t slice_end;
+    uint64_t affinity;
+    uint8_t policy;
+    uint8_t rt_level;
+    uint8_t sched_yielded;
+    uint8_t dl_cpu;
+    uint64_t dl_runtime;
+    uint64_t dl_period;
+    uint64_t dl_bandwidth;
+    uint64_t dl_deadline;
+    uint64_t dl_budget;
+    uint64_t dl_start;
+    uint8_t kernel_thread;
+    uint8_t in_kernel;
+    uint64_t account_mark;
+    uint64_t ready_since;
+    uint64_t user_tsc;
+    uint64_t system_tsc;
+    uint64_t wait_tsc;
+    uint64_t voluntary_switches;
+    uint64_t involuntary_switches;
+    uint64_t syscall_count;
+    uint32_t child_count;
+    uint64_t entry;
+    uint64_t kernel_rsp;
+    uint64_t wake_result;
+    uint64_t fs_base;
+    uint8_t *fpu_state;
+    uint8_t *stack_base;
+    uint8_t *kernel_stack;
+    struct process *run_prev;
+    struct process *run_next;
+    struct process *wait_next;
+    uint64_t futex_addr;
+    struct poll_set *poll_set;
+    wait_queue_t child_wait;
+    wait_queue_t exit_wait;
+    poll_source_t exit_poll;
+    timer_event_t sleep_timer;
+    timer_event_t dl_timer;
+} process_t;
+
+extern spinlock_t g_process_table_lock;
+
+process_t *process_lookup(int32_t pid);
+process_t *process_current(void);
+void process_release(process_t *process);
+void process_retire(process_t *process);
+
+void runqueue_init(void);
+void runqueue_enqueue(process_t *process);
+void process_set_current(process_t *process);
+uint64_t runqueue_slice_for(uint8_t priority);
+void process_wake(process_t *process, uint64_t result);
+process_t *process_block_prepare(void);
+uint64_t process_block_commit(void);
+uint64_t process_block_handoff(process_t *target, uint64_t result);
+void process_schedule(int requeue);
+void process_finish_switch(void);
+void process_sched_release(process_t *process);
+void process_thread_entry(void);
+void process_kernel_thread_entry(void);
+void futex_init(void);
+void process_save_user_state(process_t *process);
+void process_account_switch_in(process_t *process, uint64_t now);
+void process_account_switch_out(process_t *process, int requeue);
+void process_account_fill(const process_t *process, process_info_t *info, uint64_t now);
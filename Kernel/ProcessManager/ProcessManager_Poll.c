@@ -0,0 +1,423 @@
+#include "ProcessManager_Internal.h"
+#include "../Syscall/Syscall_File.h"
+#include <stddef.h>
+
+#define POLL_SET_MAX 8
+#define POLL_SET_ITEMS 64
+#define POLL_RESULT_TIMEOUT (-2)
+
+typedef struct poll_item {
+    uint8_t used;
+    uint8_t edge;
+    uint8_t on_ready;
+    uint32_t kind;
+    int32_t id;
+    uint32_t interest;
+    uint32_t fixed_mask;
+    uint64_t user_data;
+    poll_source_t *source;
+    struct poll_item *source_next;
+    struct poll_item *ready_next;
+    struct poll_set *set;
+} poll_item_t;
+
+// Sources push their watchers onto the ready list when their state
+// changes, so a wait only looks at items that may be ready. Level items
+// stay listed until a check finds them idle; edge items leave once
+// reported. One lock covers every set and every source's watcher list.
+typedef struct poll_set {
+    uint8_t used;
+    int32_t owner;
+    poll_item_t items[POLL_SET_ITEMS];
+    poll_item_t *ready_head;
+    poll_item_t *ready_tail;
+    process_t *waiters;
+} poll_set_t;
+
+static poll_set_t g_poll_sets[POLL_SET_MAX];
+static spinlock_t g_poll_lock = SPINLOCK_INIT;
+
+// Sets belong to the thread group that created them.
+static poll_set_t *poll_set_get(int32_t id) {
+    if (id < 0 || id >= POLL_SET_MAX || g_poll_sets[id].owner != process_current_tgid()) {
+        return NULL;
+    }
+    return &g_poll_sets[id];
+}
+
+static uint32_t poll_item_mask(const poll_item_t *item) {
+    uint32_t mask = item->source != NULL ? item->source->poll(item->source) : item->fixed_mask;
+    return mask & (item->interest | POLL_ERR | POLL_HUP);
+}
+
+static void poll_ready_push_locked(poll_item_t *item) {
+    if (item->on_ready) {
+        return;
+    }
+    poll_set_t *set = item->set;
+    item->on_ready = 1;
+    item->ready_next = NULL;
+    if (set->ready_tail != NULL) {
+        set->ready_tail->ready_next = item;
+    } else {
+        set->ready_head = item;
+    }
+    set->ready_tail = item;
+}
+
+static void poll_ready_unlink_locked(poll_set_t *set, poll_item_t *item, poll_item_t *prev) {
+    if (prev != NULL) {
+        prev->ready_next = item->ready_next;
+    } else {
+        set->ready_head = item->ready_next;
+    }
+    if (set->ready_tail == item) {
+        set->ready_tail = prev;
+    }
+    item->ready_next = NULL;
+    item->on_ready = 0;
+}
+
+static void poll_ready_remove_locked(poll_set_t *set, poll_item_t *item) {
+    poll_item_t *prev = NULL;
+    for (poll_item_t *it = set->ready_head; it != NULL; prev = it, it = it->ready_next) {
+        if (it == item) {
+            poll_ready_unlink_locked(set, item, prev);
+            return;
+        }
+    }
+}
+
+static void poll_source_unlink_locked(poll_item_t *item) {
+    if (item->source == NULL) {
+        return;
+    }
+    poll_item_t **link = &item->source->watchers;
+    while (*link != NULL && *link != item) {
+        link = &(*link)->source_next;
+    }
+    if (*link != NULL) {
+        *link = item->source_next;
+    }
+    item->source_next = NULL;
+    item->source = NULL;
+}
+
+// Moves the set's waiters onto *woken; they are woken after the lock.
+static void poll_take_waiters_locked(poll_set_t *set, process_t **woken) {
+    while (set->waiters != NULL) {
+        process_t *process = set->waiters;
+        set->waiters = process->wait_next;
+        process->poll_set = NULL;
+        process->wait_next = *woken;
+        *woken = process;
+    }
+}
+
+static void poll_wake_list(process_t *woken, uint64_t result) {
+    while (woken != NULL) {
+        process_t *next = woken->wait_next;
+        woken->wait_next = NULL;
+        timer_event_cancel(&woken->sleep_timer);
+        process_wake(woken, result);
+        woken = next;
+    }
+}
+
+void poll_source_init(poll_source_t *source, uint32_t (*poll)(poll_source_t *source)) {
+    source->watchers = NULL;
+    source->poll = poll;
+}
+
+// Called after the source's state changed. The fence pairs with the one
+// in poll_attach so a watcher added concurrently is either seen here or
+// sees the new state itself.
+void poll_source_notify(poll_source_t *source) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&source->watchers, __ATOMIC_RELAXED) == NULL) {
+        return;
+    }
+    process_t *woken = NULL;
+    uint64_t flags = spinlock_acquire_irqsave(&g_poll_lock);
+    for (poll_item_t *item = source->watchers; item != NULL; item = item->source_next) {
+        poll_ready_push_locked(item);
+        poll_take_waiters_locked(item->set, &woken);
+    }
+    spinlock_release_irqrestore(&g_poll_lock, flags);
+    poll_wake_list(woken, 0);
+}
+
+// The source is going away: its watchers stay in their sets and report
+// POLL_HUP until they are removed.
+void poll_source_detach(poll_source_t *source) {
+    process_t *woken = NULL;
+    uint64_t flags = spinlock_acquire_irqsave(&g_poll_lock);
+    while (source->watchers != NULL) {
+        poll_item_t *item = source->watchers;
+        source->watchers = item->source_next;
+        item->source_next = NULL;
+        item->source = NULL;
+        item->fixed_mask = POLL_HUP;
+        poll_ready_push_locked(item);
+        poll_take_waiters_locked(item->set, &woken);
+    }
+    spinlock_release_irqrestore(&g_poll_lock, flags);
+    poll_wake_list(woken, 0);
+}
+
+// Called by the owner of the source with its own lock held, which keeps
+// the source alive until it is linked. A NULL source is always ready with
+// fixed_mask.
+int32_t poll_attach(int32_t set_id, const poll_event_t *event, poll_source_t *source, uint32_t fixed_mask) {
+    poll_set_t *set = poll_set_get(set_id);
+    if (set == NULL) {
+        return -1;
+    }
+    process_t *woken = NULL;
+    uint64_t flags = spinlock_acquire_irqsave(&g_poll_lock);
+    poll_item_t *item = NULL;
+    for (uint32_t i = 0; set->used && i < POLL_SET_ITEMS; ++i) {
+        poll_item_t *it = &set->items[i];
+        if (it->used && it->kind == event->source && it->id == event->id) {
+            item = NULL;
+            break;
+        }
+        if (!it->used && item == NULL) {
+            item = it;
+        }
+    }
+    if (item == NULL) {
+        spinlock_release_irqrestore(&g_poll_lock, flags);
+        return -1;
+    }
+    item->used = 1;
+    item->kind = event->source;
+    item->id = event->id;
+    item->interest = event->events;
+    item->edge = (event->flags & POLL_EDGE) != 0;
+    item->user_data = event->user_data;
+    item->fixed_mask = fixed_mask;
+    item->set = set;
+    item->on_ready = 0;
+    item->source = source;
+    if (source != NULL) {
+        item->source_next = source->watchers;
+        __atomic_store_n(&source->watchers, item, __ATOMIC_SEQ_CST);
+    }
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (poll_item_mask(item) != 0) {
+        poll_ready_push_locked(item);
+        poll_take_waiters_locked(set, &woken);
+    }
+    spinlock_release_irqrestore(&g_poll_lock, flags);
+    poll_wake_list(woken, 0);
+    return 0;
+}
+
+static poll_item_t *poll_find_locked(poll_set_t *set, const poll_event_t *event) {
+    for (uint32_t i = 0; i < POLL_SET_ITEMS; ++i) {
+        poll_item_t *item = &set->items[i];
+        if (item->used && item->kind == event->source && item->id == event->id) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static void poll_item_free_locked(poll_set_t *set, poll_item_t *item) {
+    poll_source_unlink_locked(item);
+    if (item->on_ready) {
+        poll_ready_remove_locked(set, item);
+    }
+    item->used = 0;
+}
+
+int32_t poll_create(void) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_poll_lock);
+    for (int32_t id = 0; id < POLL_SET_MAX; ++id) {
+        poll_set_t *set = &g_poll_sets[id];
+        if (!set->used) {
+            for (uint32_t i = 0; i < POLL_SET_ITEMS; ++i) {
+                set->items[i].used = 0;
+            }
+            set->ready_head = NULL;
+            set->ready_tail = NULL;
+            set->waiters = NULL;
+            set->owner = process_current_tgid();
+            set->used = 1;
+            spinlock_release_irqrestore(&g_poll_lock, flags);
+            return id;
+        }
+    }
+    spinlock_release_irqrestore(&g_poll_lock, flags);
+    return -1;
+}
+
+static int32_t poll_set_free(poll_set_t *set, int32_t owner) {
+    process_t *woken = NULL;
+    uint64_t flags = spinlock_acquire_irqsave(&g_poll_lock);
+    if (!set->used || set->owner != owner) {
+        spinlock_release_irqrestore(&g_poll_lock, flags);
+        return -1;
+    }
+    for (uint32_t i = 0; i < POLL_SET_ITEMS; ++i) {
+        if (set->items[i].used) {
+            poll_item_free_locked(set, &set->items[i]);
+        }
+    }
+    set->used = 0;
+    set->owner = -1;
+    poll_take_waiters_locked(set, &woken);
+    spinlock_release_irqrestore(&g_poll_lock, flags);
+    poll_wake_list(woken, (uint64_t)-1);
+    return 0;
+}
+
+int32_t poll_destroy(int32_t set_id) {
+    poll_set_t *set = poll_set_get(set_id);
+    if (set == NULL) {
+        return -1;
+    }
+    return poll_set_free(set, process_current_tgid());
+}
+
+// Called once the last thread of tgid has exited.
+void poll_release_owner(int32_t tgid) {
+    for (int32_t id = 0; id < POLL_SET_MAX; ++id) {
+        if (g_poll_sets[id].owner == tgid) {
+            poll_set_free(&g_poll_sets[id], tgid);
+        }
+    }
+}
+
+int32_t poll_ctl(int32_t set_id, uint32_t op, const poll_event_t *event) {
+    poll_set_t *set = poll_set_get(set_id);
+    if (set == NULL || event == NULL) {
+        return -1;
+    }
+    if (op == POLL_CTL_ADD) {
+        switch (event->source) {
+        case POLL_SOURCE_FD:
+            return syscall_file_poll_attach(event->id, set_id, event);
+        case POLL_SOURCE_CHANNEL:
+            return channel_poll_attach(event->id, set_id, event);
+        case POLL_SOURCE_PROCESS:
+            return process_poll_attach(event->id, set_id, event);
+        default:
+            return -1;
+        }
+    }
+
+    int32_t rc = -1;
+    process_t *woken = NULL;
+    uint64_t flags = spinlock_acquire_irqsave(&g_poll_lock);
+    poll_item_t *item = set->used ? poll_find_locked(set, event) : NULL;
+    if (item != NULL && op == POLL_CTL_DEL) {
+        poll_item_free_locked(set, item);
+        rc = 0;
+    } else if (item != NULL && op == POLL_CTL_MOD) {
+        item->interest = event->events;
+        item->edge = (event->flags & POLL_EDGE) != 0;
+        item->user_data = event->user_data;
+        if (poll_item_mask(item) != 0) {
+            poll_ready_push_locked(item);
+            poll_take_waiters_locked(set, &woken);
+        }
+        rc = 0;
+    }
+    spinlock_release_irqrestore(&g_poll_lock, flags);
+    poll_wake_list(woken, 0);
+    return rc;
+}
+
+// Only walks the ready list, so the cost follows the number of ready
+// items rather than the number watched.
+static int32_t poll_collect_locked(poll_set_t *set, poll_event_t *out, uint32_t max) {
+    uint32_t n = 0;
+    poll_item_t *prev = NULL;
+    poll_item_t *item = set->ready_head;
+    while (item != NULL && n < max) {
+        poll_item_t *next = item->ready_next;
+        uint32_t mask = poll_item_mask(item);
+        if (mask != 0) {
+            out[n].source = item->kind;
+            out[n].id = item->id;
+            out[n].events = mask;
+            out[n].flags = item->edge ? POLL_EDGE : 0;
+            out[n].user_data = item->user_data;
+            n++;
+        }
+        if (mask == 0 || item->edge) {
+            poll_ready_unlink_locked(set, item, prev);
+        } else {
+            prev = item;
+        }
+        item = next;
+    }
+    return (int32_t)n;
+}
+
+static void poll_timeout(timer_event_t *event) {
+    process_t *process = (process_t *)((uint8_t *)event - offsetof(process_t, sleep_timer));
+    int expired = 0;
+    uint64_t flags = spinlock_acquire_irqsave(&g_poll_lock);
+    poll_set_t *set = process->poll_set;
+    if (set != NULL && process->wait_seq == event->cookie) {
+        process_t **link = &set->waiters;
+        while (*link != NULL && *link != process) {
+            link = &(*link)->wait_next;
+        }
+        if (*link != NULL) {
+            *link = process->wait_next;
+            process->wait_next = NULL;
+            process->poll_set = NULL;
+            expired = 1;
+        }
+    }
+    spinlock_release_irqrestore(&g_poll_lock, flags);
+    if (expired) {
+        process_wake(process, (uint64_t)(int64_t)POLL_RESULT_TIMEOUT);
+    }
+}
+
+// timeout_ns of 0 only checks, POLL_WAIT_FOREVER never times out.
+int32_t poll_wait(int32_t set_id, poll_event_t *out, uint32_t max, uint64_t timeout_ns) {
+    poll_set_t *set = poll_set_get(set_id);
+    if (set == NULL || out == NULL || max == 0) {
+        return -1;
+    }
+    uint64_t deadline = 0;
+    if (timeout_ns != 0 && timeout_ns != POLL_WAIT_FOREVER && timer_is_ready()) {
+        deadline = rdtsc() + timer_ns_to_tsc(timeout_ns);
+    }
+
+    int32_t n;
+    uint64_t flags = spinlock_acquire_irqsave(&g_poll_lock);
+    while (1) {
+        if (!set->used) {
+            n = -1;
+            break;
+        }
+        n = poll_collect_locked(set, out, max);
+        if (n != 0 || timeout_ns == 0) {
+            break;
+        }
+        process_t *process = process_block_prepare();
+        process->poll_set = set;
+        process->wait_next = set->waiters;
+        set->waiters = process;
+        if (deadline != 0) {
+            process->sleep_timer.callback = poll_timeout;
+            process->sleep_timer.cookie = process->wait_seq;
+            timer_event_add(&process->sleep_timer, deadline);
+        }
+        spinlock_release(&g_poll_lock);
+        int64_t result = (int64_t)process_block_commit();
+        spinlock_acquire(&g_poll_lock);
+        if (result == POLL_RESULT_TIMEOUT) {
+            timeout_ns = 0;
+        }
+    }
+    spinlock_release_irqrestore(&g_poll_lock, flags);
+    return n;
+}
@@ -0,0 +1,1012 @@
+#include "ProcessManager_Internal.h"
+#include "../APIC/APIC_Main.h"
+#include "../CPU/CPU_Main.h"
+#include "../FPU/FPU_Main.h"
+#include "../GDT/GDT_Main.h"
+#include "../Serial.h"
+#include "../Trace/Trace_Main.h"
+#include <stddef.h>
+
+#define PROCESS_NICE_MIN (-(PROCESS_PRIORITY_LEVELS / 2))
+#define PROCESS_NICE_MAX ((PROCESS_PRIORITY_LEVELS / 2) - 1)
+#define PROCESS_SLICE_UNIT_NS 500000ULL
+#define RUNQUEUE_BALANCE_INTERVAL 32
+#define RUNQUEUE_IMBALANCE_MIN 2
+#define RUNQUEUE_RT_ARRAY 2
+#define RUNQUEUE_DL_LIST 3
+#define PROCESS_RR_SLICE_NS 10000000ULL
+#define PROCESS_DL_RUNTIME_MIN_NS 50000ULL
+#define PROCESS_DL_PERIOD_MIN_NS 1000000ULL
+#define PROCESS_DL_PERIOD_MAX_NS 1000000000ULL
+#define PROCESS_DL_BW_SHIFT 20
+#define PROCESS_DL_BW_LIMIT ((9ULL << PROCESS_DL_BW_SHIFT) / 10)
+
+typedef struct {
+    uint64_t bitmap;
+    process_t *head[PROCESS_PRIORITY_LEVELS];
+    process_t *tail[PROCESS_PRIORITY_LEVELS];
+} process_prio_array_t;
+
+typedef struct {
+    spinlock_t lock;
+    // arrays[RUNQUEUE_RT_ARRAY] holds FIFO/RR tasks, dl_head is EDF order.
+    process_prio_array_t arrays[3];
+    process_prio_array_t *active;
+    process_prio_array_t *expired;
+    process_t *dl_head;
+    uint64_t dl_bandwidth;
+    volatile uint32_t nr_ready;
+    volatile uint32_t idle;
+    uint32_t balance_countdown;
+} process_runqueue_t;
+
+static process_runqueue_t g_runqueues[CPU_MAX];
+static spinlock_t g_dl_bandwidth_lock = SPINLOCK_INIT;
+
+extern void context_switch(uint64_t *prev_rsp, uint64_t next_rsp);
+
+static uint8_t process_run_level(const process_t *process) {
+    if (process->policy == PROCESS_POLICY_FIFO || process->policy == PROCESS_POLICY_RR) {
+        return process->rt_level;
+    }
+    return process->priority;
+}
+
+static void prio_array_push(process_runqueue_t *rq, process_prio_array_t *array, process_t *process) {
+    uint8_t level = process_run_level(process);
+    process->run_next = NULL;
+    process->run_prev = array->tail[level];
+    if (array->tail[level] != NULL) {
+        array->tail[level]->run_next = process;
+    } else {
+        array->head[level] = process;
+    }
+    array->tail[level] = process;
+    array->bitmap |= (1ULL << level);
+    process->run_array = (uint8_t)(array - rq->arrays);
+    process->run_level = level;
+}
+
+static void prio_array_push_front(process_runqueue_t *rq, process_prio_array_t *array, process_t *process) {
+    uint8_t level = process_run_level(process);
+    process->run_prev = NULL;
+    process->run_next = array->head[level];
+    if (array->head[level] != NULL) {
+        array->head[level]->run_prev = process;
+    } else {
+        array->tail[level] = process;
+    }
+    array->head[level] = process;
+    array->bitmap |= (1ULL << level);
+    process->run_array = (uint8_t)(array - rq->arrays);
+    process->run_level = level;
+}
+
+// Unlinks from the level the task was queued at, which may no longer match
+// its priority.
+static void prio_array_unlink(process_prio_array_t *array, process_t *process) {
+    uint8_t level = process->run_level;
+    if (process->run_prev != NULL) {
+        process->run_prev->run_next = process->run_next;
+    } else {
+        array->head[level] = process->run_next;
+    }
+    if (process->run_next != NULL) {
+        process->run_next->run_prev = process->run_prev;
+    } else {
+        array->tail[level] = process->run_prev;
+    }
+    process->run_prev = NULL;
+    process->run_next = NULL;
+    if (array->head[level] == NULL) {
+        array->bitmap &= ~(1ULL << level);
+    }
+}
+
+static void dl_list_insert(process_runqueue_t *rq, process_t *process) {
+    process_t *prev = NULL;
+    process_t *next = rq->dl_head;
+    while (next != NULL && next->dl_deadline <= process->dl_deadline) {
+        prev = next;
+        next = next->run_next;
+    }
+    process->run_prev = prev;
+    process->run_next = next;
+    if (prev != NULL) {
+        prev->run_next = process;
+    } else {
+        rq->dl_head = process;
+    }
+    if (next != NULL) {
+        next->run_prev = process;
+    }
+    process->run_array = RUNQUEUE_DL_LIST;
+}
+
+static void dl_list_unlink(process_runqueue_t *rq, process_t *process) {
+    if (process->run_prev != NULL) {
+        process->run_prev->run_next = process->run_next;
+    } else {
+        rq->dl_head = process->run_next;
+    }
+    if (process->run_next != NULL) {
+        process->run_next->run_prev = process->run_prev;
+    }
+    process->run_prev = NULL;
+    process->run_next = NULL;
+}
+
+// True if a ready task of class/priority `process` should take the CPU
+// from `current`. Normal tasks never preempt on wakeup.
+static int process_outranks(const process_t *process, const process_t *current) {
+    if (current == NULL || process->policy == PROCESS_POLICY_NORMAL) {
+        return 0;
+    }
+    if (process->policy == PROCESS_POLICY_DEADLINE) {
+        return current->policy != PROCESS_POLICY_DEADLINE || process->dl_deadline < current->dl_deadline;
+    }
+    if (current->policy == PROCESS_POLICY_DEADLINE) {
+        return 0;
+    }
+    return current->policy == PROCESS_POLICY_NORMAL || process->rt_level < current->rt_level;
+}
+
+uint64_t runqueue_slice_for(uint8_t priority) {
+    return timer_ns_to_tsc((uint64_t)(PROCESS_PRIORITY_LEVELS - priority) * PROCESS_SLICE_UNIT_NS);
+}
+
+// FIFO tasks run until they block or yield; a deadline task's slice is
+// whatever budget it has left in the current period.
+static void process_refresh_slice(process_t *process, uint64_t now) {
+    if (process->policy == PROCESS_POLICY_DEADLINE) {
+        process->dl_start = now;
+        process->slice_end = now + process->dl_budget;
+    } else if (process->policy == PROCESS_POLICY_FIFO) {
+        process->slice_end = 0;
+    } else if (process->slice_end == 0 || now >= process->slice_end) {
+        uint64_t length = process->policy == PROCESS_POLICY_RR ? timer_ns_to_tsc(PROCESS_RR_SLICE_NS)
+                                                                : runqueue_slice_for(process->priority);
+        process->slice_end = now + length;
+    }
+}
+
+static void process_dl_charge(process_t *process, uint64_t now) {
+    uint64_t used = now > process->dl_start ? now - process->dl_start : 0;
+    process->dl_budget = used < process->dl_budget ? process->dl_budget - used : 0;
+    process->dl_start = now;
+}
+
+// Constant bandwidth server rule: a task waking with more budget than it
+// could spend at its reserved rate before the old deadline starts afresh.
+static void process_dl_wakeup(process_t *process, uint64_t now) {
+    uint64_t left = process->dl_deadline > now ? process->dl_deadline - now : 0;
+    if (left == 0 ||
+        (unsigned __int128)process->dl_budget * process->dl_period >
+            (unsigned __int128)process->dl_runtime * left) {
+        process->dl_deadline = now + process->dl_period;
+        process->dl_budget = process->dl_runtime;
+    }
+}
+
+void runqueue_init(void) {
+    for (uint32_t c = 0; c < CPU_MAX; ++c) {
+        process_runqueue_t *rq = &g_runqueues[c];
+        rq->lock.locked = 0;
+        for (int a = 0; a < 3; ++a) {
+            rq->arrays[a].bitmap = 0;
+            for (int i = 0; i < PROCESS_PRIORITY_LEVELS; ++i) {
+                rq->arrays[a].head[i] = NULL;
+                rq->arrays[a].tail[i] = NULL;
+            }
+        }
+        rq->active = &rq->arrays[0];
+        rq->expired = &rq->arrays[1];
+        rq->dl_head = NULL;
+        rq->dl_bandwidth = 0;
+        rq->nr_ready = 0;
+        rq->idle = 0;
+        rq->balance_countdown = RUNQUEUE_BALANCE_INTERVAL;
+    }
+}
+
+static void runqueue_push_locked(process_runqueue_t *rq, uint32_t cpu_index, process_t *process) {
+    process->run_cpu = (uint8_t)cpu_index;
+    process->state = PROCESS_STATE_READY;
+    if (process->ready_since == 0) {
+        process->ready_since = rdtsc();
+    }
+    if (process->policy == PROCESS_POLICY_DEADLINE) {
+        dl_list_insert(rq, process);
+    } else if (process->policy != PROCESS_POLICY_NORMAL) {
+        prio_array_push(rq, &rq->arrays[RUNQUEUE_RT_ARRAY], process);
+    } else {
+        prio_array_push(rq, rq->active, process);
+    }
+    rq->nr_ready++;
+}
+
+static void runqueue_remove_locked(process_runqueue_t *rq, process_t *process) {
+    if (process->run_array == RUNQUEUE_DL_LIST) {
+        dl_list_unlink(rq, process);
+    } else {
+        prio_array_unlink(&rq->arrays[process->run_array], process);
+    }
+    rq->nr_ready--;
+}
+
+static process_t *runqueue_pop_normal_locked(process_runqueue_t *rq) {
+    if (rq->active->bitmap == 0) {
+        process_prio_array_t *swap = rq->active;
+        rq->active = rq->expired;
+        rq->expired = swap;
+        if (rq->active->bitmap == 0) {
+            return NULL;
+        }
+    }
+
+    uint8_t level = (uint8_t)__builtin_ctzll(rq->active->bitmap);
+    process_t *next = rq->active->head[level];
+    prio_array_unlink(rq->active, next);
+    rq->nr_ready--;
+    next->state = PROCESS_STATE_RUNNING;
+    return next;
+}
+
+static process_t *runqueue_pop_locked(process_runqueue_t *rq) {
+    process_t *next = rq->dl_head;
+    if (next != NULL) {
+        dl_list_unlink(rq, next);
+    } else if (rq->arrays[RUNQUEUE_RT_ARRAY].bitmap != 0) {
+        process_prio_array_t *rt = &rq->arrays[RUNQUEUE_RT_ARRAY];
+        next = rt->head[__builtin_ctzll(rt->bitmap)];
+        prio_array_unlink(rt, next);
+    } else {
+        return runqueue_pop_normal_locked(rq);
+    }
+    rq->nr_ready--;
+    next->state = PROCESS_STATE_RUNNING;
+    return next;
+}
+
+static void runqueue_requeue_yielded(process_runqueue_t *rq, uint32_t cpu_index, process_t *process) {
+    process->run_cpu = (uint8_t)cpu_index;
+    process->state = PROCESS_STATE_READY;
+    process->ready_since = rdtsc();
+    if (process->policy != PROCESS_POLICY_NORMAL) {
+        // A preempted RT task goes back to the front of its level; yields
+        // and expired RR slices rotate to the back.
+        int rotate = process->sched_yielded ||
+                     (process->policy == PROCESS_POLICY_RR && rdtsc() >= process->slice_end);
+        process->sched_yielded = 0;
+        if (rotate) {
+            process->slice_end = 0;
+            prio_array_push(rq, &rq->arrays[RUNQUEUE_RT_ARRAY], process);
+        } else {
+            prio_array_push_front(rq, &rq->arrays[RUNQUEUE_RT_ARRAY], process);
+        }
+    } else if (process->slice_end != 0 && rdtsc() < process->slice_end) {
+        prio_array_push(rq, rq->active, process);
+    } else {
+        process->slice_end = 0;
+        prio_array_push(rq, rq->expired, process);
+    }
+    rq->nr_ready++;
+}
+
+static uint32_t runqueue_load(uint32_t cpu_index) {
+    cpu_local_t *cpu = cpu_get(cpu_index);
+    return g_runqueues[cpu_index].nr_ready + (cpu->current_task != NULL ? 1u : 0u);
+}
+
+static int process_allowed(const process_t *process, uint32_t cpu_index) {
+    return cpu_index < 64 && ((process->affinity >> cpu_index) & 1) != 0;
+}
+
+// 0 when the CPUs share an L2, 1 when they share the last-level cache.
+static uint32_t cpu_distance(uint32_t a, uint32_t b) {
+    cpu_local_t *x = cpu_get(a);
+    cpu_local_t *y = cpu_get(b);
+    if (x->l2_id == y->l2_id) {
+        return 0;
+    }
+    return x->llc_id == y->llc_id ? 1 : 2;
+}
+
+// A task stays on the CPU it last ran on while that CPU is idle, or while
+// no allowed CPU is idle and the imbalance is below RUNQUEUE_IMBALANCE_MIN.
+// Otherwise the least loaded allowed CPU wins, ties going to the one that
+// shares the most cache with the old CPU.
+static uint32_t runqueue_select_cpu(const process_t *process) {
+    uint32_t prev = process->run_cpu;
+    int prev_ok = prev < cpu_count() && cpu_get(prev)->online && process_allowed(process, prev);
+    uint32_t prev_load = prev_ok ? runqueue_load(prev) : UINT32_MAX;
+    if (prev_load == 0) {
+        return prev;
+    }
+
+    uint32_t home = prev_ok ? prev : cpu_current()->index;
+    uint32_t best = UINT32_MAX;
+    uint32_t best_load = UINT32_MAX;
+    uint32_t best_distance = UINT32_MAX;
+    for (uint32_t i = 0; i < cpu_count(); ++i) {
+        if (!cpu_get(i)->online || !process_allowed(process, i)) {
+            continue;
+        }
+        uint32_t load = runqueue_load(i);
+        uint32_t distance = cpu_distance(home, i);
+        if (load < best_load || (load == best_load && distance < best_distance)) {
+            best = i;
+            best_load = load;
+            best_distance = distance;
+        }
+    }
+    if (best == UINT32_MAX) {
+        return home;
+    }
+    if (prev_ok && best_load != 0 && prev_load < best_load + RUNQUEUE_IMBALANCE_MIN) {
+        return prev;
+    }
+    return best;
+}
+
+static void runqueue_kick(uint32_t cpu_index) {
+    if (cpu_index == cpu_current()->index || !apic_is_ready()) {
+        return;
+    }
+    apic_send_ipi(cpu_get(cpu_index)->lapic_id, APIC_VECTOR_RESCHEDULE);
+}
+
+static void runqueue_kick_idle(uint32_t self) {
+    for (uint32_t i = 0; i < cpu_count(); ++i) {
+        if (i != self && g_runqueues[i].idle) {
+            runqueue_kick(i);
+            return;
+        }
+    }
+}
+
+// Prefers CPUs that are not already running a real-time or deadline task.
+static uint32_t runqueue_rt_target(const process_t *process) {
+    uint32_t best = cpu_current()->index;
+    uint32_t best_score = UINT32_MAX;
+    for (uint32_t i = 0; i < cpu_count(); ++i) {
+        cpu_local_t *cpu = cpu_get(i);
+        if (!cpu->online || !process_allowed(process, i)) {
+            continue;
+        }
+        process_t *current = (process_t *)cpu->current_task;
+        uint32_t score = runqueue_load(i);
+        if (current != NULL && current->policy != PROCESS_POLICY_NORMAL) {
+            score += 0x10000;
+        }
+        if (score < best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+static void runqueue_arm_slice(uint32_t self) {
+    process_t *current = process_current();
+    if (current == NULL || current->policy == PROCESS_POLICY_FIFO) {
+        timer_set_slice_end(0);
+    } else if (current->policy == PROCESS_POLICY_DEADLINE || g_runqueues[self].nr_ready != 0) {
+        timer_set_slice_end(current->slice_end);
+    } else {
+        timer_set_slice_end(0);
+    }
+}
+
+void runqueue_enqueue(process_t *process) {
+    uint32_t self = cpu_current()->index;
+    uint32_t target;
+    if (process->policy == PROCESS_POLICY_DEADLINE) {
+        if (process->state == PROCESS_STATE_BLOCKED) {
+            process_dl_wakeup(process, rdtsc());
+        }
+        target = process->dl_cpu;
+    } else if (process->policy != PROCESS_POLICY_NORMAL) {
+        target = runqueue_rt_target(process);
+    } else {
+        target = runqueue_select_cpu(process);
+    }
+    process_runqueue_t *rq = &g_runqueues[target];
+    cpu_local_t *target_cpu = cpu_get(target);
+    TRACE(SCHED_WAKEUP, process->pid, target, 0);
+
+    uint64_t flags = spinlock_acquire_irqsave(&rq->lock);
+    runqueue_push_locked(rq, target, process);
+    int contended = rq->idle || rq->nr_ready == 1;
+    int preempt = process_outranks(process, (process_t *)target_cpu->current_task);
+    spinlock_release_irqrestore(&rq->lock, flags);
+
+    if (preempt) {
+        target_cpu->need_resched = 1;
+    }
+    if (target == self) {
+        runqueue_arm_slice(self);
+    } else if (contended || preempt) {
+        runqueue_kick(target);
+    }
+}
+
+// Highest priority normal task that may run on cpu_index; real-time and
+// deadline tasks are placed at enqueue and never stolen.
+static process_t *runqueue_pop_allowed_locked(process_runqueue_t *rq, uint32_t cpu_index) {
+    process_prio_array_t *arrays[2] = {rq->active, rq->expired};
+    for (uint32_t a = 0; a < 2; ++a) {
+        uint64_t bitmap = arrays[a]->bitmap;
+        while (bitmap != 0) {
+            uint8_t level = (uint8_t)__builtin_ctzll(bitmap);
+            bitmap &= bitmap - 1;
+            for (process_t *process = arrays[a]->head[level]; process != NULL; process = process->run_next) {
+                if (process_allowed(process, cpu_index)) {
+                    prio_array_unlink(arrays[a], process);
+                    rq->nr_ready--;
+                    process->state = PROCESS_STATE_RUNNING;
+                    return process;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+static process_t *runqueue_steal(uint32_t self, uint32_t min_ready) {
+    uint32_t victim = self;
+    uint32_t victim_ready = 0;
+    uint32_t victim_distance = UINT32_MAX;
+    for (uint32_t i = 0; i < cpu_count(); ++i) {
+        uint32_t ready = g_runqueues[i].nr_ready;
+        if (i == self || ready < min_ready || ready < victim_ready) {
+            continue;
+        }
+        uint32_t distance = cpu_distance(self, i);
+        if (ready > victim_ready || distance < victim_distance) {
+            victim = i;
+            victim_ready = ready;
+            victim_distance = distance;
+        }
+    }
+    if (victim == self) {
+        return NULL;
+    }
+
+    process_runqueue_t *rq = &g_runqueues[victim];
+    spinlock_acquire(&rq->lock);
+    process_t *stolen = rq->nr_ready >= min_ready ? runqueue_pop_allowed_locked(rq, self) : NULL;
+    spinlock_release(&rq->lock);
+    return stolen;
+}
+
+static process_t *runqueue_next(uint32_t self) {
+    process_runqueue_t *rq = &g_runqueues[self];
+
+    if (--rq->balance_countdown == 0) {
+        rq->balance_countdown = RUNQUEUE_BALANCE_INTERVAL;
+        process_t *pulled = runqueue_steal(self, rq->nr_ready + RUNQUEUE_IMBALANCE_MIN);
+        if (pulled != NULL) {
+            spinlock_acquire(&rq->lock);
+            runqueue_push_locked(rq, self, pulled);
+            spinlock_release(&rq->lock);
+        }
+    }
+
+    spinlock_acquire(&rq->lock);
+    process_t *next = runqueue_pop_locked(rq);
+    uint32_t remaining = rq->nr_ready;
+    spinlock_release(&rq->lock);
+
+    if (next == NULL) {
+        return runqueue_steal(self, 1);
+    }
+    if (remaining != 0) {
+        runqueue_kick_idle(self);
+    }
+    return next;
+}
+
+void process_reschedule_ipi(void) {
+    runqueue_arm_slice(cpu_current()->index);
+}
+
+uint32_t process_current_cpu(void) {
+    return cpu_current()->index;
+}
+
+// run_cpu only changes under the lock of the queue the task moves to, so
+// once it reads the same with that lock held the task cannot be linked on
+// any other queue.
+static process_runqueue_t *runqueue_lock_task(process_t *process) {
+    while (1) {
+        uint32_t cpu_index = __atomic_load_n(&process->run_cpu, __ATOMIC_ACQUIRE);
+        process_runqueue_t *rq = &g_runqueues[cpu_index];
+        spinlock_acquire(&rq->lock);
+        if (__atomic_load_n(&process->run_cpu, __ATOMIC_ACQUIRE) == cpu_index) {
+            return rq;
+        }
+        spinlock_release(&rq->lock);
+    }
+}
+
+// Pushes store run_cpu before state, so state is read first: a READY left
+// by a push onto another queue comes with that queue's run_cpu.
+static int runqueue_task_queued_locked(process_runqueue_t *rq, process_t *process) {
+    return __atomic_load_n(&process->state, __ATOMIC_ACQUIRE) == PROCESS_STATE_READY &&
+           &g_runqueues[__atomic_load_n(&process->run_cpu, __ATOMIC_ACQUIRE)] == rq;
+}
+
+static process_t *process_resolve(int32_t pid) {
+    return pid < 0 ? process_current() : process_lookup(pid);
+}
+
+int32_t process_set_priority(int32_t pid, int32_t nice) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_t *process = process_resolve(pid);
+    if (process == NULL || process->state == PROCESS_STATE_DEAD || process->state == PROCESS_STATE_ZOMBIE) {
+        spinlock_release_irqrestore(&g_process_table_lock, flags);
+        return -1;
+    }
+    if (nice < PROCESS_NICE_MIN) {
+        nice = PROCESS_NICE_MIN;
+    }
+    if (nice > PROCESS_NICE_MAX) {
+        nice = PROCESS_NICE_MAX;
+    }
+
+    uint8_t priority = (uint8_t)(nice - PROCESS_NICE_MIN);
+    process_runqueue_t *rq = runqueue_lock_task(process);
+    if (runqueue_task_queued_locked(rq, process)) {
+        runqueue_remove_locked(rq, process);
+        process->priority = priority;
+        runqueue_push_locked(rq, (uint32_t)(rq - g_runqueues), process);
+    } else {
+        process->priority = priority;
+    }
+    process->slice_end = 0;
+    spinlock_release(&rq->lock);
+    spinlock_release_irqrestore(&g_process_table_lock, flags);
+    return 0;
+}
+
+// A running task that loses its CPU is moved at its next reschedule. A
+// deadline task cannot be moved off the CPU holding its reservation.
+int32_t process_set_affinity(int32_t pid, uint64_t mask) {
+    if ((mask & cpu_online_mask()) == 0) {
+        return -1;
+    }
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_t *process = process_resolve(pid);
+    if (process == NULL || process->state == PROCESS_STATE_DEAD || process->state == PROCESS_STATE_ZOMBIE ||
+        (process->policy == PROCESS_POLICY_DEADLINE && ((mask >> process->dl_cpu) & 1) == 0)) {
+        spinlock_release_irqrestore(&g_process_table_lock, flags);
+        return -1;
+    }
+
+    process->affinity = mask;
+    process_runqueue_t *rq = runqueue_lock_task(process);
+    uint32_t cpu_index = (uint32_t)(rq - g_runqueues);
+    int moved = 0;
+    int kick = 0;
+    if (!process_allowed(process, cpu_index)) {
+        if (runqueue_task_queued_locked(rq, process)) {
+            runqueue_remove_locked(rq, process);
+            moved = 1;
+        } else if (process->state == PROCESS_STATE_RUNNING) {
+            cpu_get(cpu_index)->need_resched = 1;
+            kick = 1;
+        }
+    }
+    spinlock_release(&rq->lock);
+    if (moved) {
+        runqueue_enqueue(process);
+    } else if (kick) {
+        runqueue_kick(cpu_index);
+    }
+    spinlock_release_irqrestore(&g_process_table_lock, flags);
+    return 0;
+}
+
+int32_t process_get_affinity(int32_t pid, uint64_t *mask_out) {
+    if (mask_out == NULL) {
+        return -1;
+    }
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_t *process = process_resolve(pid);
+    int32_t result = -1;
+    if (process != NULL && process->state != PROCESS_STATE_DEAD && process->state != PROCESS_STATE_ZOMBIE) {
+        *mask_out = process->affinity;
+        result = 0;
+    }
+    spinlock_release_irqrestore(&g_process_table_lock, flags);
+    return result;
+}
+
+int32_t process_get_priority(int32_t pid) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_process_table_lock);
+    process_t *process = process_resolve(pid);
+    int32_t result = -1;
+    if (process != NULL && process->state != PROCESS_STATE_DEAD && process->state != PROCESS_STATE_ZOMBIE) {
+        result = PROCESS_NICE_MAX + 1 - ((int32_t)process->priority + PROCESS_NICE_MIN);
+    }
+    spinlock_release_irqrestore(&g_process_table_lock, flags);
+    return result;
+}
+
+void process_save_user_state(process_t *process) {
+    if (cpu_has_fsgsbase()) {
+        process->fs_base = cpu_read_fs_base();
+    }
+    if (process->fpu_state != NULL && cpu_current()->fpu_owner == process->fpu_state) {
+        fpu_save(process->fpu_state);
+    }
+    fpu_trap_next_use();
+}
+
+static void process_fpu_switch_in(cpu_local_t *cpu, process_t *next) {
+    if (next->fpu_state == NULL) {
+        fpu_trap_next_use();
+        return;
+    }
+    fpu_clear_trap();
+    if (cpu->fpu_owner != next->fpu_state || next->fpu_cpu != cpu->index) {
+        fpu_restore(next->fpu_state);
+        cpu->fpu_owner = next->fpu_state;
+        next->fpu_cpu = (uint8_t)cpu->index;
+    }
+}
+
+void process_fpu_trap(void) {
+    cpu_local_t *cpu = cpu_current();
+    process_t *current = process_current();
+
+    fpu_clear_trap();
+    cpu->fpu_owner = NULL;
+    if (current == NULL) {
+        return;
+    }
+    if (current->fpu_state == NULL) {
+        current->fpu_state = fpu_state_alloc();
+        if (current->fpu_state == NULL) {
+            serial_write_string("[OS] [PROC] FPU state allocation failed\n");
+            return;
+        }
+    }
+    fpu_restore(current->fpu_state);
+    cpu->fpu_owner = current->fpu_state;
+    current->fpu_cpu = (uint8_t)cpu->index;
+}
+
+static uint64_t process_kernel_stack_top(process_t *process) {
+    return (uint64_t)(process->kernel_stack + PROCESS_KERNEL_STACK_SIZE);
+}
+
+static void process_switch_in(cpu_local_t *cpu, process_t *next) {
+    next->run_cpu = (uint8_t)cpu->index;
+    next->state = PROCESS_STATE_RUNNING;
+    process_account_switch_in(next, rdtsc());
+    process_refresh_slice(next, rdtsc());
+    process_set_current(next);
+    cpu->kernel_rsp = process_kernel_stack_top(next);
+    gdt_set_kernel_stack(cpu->index, cpu->kernel_rsp);
+    cpu_write_fs_base(next->fs_base);
+    process_fpu_switch_in(cpu, next);
+    runqueue_arm_slice(cpu->index);
+}
+
+static void process_switch_to(cpu_local_t *cpu, process_t *prev, process_t *next) {
+    uint64_t *prev_rsp = prev != NULL ? &prev->kernel_rsp : &cpu->idle_rsp;
+    uint64_t next_rsp;
+    TRACE(SCHED_SWITCH, prev != NULL ? (uint32_t)prev->pid : UINT32_MAX,
+          next != NULL ? (uint32_t)next->pid : UINT32_MAX, prev != NULL ? prev->state : 0);
+    if (next != NULL) {
+        next->on_cpu = 1;
+        process_switch_in(cpu, next);
+        next_rsp = next->kernel_rsp;
+    } else {
+        process_set_current(NULL);
+        timer_set_slice_end(0);
+        next_rsp = cpu->idle_rsp;
+    }
+    cpu->switch_prev = prev;
+    context_switch(prev_rsp, next_rsp);
+    process_finish_switch();
+}
+
+static void process_dl_replenish(timer_event_t *event) {
+    process_t *process = (process_t *)((uint8_t *)event - offsetof(process_t, dl_timer));
+    if (process->state != PROCESS_STATE_THROTTLED) {
+        return;
+    }
+    uint64_t now = rdtsc();
+    process->dl_deadline += process->dl_period;
+    if (process->dl_deadline <= now) {
+        process->dl_deadline = now + process->dl_period;
+    }
+    process->dl_budget = process->dl_runtime;
+    runqueue_enqueue(process);
+}
+
+// A deadline task that used up its budget or yielded sleeps until its
+// current deadline, which is where the next period starts.
+static void process_dl_requeue(process_t *process) {
+    int yielded = process->sched_yielded;
+    process->sched_yielded = 0;
+    if (yielded || process->dl_budget == 0) {
+        process->state = PROCESS_STATE_THROTTLED;
+        process->dl_timer.callback = process_dl_replenish;
+        timer_event_add(&process->dl_timer, process->dl_deadline);
+        return;
+    }
+    runqueue_enqueue(process);
+}
+
+void process_finish_switch(void) {
+    cpu_local_t *cpu = cpu_current();
+    process_t *prev = (process_t *)cpu->switch_prev;
+    cpu->switch_prev = NULL;
+    if (prev == NULL) {
+        return;
+    }
+
+    uint8_t state = prev->state;
+    __atomic_store_n(&prev->on_cpu, 0, __ATOMIC_RELEASE);
+    if (state == PROCESS_STATE_DEAD) {
+        process_retire(prev);
+    } else if (cpu->switch_requeue && prev->policy == PROCESS_POLICY_DEADLINE) {
+        process_dl_requeue(prev);
+    } else if (cpu->switch_requeue && !process_allowed(prev, cpu->index)) {
+        prev->sched_yielded = 0;
+        runqueue_enqueue(prev);
+    } else if (cpu->switch_requeue) {
+        process_runqueue_t *rq = &g_runqueues[cpu->index];
+        spinlock_acquire(&rq->lock);
+        runqueue_requeue_yielded(rq, cpu->index, prev);
+        spinlock_release(&rq->lock);
+    }
+}
+
+// Real-time and deadline tasks keep the CPU on a slice expiry or preempt
+// point unless something of a higher class or priority is waiting.
+static int process_keep_running(uint32_t self, process_t *prev, uint64_t now) {
+    if (prev->sched_yielded) {
+        return 0;
+    }
+    process_runqueue_t *rq = &g_runqueues[self];
+    int keep;
+    spinlock_acquire(&rq->lock);
+    if (prev->policy == PROCESS_POLICY_DEADLINE) {
+        keep = prev->dl_budget != 0 && prev->dl_cpu == self &&
+               (rq->dl_head == NULL || rq->dl_head->dl_deadline >= prev->dl_deadline);
+    } else {
+        process_prio_array_t *rt = &rq->arrays[RUNQUEUE_RT_ARRAY];
+        keep = rq->dl_head == NULL;
+        if (keep && rt->bitmap != 0) {
+            uint8_t level = (uint8_t)__builtin_ctzll(rt->bitmap);
+            int expired = prev->policy == PROCESS_POLICY_RR && now >= prev->slice_end;
+            keep = level > prev->rt_level || (level == prev->rt_level && !expired);
+        }
+    }
+    spinlock_release(&rq->lock);
+    return keep;
+}
+
+void process_schedule(int requeue) {
+    uint64_t flags = irq_save_disable();
+    cpu_local_t *cpu = cpu_current();
+    process_t *prev = process_current();
+    uint64_t now = rdtsc();
+    cpu->need_resched = 0;
+
+    if (prev->policy == PROCESS_POLICY_DEADLINE) {
+        process_dl_charge(prev, now);
+    }
+    int allowed = process_allowed(prev, cpu->index);
+    if (requeue && allowed && prev->policy != PROCESS_POLICY_NORMAL && process_keep_running(cpu->index, prev, now)) {
+        process_refresh_slice(prev, now);
+        runqueue_arm_slice(cpu->index);
+        irq_restore(flags);
+        return;
+    }
+
+    process_t *next = runqueue_next(cpu->index);
+    if (next == NULL && requeue && allowed && prev->policy != PROCESS_POLICY_DEADLINE) {
+        prev->sched_yielded = 0;
+        process_refresh_slice(prev, now);
+        irq_restore(flags);
+        return;
+    }
+
+    process_save_user_state(prev);
+    process_account_switch_out(prev, requeue);
+    cpu->switch_requeue = (uint32_t)requeue;
+    process_switch_to(cpu, prev, next);
+    irq_restore(flags);
+}
+
+// The caller, already marked blocked, gives its CPU straight to target
+// without a trip through the run queue or runqueue_next(). Meant for
+// synchronous IPC where target is the only one that can make progress;
+// falls back to an ordinary wake when target may not run here.
+uint64_t process_block_handoff(process_t *target, uint64_t result) {
+    uint64_t flags = irq_save_disable();
+    cpu_local_t *cpu = cpu_current();
+    process_t *prev = process_current();
+    while (__atomic_load_n(&target->on_cpu, __ATOMIC_ACQUIRE)) {
+        __asm__ volatile ("pause");
+    }
+    target->wake_result = result;
+
+    if (target->policy == PROCESS_POLICY_DEADLINE || !process_allowed(target, cpu->index)) {
+        runqueue_enqueue(target);
+        process_schedule(0);
+    } else {
+        if (prev->policy == PROCESS_POLICY_DEADLINE) {
+            process_dl_charge(prev, rdtsc());
+        }
+        process_save_user_state(prev);
+        process_account_switch_out(prev, 0);
+        cpu->switch_requeue = 0;
+        process_switch_to(cpu, prev, target);
+    }
+    irq_restore(flags);
+    return prev->wake_result;
+}
+
+static int32_t runqueue_dl_admit(const process_t *process, uint64_t bandwidth) {
+    int32_t best = -1;
+    for (uint32_t i = 0; i < cpu_count(); ++i) {
+        if (!cpu_get(i)->online || !process_allowed(process, i) ||
+            g_runqueues[i].dl_bandwidth + bandwidth > PROCESS_DL_BW_LIMIT) {
+            continue;
+        }
+        if (best < 0 || g_runqueues[i].dl_bandwidth < g_runqueues[best].dl_bandwidth) {
+            best = (int32_t)i;
+        }
+    }
+    if (best >= 0) {
+        g_runqueues[best].dl_bandwidth += bandwidth;
+    }
+    return best;
+}
+
+// Changes the calling task's scheduling class. param is the RT priority
+// (1..PROCESS_RT_PRIORITY_MAX, higher runs first) for FIFO/RR and the
+// runtime in ns for DEADLINE, whose deadline equals its period. Deadline
+// tasks are admitted only while their CPU stays under 90% reserved.
+int32_t process_sched_set(int32_t policy, uint64_t param, uint64_t period_ns) {
+    process_t *current = process_current();
+    if (current == NULL) {
+        return -1;
+    }
+    uint8_t rt_level = 0;
+    uint64_t bandwidth = 0;
+    switch (policy) {
+    case PROCESS_POLICY_NORMAL:
+        break;
+    case PROCESS_POLICY_FIFO:
+    case PROCESS_POLICY_RR:
+        if (param < 1 || param > PROCESS_RT_PRIORITY_MAX) {
+            return -1;
+        }
+        rt_level = (uint8_t)(PROCESS_RT_PRIORITY_MAX - param);
+        break;
+    case PROCESS_POLICY_DEADLINE:
+        if (!timer_is_ready() || period_ns < PROCESS_DL_PERIOD_MIN_NS || period_ns > PROCESS_DL_PERIOD_MAX_NS ||
+            param < PROCESS_DL_RUNTIME_MIN_NS || param > period_ns) {
+            return -1;
+        }
+        bandwidth = (param << PROCESS_DL_BW_SHIFT) / period_ns;
+        break;
+    default:
+        return -1;
+    }
+
+    uint64_t flags = irq_save_disable();
+    cpu_local_t *cpu = cpu_current();
+    spinlock_acquire(&g_dl_bandwidth_lock);
+    if (current->policy == PROCESS_POLICY_DEADLINE) {
+        g_runqueues[current->dl_cpu].dl_bandwidth -= current->dl_bandwidth;
+    }
+    int32_t dl_cpu = policy == PROCESS_POLICY_DEADLINE ? runqueue_dl_admit(current, bandwidth) : 0;
+    if (dl_cpu < 0 && current->policy == PROCESS_POLICY_DEADLINE) {
+        g_runqueues[current->dl_cpu].dl_bandwidth += current->dl_bandwidth;
+    }
+    spinlock_release(&g_dl_bandwidth_lock);
+    if (dl_cpu < 0) {
+        irq_restore(flags);
+        return -1;
+    }
+
+    uint64_t now = rdtsc();
+    current->policy = (uint8_t)policy;
+    current->rt_level = rt_level;
+    current->sched_yielded = 0;
+    current->dl_cpu = (uint8_t)dl_cpu;
+    current->dl_bandwidth = bandwidth;
+    if (policy == PROCESS_POLICY_DEADLINE) {
+        current->dl_runtime = timer_ns_to_tsc(param);
+        current->dl_period = timer_ns_to_tsc(period_ns);
+        current->dl_deadline = now + current->dl_period;
+        current->dl_budget = current->dl_runtime;
+    }
+    current->slice_end = 0;
+    process_refresh_slice(current, now);
+    // Let the next resched check place the task under its new class.
+    cpu->need_resched = 1;
+    runqueue_arm_slice(cpu->index);
+    irq_restore(flags);
+    return 0;
+}
+
+void process_sched_release(process_t *process) {
+    if (process->policy != PROCESS_POLICY_DEADLINE) {
+        return;
+    }
+    uint64_t flags = spinlock_acquire_irqsave(&g_dl_bandwidth_lock);
+    g_runqueues[process->dl_cpu].dl_bandwidth -= process->dl_bandwidth;
+    spinlock_release_irqrestore(&g_dl_bandwidth_lock, flags);
+    process->policy = PROCESS_POLICY_NORMAL;
+}
+
+// A yield from a real-time task rotates it behind its peers; a deadline
+// task gives up the rest of its budget and waits for its next period.
+void process_sched_yield(void) {
+    process_t *current = process_current();
+    if (current == NULL) {
+        return;
+    }
+    if (current->policy != PROCESS_POLICY_NORMAL) {
+        current->sched_yielded = 1;
+    }
+    process_schedule(1);
+}
+
+void process_yield_current(void) {
+    if (process_current() != NULL) {
+        process_schedule(1);
+    }
+}
+
+void process_check_resched(void) {
+    cpu_local_t *cpu = cpu_current();
+    if (cpu->need_resched && cpu->current_task != NULL) {
+        process_yield_current();
+    }
+}
+
+// Long kernel loops call this between units of work; it only switches
+// when interrupts are on, so it is a no-op under spinlocks.
+void process_preempt_point(void) {
+    cpu_local_t *cpu = cpu_current();
+    if (cpu->need_resched && cpu->current_task != NULL && irq_enabled()) {
+        process_schedule(1);
+    }
+}
+
+void process_idle_loop(void) {
+    cpu_local_t *cpu = cpu_current();
+    process_runqueue_t *rq = &g_runqueues[cpu->index];
+
+    process_set_current(NULL);
+    timer_set_slice_end(0);
+    while (1) {
+        __asm__ volatile ("cli");
+        process_t *next = runqueue_next(cpu->index);
+        if (next != NULL) {
+            rq->idle = 0;
+            cpu->switch_requeue = 0;
+            process_switch_to(cpu, NULL, next);
+            continue;
+        }
+
+        spinlock_acquire(&rq->lock);
+        rq->idle = rq->nr_ready == 0;
+        spinlock_release(&rq->lock);
+        if (rq->idle) {
+            cpu_idle_wait(&rq->nr_ready);
+            cpu->idle_wakeups++;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+BITS 64
+section .text
+global context_switch
+global process_thread_entry
+global process_kernel_thread_entry
+extern process_finish_switch
+extern process_exit_current
+extern syscall_exit
+
+; void context_switch(uint64_t *prev_rsp, uint64_t next_rsp)
+context_switch:
+    push rbp
+    push rbx
+    push r12
+    push r13
+    push r14
+    push r15
+
+    mov [rdi], rsp
+    mov rsp, rsi
+
+    pop r15
+    pop r14
+    pop r13
+    pop r12
+    pop rbx
+    pop rbp
+    ret
+
+; First switch into a new thread lands here with rsp at its syscall frame.
+process_thread_entry:
+    call process_finish_switch
+    jmp syscall_exit
+
+; Kernel threads start here with the entry point in r12 and its argument in r13.
+process_kernel_thread_entry:
+    call process_finish_switch
+    sti
+    mov rdi, r13
+    call r12
+    xor edi, edi
+    call process_exit_current
+
+section .note.GNU-stack noalloc noexec nowrite progbits
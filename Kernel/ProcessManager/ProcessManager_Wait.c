@@ -0,0 +1,139 @@
+#include "ProcessManager_Internal.h"
+#include <stddef.h>
+
+void wait_queue_init(wait_queue_t *wq) {
+    wq->lock.locked = 0;
+    wq->head = NULL;
+    wq->tail = NULL;
+}
+
+process_t *process_block_prepare(void) {
+    process_t *process = process_current();
+    process->wake_result = 0;
+    process->wait_seq++;
+    process->state = PROCESS_STATE_BLOCKED;
+    return process;
+}
+
+uint64_t process_block_commit(void) {
+    process_schedule(0);
+    return process_current()->wake_result;
+}
+
+uint64_t process_sleep_locked(wait_queue_t *wq, spinlock_t *held) {
+    if (held != &wq->lock) {
+        spinlock_acquire(&wq->lock);
+    }
+    process_t *process = process_block_prepare();
+    process->wait_next = NULL;
+    if (wq->tail != NULL) {
+        wq->tail->wait_next = process;
+    } else {
+        wq->head = process;
+    }
+    wq->tail = process;
+    if (held != &wq->lock) {
+        spinlock_release(&wq->lock);
+    }
+    spinlock_release(held);
+
+    uint64_t result = process_block_commit();
+    spinlock_acquire(held);
+    return result;
+}
+
+uint64_t process_sleep_on(wait_queue_t *wq) {
+    uint64_t flags = spinlock_acquire_irqsave(&wq->lock);
+    uint64_t result = process_sleep_locked(wq, &wq->lock);
+    spinlock_release_irqrestore(&wq->lock, flags);
+    return result;
+}
+
+void process_wake(process_t *process, uint64_t result) {
+    while (__atomic_load_n(&process->on_cpu, __ATOMIC_ACQUIRE)) {
+        __asm__ volatile ("pause");
+    }
+    process->wake_result = result;
+    runqueue_enqueue(process);
+}
+
+uint32_t wait_queue_wake(wait_queue_t *wq, uint32_t count, uint64_t result) {
+    process_t *woken = NULL;
+    process_t *woken_tail = NULL;
+    uint32_t n = 0;
+
+    uint64_t flags = spinlock_acquire_irqsave(&wq->lock);
+    while (n < count && wq->head != NULL) {
+        process_t *process = wq->head;
+        wq->head = process->wait_next;
+        if (wq->head == NULL) {
+            wq->tail = NULL;
+        }
+        process->wait_next = NULL;
+        if (woken_tail != NULL) {
+            woken_tail->wait_next = process;
+        } else {
+            woken = process;
+        }
+        woken_tail = process;
+        n++;
+    }
+    spinlock_release_irqrestore(&wq->lock, flags);
+
+    while (woken != NULL) {
+        process_t *next = woken->wait_next;
+        woken->wait_next = NULL;
+        process_wake(woken, result);
+        woken = next;
+    }
+    return n;
+}
+
+void sleep_lock_init(sleep_lock_t *lock) {
+    wait_queue_init(&lock->waiters);
+    lock->held = 0;
+}
+
+void sleep_lock_acquire(sleep_lock_t *lock) {
+    uint64_t flags = spinlock_acquire_irqsave(&lock->waiters.lock);
+    while (lock->held) {
+        if (process_current() == NULL) {
+            spinlock_release(&lock->waiters.lock);
+            __asm__ volatile ("pause");
+            spinlock_acquire(&lock->waiters.lock);
+            continue;
+        }
+        process_sleep_locked(&lock->waiters, &lock->waiters.lock);
+    }
+    lock->held = 1;
+    spinlock_release_irqrestore(&lock->waiters.lock, flags);
+}
+
+void sleep_lock_release(sleep_lock_t *lock) {
+    uint64_t flags = spinlock_acquire_irqsave(&lock->waiters.lock);
+    lock->held = 0;
+    spinlock_release_irqrestore(&lock->waiters.lock, flags);
+    wait_queue_wake(&lock->waiters, 1, 0);
+}
+
+static void process_sleep_expired(timer_event_t *event) {
+    process_t *process = (process_t *)((uint8_t *)event - offsetof(process_t, sleep_timer));
+    if (process->state == PROCESS_STATE_BLOCKED && process->wait_seq == event->cookie) {
+        process_wake(process, 0);
+    }
+}
+
+int32_t process_sleep_ns(uint64_t ns) {
+    if (ns == 0 || !timer_is_ready()) {
+        return 0;
+    }
+    uint64_t flags = irq_save_disable();
+    uint64_t deadline = rdtsc() + timer_ns_to_tsc(ns);
+    process_t *process = process_block_prepare();
+    process->sleep_timer.callback = process_sleep_expired;
+    process->sleep_timer.cookie = process->wait_seq;
+    timer_event_add(&process->sleep_timer, deadline);
+    process_block_commit();
+    irq_restore(flags);
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "SMP_Main.h"
+#include "../ACPI/ACPI_Main.h"
+#include "../APIC/APIC_Main.h"
+#include "../CPU/CPU_Main.h"
+#include "../FPU/FPU_Main.h"
+#include "../GDT/GDT_Main.h"
+#include "../IDT/IDT_Main.h"
+#include "../Memory/Memory_Main.h"
+#include "../Memory/Other_Utils.h"
+#include "../ProcessManager/ProcessManager.h"
+#include "../Syscall/Syscall_Main.h"
+#include "../Timer/Timer_Main.h"
+#include "../Serial.h"
+#include <stddef.h>
+
+#define SMP_TRAMPOLINE_BASE 0x8000ULL
+#define SMP_AP_STACK_PAGES 4
+#define SMP_AP_STACK_SIZE (SMP_AP_STACK_PAGES * 4096)
+#define SMP_AP_START_TIMEOUT_US 100000u
+#define SMP_AP_POLL_US 100u
+
+typedef struct __attribute__((packed)) {
+    uint64_t cr3;
+    uint64_t stack;
+    uint64_t entry;
+    uint64_t arg;
+} smp_trampoline_params_t;
+
+extern uint8_t smp_trampoline_start[];
+extern uint8_t smp_trampoline_end[];
+extern uint8_t smp_trampoline_params[];
+
+__attribute__((noreturn))
+static void smp_ap_entry(uint64_t cpu_index) {
+    cpu_local_t *cpu = cpu_get((uint32_t)cpu_index);
+
+    gdt_init_cpu(cpu->index, (uint64_t)(cpu->interrupt_stack + SMP_AP_STACK_SIZE));
+    cpu_activate(cpu);
+    fpu_init_cpu();
+    apic_init_cpu();
+    timer_init_cpu();
+    syscall_init_cpu(cpu);
+    idt_load_cpu();
+
+    process_idle_loop();
+}
+
+static uint64_t read_cr3(void) {
+    uint64_t value;
+    __asm__ volatile ("mov %%cr3, %0" : "=r"(value));
+    return value;
+}
+
+static int smp_boot_ap(cpu_local_t *cpu) {
+    uint8_t *boot_stack = (uint8_t *)alloc_pages(SMP_AP_STACK_PAGES);
+    cpu->interrupt_stack = (uint8_t *)alloc_pages(SMP_AP_STACK_PAGES);
+    if (boot_stack == NULL || cpu->interrupt_stack == NULL) {
+        serial_write_string("[OS] [SMP] AP stack allocation failed\n");
+        return 0;
+    }
+
+    uint64_t trampoline_size = (uint64_t)(smp_trampoline_end - smp_trampoline_start);
+    uint8_t *trampoline = (uint8_t *)(uintptr_t)SMP_TRAMPOLINE_BASE;
+    memcpy(trampoline, smp_trampoline_start, (size_t)trampoline_size);
+
+    smp_trampoline_params_t *params = (smp_trampoline_params_t *)
+        (trampoline + (smp_trampoline_params - smp_trampoline_start));
+    params->cr3 = read_cr3();
+    params->stack = ((uint64_t)(boot_stack + SMP_AP_STACK_SIZE)) & ~0xFULL;
+    params->entry = (uint64_t)smp_ap_entry;
+    params->arg = cpu->index;
+    __asm__ volatile ("" ::: "memory");
+
+    apic_send_init(cpu->lapic_id);
+    apic_delay_us(10000);
+    for (int attempt = 0; attempt < 2 && !cpu->online; ++attempt) {
+        apic_send_startup(cpu->lapic_id, (uint8_t)(SMP_TRAMPOLINE_BASE >> 12));
+        for (uint32_t waited = 0; waited < SMP_AP_START_TIMEOUT_US && !cpu->online; waited += SMP_AP_POLL_US) {
+            apic_delay_us(SMP_AP_POLL_US);
+        }
+    }
+    return cpu->online ? 1 : 0;
+}
+
+uint32_t smp_start_aps(void) {
+    const acpi_madt_info_t *madt = acpi_get_madt_info();
+    if (!apic_is_ready() || madt->cpu_count <= 1) {
+        serial_write_string("[OS] [SMP] Single CPU system\n");
+        return cpu_online_count();
+    }
+
+    register_interrupt_handler(APIC_VECTOR_RESCHEDULE, process_reschedule_ipi);
+
+    uint32_t bsp_id = apic_id();
+    for (uint32_t i = 0; i < madt->cpu_count; ++i) {
+        if (madt->lapic_ids[i] == bsp_id) {
+            continue;
+        }
+        cpu_local_t *cpu = cpu_register(madt->lapic_ids[i]);
+        if (cpu == NULL) {
+            break;
+        }
+        if (!smp_boot_ap(cpu)) {
+            serial_write_string("[OS] [SMP] AP failed to start, LAPIC ");
+            serial_write_uint32(cpu->lapic_id);
+            serial_write_string("\n");
+        }
+    }
+
+    serial_write_string("[OS] [SMP] CPUs online: ");
+    serial_write_uint32(cpu_online_count());
+    serial_write_string("\n");
+    for (uint32_t i = 0; i < cpu_count(); ++i) {
+        cpu_local_t *cpu = cpu_get(i);
+        if (!cpu->online) {
+            continue;
+        }
+        serial_write_string("[OS] [SMP] CPU ");
+        serial_write_uint32(i);
+        serial_write_string(" core=");
+        serial_write_uint32(cpu->core_id);
+        serial_write_string(" package=");
+        serial_write_uint32(cpu->package_id);
+        serial_write_string(" l2=");
+        serial_write_uint32(cpu->l2_id);
+        serial_write_string(" llc=");
+        serial_write_uint32(cpu->llc_id);
+        serial_write_string("\n");
+    }
+    return cpu_online_count();
+}
@@ -0,0 +1,95 @@
+BITS 16
+
+global smp_trampoline_start
+global smp_trampoline_end
+global smp_trampoline_params
+
+%define SMP_TRAMPOLINE_BASE 0x8000
+%define TRAMPOLINE_ADDR(label) (SMP_TRAMPOLINE_BASE + (label) - smp_trampoline_start)
+
+%define TRAMPOLINE_CODE32 0x08
+%define TRAMPOLINE_DATA   0x10
+%define TRAMPOLINE_CODE64 0x18
+
+SECTION .text
+
+smp_trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+
+    lgdt [TRAMPOLINE_ADDR(trampoline_gdtr)]
+    mov eax, cr0
+    or eax, 1
+    mov cr0, eax
+    jmp dword TRAMPOLINE_CODE32:TRAMPOLINE_ADDR(trampoline_protected)
+
+BITS 32
+trampoline_protected:
+    mov ax, TRAMPOLINE_DATA
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+
+    mov eax, cr4
+    or eax, (1 << 5) | (1 << 9) | (1 << 10)
+    mov cr4, eax
+
+    mov eax, [TRAMPOLINE_ADDR(trampoline_cr3)]
+    mov cr3, eax
+
+    mov ecx, 0xC0000080
+    rdmsr
+    or eax, (1 << 8)
+    wrmsr
+
+    mov eax, cr0
+    and eax, ~(1 << 2)
+    or eax, (1 << 31) | (1 << 1)
+    mov cr0, eax
+    jmp TRAMPOLINE_CODE64:TRAMPOLINE_ADDR(trampoline_long)
+
+BITS 64
+trampoline_long:
+    mov ax, TRAMPOLINE_DATA
+    mov ds, ax
+    mov es, ax
+    mov ss, ax
+
+    mov rsp, [TRAMPOLINE_ADDR(trampoline_stack)]
+    mov rdi, [TRAMPOLINE_ADDR(trampoline_arg)]
+    mov rax, [TRAMPOLINE_ADDR(trampoline_entry)]
+    xor rbp, rbp
+    call rax
+.hang:
+    hlt
+    jmp .hang
+
+align 8
+trampoline_gdt:
+    dq 0
+    dq 0x00CF9A000000FFFF
+    dq 0x00CF92000000FFFF
+    dq 0x00AF9A000000FFFF
+trampoline_gdt_end:
+
+trampoline_gdtr:
+    dw trampoline_gdt_end - trampoline_gdt - 1
+    dd TRAMPOLINE_ADDR(trampoline_gdt)
+
+align 8
+smp_trampoline_params:
+trampoline_cr3:
+    dq 0
+trampoline_stack:
+    dq 0
+trampoline_entry:
+    dq 0
+trampoline_arg:
+    dq 0
+smp_trampoline_end:
+
+section .note.GNU-stack noalloc noexec nowrite progbits
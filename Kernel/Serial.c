@@ -0,0 +1,264 @@
+#include "Serial.h"
+#include "IO/IO_Main.h"
+#include "IDT/IDT_Main.h"
+#include "APIC/APIC_Main.h"
+#include "Sync/Sync_Main.h"
+
+#define COM1_PORT 0x3F8
+#define COM1_ISA_IRQ 4
+
+#define UART_REG_DATA 0
+#define UART_REG_IER  1
+#define UART_REG_IIR  2
+#define UART_REG_LSR  5
+
+#define UART_IER_THRE (1u << 1)
+#define UART_LSR_THRE (1u << 5)
+#define UART_FIFO_DEPTH 16
+
+#define SERIAL_LOG_SIZE (64 * 1024)
+#define SERIAL_LOG_MASK (SERIAL_LOG_SIZE - 1)
+
+// Writers reserve space by moving g_log_reserve, copy their bytes, then
+// publish them in reservation order through g_log_commit. Only the
+// drainer, holding g_drain_lock, moves g_log_tail.
+static char g_log[SERIAL_LOG_SIZE];
+static volatile uint64_t g_log_reserve = 0;
+static volatile uint64_t g_log_commit = 0;
+static volatile uint64_t g_log_tail = 0;
+static spinlock_t g_drain_lock = SPINLOCK_INIT;
+static uint32_t g_cr_sent = 0;
+static uint32_t g_tx_irq_armed = 0;
+
+static volatile uint32_t g_serial_async = 0;
+static volatile uint32_t g_serial_panic = 0;
+static serial_stats_t g_serial_stats;
+
+static int serial_tx_ready(void) {
+    return (inb(COM1_PORT + UART_REG_LSR) & UART_LSR_THRE) != 0;
+}
+
+static void serial_set_tx_irq(uint32_t armed) {
+    if (g_tx_irq_armed != armed) {
+        g_tx_irq_armed = armed;
+        outb(COM1_PORT + UART_REG_IER, armed ? UART_IER_THRE : 0);
+    }
+}
+
+// Moves up to one FIFO's worth of committed bytes into the UART, which
+// only accepts them once the holding register reports empty.
+static void serial_fill_fifo(void) {
+    if (!serial_tx_ready()) {
+        return;
+    }
+    uint64_t tail = g_log_tail;
+    uint64_t commit = __atomic_load_n(&g_log_commit, __ATOMIC_ACQUIRE);
+    uint32_t sent = 0;
+    while (sent < UART_FIFO_DEPTH && tail != commit) {
+        char c = g_log[tail & SERIAL_LOG_MASK];
+        if (c == '\n' && !g_cr_sent) {
+            outb(COM1_PORT + UART_REG_DATA, '\r');
+            g_cr_sent = 1;
+        } else {
+            outb(COM1_PORT + UART_REG_DATA, (uint8_t)c);
+            g_cr_sent = 0;
+            tail++;
+        }
+        sent++;
+    }
+    __atomic_store_n(&g_log_tail, tail, __ATOMIC_RELEASE);
+    g_serial_stats.written_bytes += sent;
+}
+
+static int serial_log_pending(void) {
+    return __atomic_load_n(&g_log_commit, __ATOMIC_ACQUIRE) != __atomic_load_n(&g_log_tail, __ATOMIC_ACQUIRE);
+}
+
+// Never waits on the UART: it fills the FIFO if it is empty and leaves the
+// rest to the THR-empty interrupt.
+static void serial_drain_async(void) {
+    while (1) {
+        uint64_t flags = irq_save_disable();
+        if (!spinlock_try_acquire(&g_drain_lock)) {
+            irq_restore(flags);
+            return;
+        }
+        serial_fill_fifo();
+        int pending = serial_log_pending();
+        serial_set_tx_irq(pending);
+        spinlock_release_irqrestore(&g_drain_lock, flags);
+        // Pairs with the fence in serial_log_append: either the writer sees
+        // the lock free or this sees its commit.
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (pending || !serial_log_pending()) {
+            return;
+        }
+    }
+}
+
+static void serial_drain_sync_locked(void) {
+    while (serial_log_pending()) {
+        while (!serial_tx_ready()) {
+            __asm__ volatile ("pause");
+        }
+        serial_fill_fifo();
+    }
+}
+
+static void serial_drain_sync(void) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_drain_lock);
+    serial_drain_sync_locked();
+    spinlock_release_irqrestore(&g_drain_lock, flags);
+}
+
+static void serial_kick(void) {
+    if (g_serial_async) {
+        serial_drain_async();
+    } else {
+        serial_drain_sync();
+    }
+}
+
+static void serial_write_direct(const char *data, uint64_t len) {
+    for (uint64_t i = 0; i < len; ++i) {
+        if (data[i] == '\n') {
+            while (!serial_tx_ready()) {
+            }
+            outb(COM1_PORT + UART_REG_DATA, '\r');
+        }
+        while (!serial_tx_ready()) {
+        }
+        outb(COM1_PORT + UART_REG_DATA, (uint8_t)data[i]);
+    }
+}
+
+// A message either goes into the ring whole or is dropped and counted.
+// Interrupts stay off between reserve and commit so a handler on this CPU
+// can never wait on a commit that this CPU has yet to make.
+static void serial_log_append(const char *data, uint64_t len) {
+    if (len == 0) {
+        return;
+    }
+    if (g_serial_panic) {
+        serial_write_direct(data, len);
+        return;
+    }
+
+    uint64_t flags = irq_save_disable();
+    uint64_t start = __atomic_load_n(&g_log_reserve, __ATOMIC_RELAXED);
+    while (1) {
+        uint64_t used = start - __atomic_load_n(&g_log_tail, __ATOMIC_ACQUIRE);
+        if (len > SERIAL_LOG_SIZE || used + len > SERIAL_LOG_SIZE) {
+            if (!g_serial_async && len <= SERIAL_LOG_SIZE) {
+                irq_restore(flags);
+                serial_drain_sync();
+                flags = irq_save_disable();
+                start = __atomic_load_n(&g_log_reserve, __ATOMIC_RELAXED);
+                continue;
+            }
+            __atomic_fetch_add(&g_serial_stats.dropped_messages, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&g_serial_stats.dropped_bytes, len, __ATOMIC_RELAXED);
+            irq_restore(flags);
+            return;
+        }
+        if (__atomic_compare_exchange_n(&g_log_reserve, &start, start + len, 1,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    for (uint64_t i = 0; i < len; ++i) {
+        g_log[(start + i) & SERIAL_LOG_MASK] = data[i];
+    }
+    while (__atomic_load_n(&g_log_commit, __ATOMIC_ACQUIRE) != start) {
+        __asm__ volatile ("pause");
+    }
+    __atomic_store_n(&g_log_commit, start + len, __ATOMIC_RELEASE);
+    irq_restore(flags);
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    serial_kick();
+}
+
+static void serial_irq(void) {
+    (void)inb(COM1_PORT + UART_REG_IIR);
+    serial_drain_async();
+}
+
+void serial_init(void) {
+    outb(COM1_PORT + 1, 0x00);
+    outb(COM1_PORT + 3, 0x80);
+    outb(COM1_PORT + 0, 0x03);
+    outb(COM1_PORT + 1, 0x00);
+    outb(COM1_PORT + 3, 0x03);
+    outb(COM1_PORT + 2, 0xC7);
+    outb(COM1_PORT + 4, 0x0B);
+}
+
+// Until this runs every write drains synchronously, as it did before.
+bool serial_init_irq(uint32_t lapic_id) {
+    register_interrupt_handler(APIC_VECTOR_SERIAL, serial_irq);
+    if (!apic_route_isa_irq(COM1_ISA_IRQ, APIC_VECTOR_SERIAL, lapic_id)) {
+        serial_write_string("[OS] [SERIAL] IRQ not routed, staying synchronous\n");
+        return false;
+    }
+    g_serial_async = 1;
+    serial_write_string("[OS] [SERIAL] Buffered output on IRQ 4\n");
+    return true;
+}
+
+// For fatal paths: pushes out everything committed so far, ignoring the
+// drain lock whose holder may never return, then writes straight through.
+void serial_panic_flush(void) {
+    uint64_t flags = irq_save_disable();
+    g_serial_panic = 1;
+    g_serial_async = 0;
+    g_tx_irq_armed = 1;
+    serial_set_tx_irq(0);
+    serial_drain_sync_locked();
+    irq_restore(flags);
+}
+
+// Waits until everything written so far has reached the UART.
+void serial_flush(void) {
+    if (!g_serial_panic) {
+        serial_drain_sync();
+    }
+}
+
+void serial_get_stats(serial_stats_t *out) {
+    out->written_bytes = g_serial_stats.written_bytes;
+    out->dropped_messages = __atomic_load_n(&g_serial_stats.dropped_messages, __ATOMIC_RELAXED);
+    out->dropped_bytes = __atomic_load_n(&g_serial_stats.dropped_bytes, __ATOMIC_RELAXED);
+}
+
+void serial_write_char(char c) {
+    serial_log_append(&c, 1);
+}
+
+void serial_write_string(const char *str) {
+    uint64_t len = 0;
+    while (str[len] != '\0') {
+        len++;
+    }
+    serial_log_append(str, len);
+}
+
+void serial_write_uint64(uint64_t value) {
+    static const char hex[] = "0123456789ABCDEF";
+    char text[18];
+    text[0] = '0';
+    text[1] = 'x';
+    for (int i = 0; i < 16; ++i) {
+        text[2 + i] = hex[(value >> ((15 - i) * 4)) & 0xF];
+    }
+    serial_log_append(text, sizeof(text));
+}
+
+void serial_write_uint32(uint32_t value) {
+    serial_write_uint64((uint64_t)value);
+}
+
+void serial_write_uint16(uint16_t value) {
+    serial_write_uint64((uint64_t)value);
+}
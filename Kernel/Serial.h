@@ -1,9 +1,20 @@
 #ifndef SERIAL_H
 #define SERIAL_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
+typedef struct {
+    uint64_t written_bytes;
+    uint64_t dropped_messages;
+    uint64_t dropped_bytes;
+} serial_stats_t;
+
 void serial_init(void);
+bool serial_init_irq(uint32_t lapic_id);
+void serial_panic_flush(void);
+void serial_flush(void);
+void serial_get_stats(serial_stats_t *out);
 void serial_write_char(char c);
 void serial_write_string(const char *str);
 void serial_write_uint64(uint64_t value);
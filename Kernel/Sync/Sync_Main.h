@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t locked;
+} spinlock_t;
+
+#define SPINLOCK_INIT {0}
+
+static inline uint64_t irq_save_disable(void) {
+    uint64_t flags;
+    __asm__ volatile ("pushfq; popq %0; cli" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+static inline bool irq_enabled(void) {
+    uint64_t flags;
+    __asm__ volatile ("pushfq; popq %0" : "=r"(flags));
+    return (flags & (1ull << 9)) != 0;
+}
+
+static inline void irq_restore(uint64_t flags) {
+    if (flags & (1ull << 9)) {
+        __asm__ volatile ("sti" ::: "memory");
+    }
+}
+
+static inline void spinlock_acquire(spinlock_t *lock) {
+    while (__sync_lock_test_and_set(&lock->locked, 1) != 0) {
+        while (lock->locked != 0) {
+            __asm__ volatile ("pause");
+        }
+    }
+}
+
+static inline int spinlock_try_acquire(spinlock_t *lock) {
+    return __sync_lock_test_and_set(&lock->locked, 1) == 0;
+}
+
+static inline void spinlock_release(spinlock_t *lock) {
+    __sync_lock_release(&lock->locked);
+}
+
+static inline uint64_t spinlock_acquire_irqsave(spinlock_t *lock) {
+    uint64_t flags = irq_save_disable();
+    spinlock_acquire(lock);
+    return flags;
+}
+
+static inline void spinlock_release_irqrestore(spinlock_t *lock, uint64_t flags) {
+    spinlock_release(lock);
+    irq_restore(flags);
+}
@@ -1,165 +1,376 @@
 #include "Syscall_Main.h"
 #include "Syscall_File.h"
+#include "Syscall_Ring.h"
+#include "Syscall_Memory.h"
 #include "IO/IO_Main.h"
 #include "../Serial.h"
+#include "../CPU/CPU_Main.h"
 #include "../ProcessManager/ProcessManager.h"
 #include "../Drivers/Display/Display_Main.h"
-#include "../Memory/Memory_Main.h"
-#include "../Memory/Other_Utils.h"
+#include "../Timer/Timer_Main.h"
+#include "../Trace/Trace_Main.h"
+#include <stddef.h>
 #include <stdint.h>
 
+#define SYSCALL_ERROR ((uint64_t)-1)
+
 static void set_syscall_result(uint64_t saved_rsp, uint64_t value)
 {
     uint64_t *frame = (uint64_t *)saved_rsp;
     frame[SYSCALL_FRAME_RAX] = value;
 }
 
-uint64_t syscall_dispatch(uint64_t saved_rsp,
-                          uint64_t num,
-                          uint64_t arg1,
-                          uint64_t arg2,
-                          uint64_t arg3,
-                          uint64_t arg4)
-{
-    int request_switch = 0;
-
-    switch (num) {
-    case SYSCALL_SERIAL_PUTCHAR:
-        serial_write_char((char)arg1);
-        set_syscall_result(saved_rsp, 0);
-        break;
-
-    case SYSCALL_SERIAL_PUTS:
-        serial_write_string((const char*)arg1);
-        set_syscall_result(saved_rsp, 0);
-        break;
-
-    case SYSCALL_PROCESS_CREATE: {
-        int32_t pid = process_create_user(arg1);
-        set_syscall_result(saved_rsp, (uint64_t)(int64_t)pid);
-        break;
-    }
+static uint64_t sys_serial_putchar(const uint64_t *args) {
+    serial_write_char((char)args[0]);
+    return 0;
+}
 
-    case SYSCALL_PROCESS_YIELD:
-        set_syscall_result(saved_rsp, 0);
-        request_switch = 1;
-        break;
-
-    case SYSCALL_PROCESS_EXIT:
-        process_exit_current();
-        request_switch = 1;
-        break;
-
-    case SYSCALL_THREAD_CREATE: {
-        int32_t tid = process_create_user(arg1);
-        set_syscall_result(saved_rsp, (uint64_t)(int64_t)tid);
-        if (tid >= 0) {
-            request_switch = 1;
-        }
-        break;
-    }
+static uint64_t sys_serial_puts(const uint64_t *args) {
+    serial_write_string((const char *)args[0]);
+    return 0;
+}
 
-    case SYSCALL_DRAW_PIXEL:
-        display_draw_pixel((uint32_t)arg1, (uint32_t)arg2, (uint32_t)arg3);
-        set_syscall_result(saved_rsp, 0);
-        break;
-
-    case SYSCALL_DRAW_FILL_RECT:
-        display_fill_rect((uint32_t)arg1,
-                          (uint32_t)arg2,
-                          (uint32_t)(arg3 >> 32),
-                          (uint32_t)(arg3 & 0xFFFFFFFFu),
-                          (uint32_t)arg4);
-        set_syscall_result(saved_rsp, 0);
-        break;
-
-    case SYSCALL_DRAW_PRESENT:
-        display_present();
-        set_syscall_result(saved_rsp, 0);
-        break;
-
-    case SYSCALL_FILE_OPEN: {
-        int32_t fd = syscall_file_open((const char *)arg1, arg2);
-        set_syscall_result(saved_rsp, (uint64_t)(int64_t)fd);
-        break;
+static uint64_t sys_serial_stats(const uint64_t *args) {
+    if (args[0] == 0) {
+        return SYSCALL_ERROR;
     }
+    serial_get_stats((serial_stats_t *)args[0]);
+    return 0;
+}
 
-    case SYSCALL_FILE_READ: {
-        int64_t n = syscall_file_read((int32_t)arg1, (uint8_t *)arg2, arg3);
-        set_syscall_result(saved_rsp, (uint64_t)n);
-        break;
-    }
+static uint64_t sys_trace_ctl(const uint64_t *args) {
+    return (uint64_t)trace_control((uint32_t)args[0]);
+}
 
-    case SYSCALL_FILE_WRITE: {
-        int64_t n = syscall_file_write((int32_t)arg1, (const uint8_t *)arg2, arg3);
-        set_syscall_result(saved_rsp, (uint64_t)n);
-        break;
-    }
+static uint64_t sys_process_create(const uint64_t *args) {
+    return (uint64_t)(int64_t)process_create_user(args[0]);
+}
 
-    case SYSCALL_FILE_CLOSE: {
-        int32_t rc = syscall_file_close((int32_t)arg1);
-        set_syscall_result(saved_rsp, (uint64_t)(int64_t)rc);
-        break;
-    }
+static uint64_t sys_process_yield(const uint64_t *args) {
+    (void)args;
+    process_sched_yield();
+    return 0;
+}
 
-    case SYSCALL_USER_KMALLOC: {
-        uint32_t size = (uint32_t)arg1;
-        void *ptr = kmalloc(size);
-        return (uint64_t)ptr;
-    }
+static uint64_t sys_process_exit(const uint64_t *args) {
+    process_exit_current((int32_t)args[0]);
+}
 
-    case SYSCALL_USER_KFREE: {
-        void *ptr = (void*)arg1;
-        kfree(ptr);
-        return 0;
+static uint64_t sys_thread_create(const uint64_t *args) {
+    int32_t tid = thread_create_user(args[0], args[1], args[2]);
+    if (tid >= 0) {
+        process_yield_current();
     }
+    return (uint64_t)(int64_t)tid;
+}
 
-        case SYSCALL_USER_MEMCPY: {
-        void *dst = (void*)arg1;
-        const void *src = (const void*)arg2;
-        uint64_t n = arg3;
+static uint64_t sys_set_priority(const uint64_t *args) {
+    return (uint64_t)(int64_t)process_set_priority((int32_t)args[0], (int32_t)args[1]);
+}
 
-        uint8_t *d = (uint8_t*)dst;
-        const uint8_t *s = (const uint8_t*)src;
+static uint64_t sys_get_priority(const uint64_t *args) {
+    return (uint64_t)(int64_t)process_get_priority((int32_t)args[0]);
+}
 
-        for (uint64_t i = 0; i < n; i++) {
-            d[i] = s[i];
-        }
+static uint64_t sys_sched_set(const uint64_t *args) {
+    return (uint64_t)(int64_t)process_sched_set((int32_t)args[0], args[1], args[2]);
+}
+
+static uint64_t sys_set_affinity(const uint64_t *args) {
+    return (uint64_t)(int64_t)process_set_affinity((int32_t)args[0], args[1]);
+}
+
+static uint64_t sys_get_affinity(const uint64_t *args) {
+    return (uint64_t)(int64_t)process_get_affinity((int32_t)args[0], (uint64_t *)args[1]);
+}
+
+static uint64_t sys_cpu_topology(const uint64_t *args) {
+    return (uint64_t)(int64_t)cpu_get_topology((uint32_t)args[0], (cpu_topology_t *)args[1]);
+}
+
+static uint64_t sys_process_cpu(const uint64_t *args) {
+    (void)args;
+    return process_current_cpu();
+}
+
+static uint64_t sys_process_wait(const uint64_t *args) {
+    return (uint64_t)(int64_t)process_wait((int32_t)args[0], (int32_t *)args[1]);
+}
+
+static uint64_t sys_process_sleep(const uint64_t *args) {
+    return (uint64_t)(int64_t)process_sleep_ns(args[0]);
+}
+
+static uint64_t sys_channel_create(const uint64_t *args) {
+    (void)args;
+    return (uint64_t)(int64_t)channel_create();
+}
+
+static uint64_t sys_channel_destroy(const uint64_t *args) {
+    return (uint64_t)(int64_t)channel_destroy((int32_t)args[0]);
+}
+
+static uint64_t sys_channel_send(const uint64_t *args) {
+    return (uint64_t)(int64_t)channel_send((int32_t)args[0], (const channel_msg_t *)args[1]);
+}
+
+static uint64_t sys_channel_call(const uint64_t *args) {
+    return (uint64_t)(int64_t)channel_call((int32_t)args[0], (const channel_msg_t *)args[1],
+                                           (channel_msg_t *)args[2]);
+}
+
+static uint64_t sys_channel_receive(const uint64_t *args) {
+    return (uint64_t)(int64_t)channel_receive((int32_t)args[0], (const channel_msg_t *)args[1],
+                                              (channel_msg_t *)args[2]);
+}
+
+static uint64_t sys_poll_create(const uint64_t *args) {
+    (void)args;
+    return (uint64_t)(int64_t)poll_create();
+}
+
+static uint64_t sys_poll_destroy(const uint64_t *args) {
+    return (uint64_t)(int64_t)poll_destroy((int32_t)args[0]);
+}
+
+static uint64_t sys_poll_ctl(const uint64_t *args) {
+    return (uint64_t)(int64_t)poll_ctl((int32_t)args[0], (uint32_t)args[1], (const poll_event_t *)args[2]);
+}
+
+static uint64_t sys_poll_wait(const uint64_t *args) {
+    return (uint64_t)(int64_t)poll_wait((int32_t)args[0], (poll_event_t *)args[1], (uint32_t)args[2], args[3]);
+}
+
+static uint64_t sys_futex_wait(const uint64_t *args) {
+    return (uint64_t)(int64_t)futex_wait((uint32_t *)args[0], (uint32_t)args[1], args[2]);
+}
+
+static uint64_t sys_futex_wake(const uint64_t *args) {
+    return (uint64_t)(int64_t)futex_wake((uint32_t *)args[0], (uint32_t)args[1]);
+}
 
-        set_syscall_result(saved_rsp, (uint64_t)dst);
-        break;
+static uint64_t sys_timer_stats(const uint64_t *args) {
+    if (args[0] == 0) {
+        return SYSCALL_ERROR;
     }
+    timer_get_stats((timer_stats_t *)args[0]);
+    return 0;
+}
 
-    case SYSCALL_USER_MEMCMP: {
-        const uint8_t *s1 = (const uint8_t*)arg1;
-        const uint8_t *s2 = (const uint8_t*)arg2;
-        uint64_t n = arg3;
+static uint64_t sys_profile_read(const uint64_t *args) {
+    return (uint64_t)(int64_t)syscall_profile_read(args[0], (syscall_profile_t *)args[1]);
+}
 
-        int result = 0;
+static uint64_t sys_process_snapshot(const uint64_t *args) {
+    return (uint64_t)(int64_t)process_snapshot((process_info_t *)args[0], (uint32_t)args[1]);
+}
 
-        for (uint64_t i = 0; i < n; i++) {
-            if (s1[i] != s2[i]) {
-                result = (int)s1[i] - (int)s2[i];
-                break;
-            }
-        }
+static uint64_t sys_thread_join(const uint64_t *args) {
+    return (uint64_t)(int64_t)thread_join((int32_t)args[0], (int32_t *)args[1]);
+}
+
+static uint64_t sys_thread_set_fs(const uint64_t *args) {
+    return (uint64_t)(int64_t)thread_set_fs_base(args[0]);
+}
+
+static uint64_t sys_thread_id(const uint64_t *args) {
+    (void)args;
+    return (uint64_t)(int64_t)process_current_tid();
+}
+
+static uint64_t sys_process_id(const uint64_t *args) {
+    (void)args;
+    return (uint64_t)(int64_t)process_current_tgid();
+}
+
+static uint64_t sys_draw_pixel(const uint64_t *args) {
+    display_draw_pixel((uint32_t)args[0], (uint32_t)args[1], (uint32_t)args[2]);
+    return 0;
+}
+
+// The third argument packs width:height as high:low 32 bits.
+static uint64_t sys_draw_fill_rect(const uint64_t *args) {
+    display_fill_rect((uint32_t)args[0],
+                      (uint32_t)args[1],
+                      (uint32_t)(args[2] >> 32),
+                      (uint32_t)(args[2] & 0xFFFFFFFFu),
+                      (uint32_t)args[3]);
+    return 0;
+}
+
+static uint64_t sys_draw_present(const uint64_t *args) {
+    (void)args;
+    display_present();
+    return 0;
+}
+
+static uint64_t sys_file_open(const uint64_t *args) {
+    return (uint64_t)(int64_t)syscall_file_open((const char *)args[0], args[1]);
+}
+
+static uint64_t sys_file_read(const uint64_t *args) {
+    return (uint64_t)syscall_file_read((int32_t)args[0], (uint8_t *)args[1], args[2]);
+}
+
+static uint64_t sys_file_write(const uint64_t *args) {
+    return (uint64_t)syscall_file_write((int32_t)args[0], (const uint8_t *)args[1], args[2]);
+}
+
+static uint64_t sys_file_pread(const uint64_t *args) {
+    return (uint64_t)syscall_file_pread((int32_t)args[0], (uint8_t *)args[1], args[2], args[3]);
+}
+
+static uint64_t sys_file_pwrite(const uint64_t *args) {
+    return (uint64_t)syscall_file_pwrite((int32_t)args[0], (const uint8_t *)args[1], args[2], args[3]);
+}
+
+static uint64_t sys_file_readv(const uint64_t *args) {
+    return (uint64_t)syscall_file_readv((int32_t)args[0], (const file_iovec_t *)args[1], (uint32_t)args[2]);
+}
+
+static uint64_t sys_file_writev(const uint64_t *args) {
+    return (uint64_t)syscall_file_writev((int32_t)args[0], (const file_iovec_t *)args[1], (uint32_t)args[2]);
+}
+
+static uint64_t sys_file_pipe(const uint64_t *args) {
+    return (uint64_t)(int64_t)syscall_file_pipe((int32_t *)args[0]);
+}
 
-        set_syscall_result(saved_rsp, (uint64_t)(int64_t)result);
-        break;
+static uint64_t sys_file_close(const uint64_t *args) {
+    return (uint64_t)(int64_t)syscall_file_close((int32_t)args[0]);
+}
+
+static uint64_t sys_ring_setup(const uint64_t *args) {
+    return (uint64_t)(int64_t)syscall_ring_setup((io_ring_t *)args[0]);
+}
+
+static uint64_t sys_ring_enter(const uint64_t *args) {
+    return (uint64_t)syscall_ring_enter((int32_t)args[0], (uint32_t)args[1]);
+}
+
+static uint64_t sys_ring_destroy(const uint64_t *args) {
+    return (uint64_t)(int64_t)syscall_ring_destroy((int32_t)args[0]);
+}
+
+static uint64_t sys_mem_map(const uint64_t *args) {
+    return (uint64_t)syscall_mem_map((uint32_t)args[0]);
+}
+
+static uint64_t sys_mem_unmap(const uint64_t *args) {
+    return (uint64_t)(int64_t)syscall_mem_unmap((void *)args[0], (uint32_t)args[1]);
+}
+
+#define SYSCALL(num, fn, nargs, fl) [num] = { .handler = (fn), .argc = (nargs), .flags = (fl) }
+
+static const syscall_entry_t g_syscall_table[SYSCALL_TABLE_SIZE] = {
+    SYSCALL(SYSCALL_SERIAL_PUTCHAR,       sys_serial_putchar,   1, 0),
+    SYSCALL(SYSCALL_SERIAL_PUTS,          sys_serial_puts,      1, 0),
+    SYSCALL(SYSCALL_PROCESS_CREATE,       sys_process_create,   1, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_PROCESS_YIELD,        sys_process_yield,    0, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_PROCESS_EXIT,         sys_process_exit,     1, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_THREAD_CREATE,        sys_thread_create,    3, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_PROCESS_SET_PRIORITY, sys_set_priority,     2, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_PROCESS_GET_PRIORITY, sys_get_priority,     1, 0),
+    SYSCALL(SYSCALL_PROCESS_CPU,          sys_process_cpu,      0, 0),
+    SYSCALL(SYSCALL_DRAW_PIXEL,           sys_draw_pixel,       3, 0),
+    SYSCALL(SYSCALL_DRAW_FILL_RECT,       sys_draw_fill_rect,   4, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_DRAW_PRESENT,         sys_draw_present,     0, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_PROCESS_WAIT,         sys_process_wait,     2, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_PROCESS_SLEEP,        sys_process_sleep,    1, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_TIMER_STATS,          sys_timer_stats,      1, 0),
+    SYSCALL(SYSCALL_THREAD_JOIN,          sys_thread_join,      2, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_THREAD_SET_FS,        sys_thread_set_fs,    1, 0),
+    SYSCALL(SYSCALL_THREAD_ID,            sys_thread_id,        0, 0),
+    SYSCALL(SYSCALL_PROCESS_ID,           sys_process_id,       0, 0),
+    SYSCALL(SYSCALL_FILE_OPEN,            sys_file_open,        2, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_FILE_READ,            sys_file_read,        3, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_FILE_WRITE,           sys_file_write,       3, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_FILE_CLOSE,           sys_file_close,       1, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_MEM_MAP,              sys_mem_map,          1, 0),
+    SYSCALL(SYSCALL_MEM_UNMAP,            sys_mem_unmap,        2, 0),
+    SYSCALL(SYSCALL_FUTEX_WAIT,           sys_futex_wait,       3, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_FUTEX_WAKE,           sys_futex_wake,       2, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_PROFILE_READ,         sys_profile_read,     2, 0),
+    SYSCALL(SYSCALL_PROCESS_SNAPSHOT,     sys_process_snapshot, 2, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_SCHED_SET,            sys_sched_set,        3, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_SET_AFFINITY,         sys_set_affinity,     2, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_GET_AFFINITY,         sys_get_affinity,     2, 0),
+    SYSCALL(SYSCALL_CPU_TOPOLOGY,         sys_cpu_topology,     2, 0),
+    SYSCALL(SYSCALL_RING_SETUP,           sys_ring_setup,       1, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_RING_ENTER,           sys_ring_enter,       2, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_RING_DESTROY,         sys_ring_destroy,     1, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_SERIAL_STATS,         sys_serial_stats,     1, 0),
+    SYSCALL(SYSCALL_TRACE_CTL,            sys_trace_ctl,        1, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_FILE_PREAD,           sys_file_pread,       4, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_FILE_PWRITE,          sys_file_pwrite,      4, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_FILE_READV,           sys_file_readv,       3, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_FILE_WRITEV,          sys_file_writev,      3, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_FILE_PIPE,            sys_file_pipe,        1, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_CHANNEL_CREATE,       sys_channel_create,   0, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_CHANNEL_DESTROY,      sys_channel_destroy,  1, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_CHANNEL_SEND,         sys_channel_send,     2, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_CHANNEL_CALL,         sys_channel_call,     3, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_CHANNEL_RECEIVE,      sys_channel_receive,  3, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_POLL_CREATE,          sys_poll_create,      0, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_POLL_DESTROY,         sys_poll_destroy,     1, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_POLL_CTL,             sys_poll_ctl,         3, SYSCALL_FLAG_SCHED),
+    SYSCALL(SYSCALL_POLL_WAIT,            sys_poll_wait,        4, SYSCALL_FLAG_SCHED),
+};
+
+const syscall_entry_t *syscall_lookup(uint64_t num) {
+    if (num >= SYSCALL_TABLE_SIZE || g_syscall_table[num].handler == NULL) {
+        return NULL;
     }
+    return &g_syscall_table[num];
+}
 
-    default:
+void syscall_dispatch(uint64_t saved_rsp,
+                      uint64_t num,
+                      uint64_t arg1,
+                      uint64_t arg2,
+                      uint64_t arg3,
+                      uint64_t arg4)
+{
+#ifdef SYSCALL_PROFILE
+    uint64_t profile_start = rdtsc();
+#endif
+    const syscall_entry_t *entry = syscall_lookup(num);
+    if (entry == NULL) {
         serial_write_string("[SYSCALL] Unknown syscall\n");
-        set_syscall_result(saved_rsp, (uint64_t)-1);
-        break;
+        set_syscall_result(saved_rsp, SYSCALL_ERROR);
+        return;
+    }
+
+    // Registers past argc hold whatever userland left there; handlers and
+    // the trace only ever see zeros in those slots.
+    uint64_t args[4] = { arg1, arg2, arg3, arg4 };
+    for (uint32_t i = entry->argc; i < 4; ++i) {
+        args[i] = 0;
+    }
+    uint64_t result;
+    TRACE(SYSCALL_ENTER, num, args[0], args[1]);
+    if ((entry->flags & SYSCALL_FLAG_SCHED) == 0) {
+        process_account_syscall_fast();
+        result = entry->handler(args);
+        set_syscall_result(saved_rsp, result);
+        TRACE(SYSCALL_EXIT, num, result, 0);
+#ifdef SYSCALL_PROFILE
+        syscall_profile_record(num, rdtsc() - profile_start);
+#endif
+        // A timer tick may still have landed while we were in the kernel.
+        if (cpu_current()->need_resched) {
+            process_check_resched();
+        }
+        return;
     }
 
-    uint64_t current_user_rsp = syscall_get_user_rsp();
-    uint64_t next_user_rsp = current_user_rsp;
-    uint64_t next_saved_rsp = process_schedule_on_syscall(saved_rsp,
-                                                          current_user_rsp,
-                                                          request_switch,
-                                                          &next_user_rsp);
-    syscall_set_user_rsp(next_user_rsp);
-    return next_saved_rsp;
+    process_account_syscall_enter();
+    result = entry->handler(args);
+    set_syscall_result(saved_rsp, result);
+    TRACE(SYSCALL_EXIT, num, result, 0);
+#ifdef SYSCALL_PROFILE
+    syscall_profile_record(num, rdtsc() - profile_start);
+#endif
+    process_check_resched();
+    process_account_syscall_exit();
 }
@@ -1,6 +1,7 @@
 BITS 64
 section .text
 global syscall_entry
+global syscall_exit
 extern syscall_dispatch
 
 syscall_entry:
@@ -8,14 +9,13 @@ syscall_entry:
     
     mov [gs:0], rsp
     
+    ; gs:8 holds the top of the current thread's kernel stack.
     mov rsp, [gs:8]
-    
-    and rsp, ~0xF
-    sub rsp, 8
 
     ; Saved frame layout (rsp = index 0):
     ; 0:rax 1:rdx 2:rsi 3:rdi 4:r8 5:r9 6:r10 7:r12
-    ; 8:r13 9:r14 10:r15 11:rbx 12:rbp 13:rcx 14:r11
+    ; 8:r13 9:r14 10:r15 11:rbx 12:rbp 13:rcx 14:r11 15:user rsp
+    push qword [gs:0]
     push r11
     push rcx
     push rbp
@@ -31,7 +31,12 @@ syscall_entry:
     push rsi
     push rdx
     push rax
-    
+
+%ifndef SYSCALL_IRQS_OFF
+    ; The frame is on this thread's own stack, so interrupts are safe again.
+    sti
+%endif
+
     mov rdi, rsp
     mov rsi, rax
     mov rdx, [rsp + 24]
@@ -40,9 +45,11 @@ syscall_entry:
     mov r9, [rsp + 48]
     
     call syscall_dispatch
-    
-    mov rsp, rax
-    
+
+; Also the first return to user mode of a new thread; rsp points at its frame.
+syscall_exit:
+    cli
+
     pop rax
     pop rdx
     pop rsi
@@ -58,8 +65,7 @@ syscall_entry:
     pop rbp
     pop rcx
     pop r11
-
-    mov rsp, [gs:0]
+    pop rsp
     
     swapgs
     o64 sysret
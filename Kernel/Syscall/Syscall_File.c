@@ -1,22 +1,48 @@
 #include "Syscall_File.h"
+#include "Syscall_Pipe.h"
 
 #include "../Drivers/FileSystem/FAT32/FAT32_Main.h"
 #include "../Memory/Memory_Main.h"
+#include "../ProcessManager/ProcessManager.h"
+#include "../WorkQueue/WorkQueue_Main.h"
+#include "../Serial.h"
 
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 
 #define FILE_MAX_FD 16
+#define FILE_WRITEBACK_DELAY_NS 20000000ULL
 
+#define FILE_KIND_CACHE 0
+#define FILE_KIND_PIPE  1
+
+// One cached copy per open file, shared by every descriptor on it. Writes
+// land here and a worker writes the whole file back after a short delay.
+typedef struct {
+    uint32_t refs;
+    uint8_t dirty;
+    FAT32_FILE file;
+    uint8_t *data;
+    work_item_t writeback;
+} file_cache_t;
+
+// Pipe descriptors reuse writable to tell the write end from the read end.
+// Cached files never block, so their poll source only exists to report
+// POLL_HUP to watchers once the descriptor is closed.
 typedef struct {
     uint8_t used;
     uint8_t writable;
-    FAT32_FILE file;
+    uint8_t kind;
+    file_cache_t *cache;
+    pipe_t *pipe;
     uint32_t offset;
+    poll_source_t poll;
 } kernel_file_t;
 
 static kernel_file_t g_files[FILE_MAX_FD];
+static file_cache_t g_file_caches[FILE_MAX_FD];
+static sleep_lock_t g_file_lock;
 
 static char to_upper_ascii(char c) {
     if (c >= 'a' && c <= 'z') {
@@ -67,11 +93,95 @@ static bool path_to_fat83(const char *path, char out_name[12]) {
     return name_len > 0;
 }
 
+static void file_lock(void) {
+    sleep_lock_acquire(&g_file_lock);
+}
+
+static void file_unlock(void) {
+    sleep_lock_release(&g_file_lock);
+}
+
+static bool file_cache_live(const file_cache_t *cache) {
+    return cache->refs != 0 || cache->dirty || cache->writeback.pending;
+}
+
+static void file_cache_release_locked(file_cache_t *cache) {
+    if (cache->refs == 0 && !cache->dirty && cache->data != NULL) {
+        kfree(cache->data);
+        cache->data = NULL;
+    }
+}
+
+static void file_writeback_work(work_item_t *work) {
+    file_cache_t *cache = (file_cache_t *)((uint8_t *)work - offsetof(file_cache_t, writeback));
+    file_lock();
+    if (cache->dirty && cache->data != NULL) {
+        cache->dirty = 0;
+        if (!fat32_write_file(&cache->file, cache->data)) {
+            serial_write_string("[OS] [FILE] Write-back failed\n");
+        }
+    }
+    file_cache_release_locked(cache);
+    file_unlock();
+}
+
 void syscall_file_init(void) {
     memset(g_files, 0, sizeof(g_files));
+    memset(g_file_caches, 0, sizeof(g_file_caches));
+    for (int32_t i = 0; i < FILE_MAX_FD; ++i) {
+        work_init(&g_file_caches[i].writeback, file_writeback_work);
+    }
+    sleep_lock_init(&g_file_lock);
 }
 
-int32_t syscall_file_open(const char *path, uint64_t flags) {
+static file_cache_t *file_cache_get_locked(const FAT32_FILE *file) {
+    file_cache_t *free_slot = NULL;
+    for (int32_t i = 0; i < FILE_MAX_FD; ++i) {
+        file_cache_t *cache = &g_file_caches[i];
+        if (!file_cache_live(cache)) {
+            if (free_slot == NULL) {
+                free_slot = cache;
+            }
+            continue;
+        }
+        if (cache->file.first_cluster == file->first_cluster &&
+            memcmp(cache->file.name, file->name, 11) == 0) {
+            cache->refs++;
+            return cache;
+        }
+    }
+    if (free_slot == NULL) {
+        return NULL;
+    }
+    free_slot->file = *file;
+    free_slot->refs = 1;
+    free_slot->dirty = 0;
+    free_slot->data = NULL;
+    return free_slot;
+}
+
+static bool file_cache_load_locked(file_cache_t *cache) {
+    if (cache->data != NULL) {
+        return true;
+    }
+    uint8_t *data = (uint8_t *)kmalloc(cache->file.size);
+    if (!data) {
+        return false;
+    }
+    if (!fat32_read_file(&cache->file, data)) {
+        kfree(data);
+        return false;
+    }
+    cache->data = data;
+    return true;
+}
+
+static uint32_t file_cache_poll(poll_source_t *source) {
+    kernel_file_t *f = (kernel_file_t *)((uint8_t *)source - offsetof(kernel_file_t, poll));
+    return POLL_IN | (f->writable ? POLL_OUT : 0);
+}
+
+static int32_t file_open_locked(const char *path, uint64_t flags) {
     char fat_name[12];
     FAT32_FILE file;
 
@@ -85,10 +195,15 @@ int32_t syscall_file_open(const char *path, uint64_t flags) {
 
     for (int32_t fd = 0; fd < FILE_MAX_FD; ++fd) {
         if (!g_files[fd].used) {
+            file_cache_t *cache = file_cache_get_locked(&file);
+            if (cache == NULL) {
+                return -1;
+            }
             g_files[fd].used = 1;
             g_files[fd].writable = (flags & 1u) ? 1u : 0u;
-            g_files[fd].file = file;
+            g_files[fd].cache = cache;
             g_files[fd].offset = 0;
+            poll_source_init(&g_files[fd].poll, file_cache_poll);
             return fd;
         }
     }
@@ -96,88 +211,387 @@ int32_t syscall_file_open(const char *path, uint64_t flags) {
     return -1;
 }
 
-int64_t syscall_file_read(int32_t fd, uint8_t *buffer, uint64_t len) {
-    if (fd < 0 || fd >= FILE_MAX_FD || !buffer || !g_files[fd].used) {
+static kernel_file_t *file_get_locked(int32_t fd) {
+    if (fd < 0 || fd >= FILE_MAX_FD || !g_files[fd].used) {
+        return NULL;
+    }
+    return &g_files[fd];
+}
+
+// Copies out of the cache at an explicit offset; the fd offset is left
+// alone so callers decide whether to advance it.
+static int64_t file_pread_locked(kernel_file_t *f, uint8_t *buffer, uint64_t len, uint64_t offset) {
+    if (!buffer || f->kind != FILE_KIND_CACHE) {
         return -1;
     }
-    if (len == 0) {
+    uint32_t file_size = f->cache->file.size;
+    if (len == 0 || offset >= file_size) {
         return 0;
     }
 
-    kernel_file_t *f = &g_files[fd];
-    uint32_t file_size = f->file.size;
+    uint64_t remaining = (uint64_t)file_size - offset;
+    uint64_t to_read = len < remaining ? len : remaining;
 
-    if (f->offset >= file_size) {
+    if (!file_cache_load_locked(f->cache)) {
+        return -1;
+    }
+
+    memcpy(buffer, f->cache->data + offset, (size_t)to_read);
+    return (int64_t)to_read;
+}
+
+static int64_t file_pwrite_locked(kernel_file_t *f, const uint8_t *buffer, uint64_t len, uint64_t offset,
+                                  file_cache_t **dirtied) {
+    if (!buffer || !f->writable || f->kind != FILE_KIND_CACHE) {
+        return -1;
+    }
+    uint32_t file_size = f->cache->file.size;
+    if (len == 0 || offset >= file_size) {
         return 0;
     }
 
-    uint64_t remaining = (uint64_t)file_size - (uint64_t)f->offset;
-    uint64_t to_read = len < remaining ? len : remaining;
+    uint64_t remaining = (uint64_t)file_size - offset;
+    uint64_t to_write = len < remaining ? len : remaining;
 
-    uint8_t *all_data = (uint8_t *)kmalloc(file_size);
-    if (!all_data) {
+    if (!file_cache_load_locked(f->cache)) {
         return -1;
     }
 
-    if (!fat32_read_file(&f->file, all_data)) {
-        kfree(all_data);
+    memcpy(f->cache->data + offset, buffer, (size_t)to_write);
+    f->cache->dirty = 1;
+    *dirtied = f->cache;
+    return (int64_t)to_write;
+}
+
+// Fills each segment in turn and stops early at end of file, like a
+// sequence of reads would, but under a single lock hold.
+static int64_t file_readv_locked(kernel_file_t *f, const file_iovec_t *iov, uint32_t count, uint64_t offset) {
+    int64_t total = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        int64_t n = file_pread_locked(f, (uint8_t *)iov[i].base, iov[i].len, offset);
+        if (n < 0) {
+            return total != 0 ? total : -1;
+        }
+        total += n;
+        offset += (uint64_t)n;
+        if ((uint64_t)n < iov[i].len) {
+            break;
+        }
+    }
+    return total;
+}
+
+static int64_t file_writev_locked(kernel_file_t *f, const file_iovec_t *iov, uint32_t count, uint64_t offset,
+                                  file_cache_t **dirtied) {
+    int64_t total = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        int64_t n = file_pwrite_locked(f, (const uint8_t *)iov[i].base, iov[i].len, offset, dirtied);
+        if (n < 0) {
+            return total != 0 ? total : -1;
+        }
+        total += n;
+        offset += (uint64_t)n;
+        if ((uint64_t)n < iov[i].len) {
+            break;
+        }
+    }
+    return total;
+}
+
+static int32_t file_close_locked(int32_t fd) {
+    kernel_file_t *f = file_get_locked(fd);
+    if (f == NULL) {
         return -1;
     }
 
-    memcpy(buffer, all_data + f->offset, (size_t)to_read);
-    f->offset += (uint32_t)to_read;
-    kfree(all_data);
+    if (f->kind == FILE_KIND_PIPE) {
+        pipe_close_end(f->pipe, f->writable != 0);
+        pipe_put(f->pipe);
+    } else {
+        poll_source_detach(&f->poll);
+        file_cache_t *cache = f->cache;
+        cache->refs--;
+        file_cache_release_locked(cache);
+    }
+    memset(f, 0, sizeof(*f));
+    return 0;
+}
 
-    return (int64_t)to_read;
+// Pins the pipe so the copy can run, and block, outside the file lock.
+static pipe_t *file_pipe_ref_locked(kernel_file_t *f, bool write_end) {
+    if (f == NULL || f->kind != FILE_KIND_PIPE || (f->writable != 0) != write_end) {
+        return NULL;
+    }
+    pipe_get(f->pipe);
+    return f->pipe;
 }
 
-int64_t syscall_file_write(int32_t fd, const uint8_t *buffer, uint64_t len) {
-    if (fd < 0 || fd >= FILE_MAX_FD || !buffer || !g_files[fd].used) {
+static int32_t file_pipe_locked(int32_t fds[2]) {
+    int32_t slots[2];
+    uint32_t found = 0;
+    for (int32_t fd = 0; fd < FILE_MAX_FD && found < 2; ++fd) {
+        if (!g_files[fd].used) {
+            slots[found++] = fd;
+        }
+    }
+    if (found < 2) {
         return -1;
     }
-    if (!g_files[fd].writable) {
+    pipe_t *pipe = pipe_create();
+    if (pipe == NULL) {
         return -1;
     }
-    if (len == 0) {
-        return 0;
+    for (uint32_t end = 0; end < 2; ++end) {
+        kernel_file_t *f = &g_files[slots[end]];
+        f->used = 1;
+        f->writable = (uint8_t)end;
+        f->kind = FILE_KIND_PIPE;
+        f->pipe = pipe;
+        fds[end] = slots[end];
     }
+    return 0;
+}
 
-    kernel_file_t *f = &g_files[fd];
-    uint32_t file_size = f->file.size;
+// Blocks for the first segment only, like a read into one buffer would.
+static int64_t file_pipe_readv(pipe_t *pipe, const file_iovec_t *iov, uint32_t count) {
+    int64_t total = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (iov[i].base == NULL) {
+            return total != 0 ? total : -1;
+        }
+        int64_t n = pipe_read(pipe, (uint8_t *)iov[i].base, iov[i].len, total == 0);
+        total += n;
+        if ((uint64_t)n < iov[i].len) {
+            break;
+        }
+    }
+    return total;
+}
 
-    if (f->offset >= file_size) {
-        return 0;
+static int64_t file_pipe_writev(pipe_t *pipe, const file_iovec_t *iov, uint32_t count) {
+    int64_t total = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        int64_t n = iov[i].base != NULL ? pipe_write(pipe, (const uint8_t *)iov[i].base, iov[i].len) : -1;
+        if (n < 0) {
+            return total != 0 ? total : -1;
+        }
+        total += n;
+        if ((uint64_t)n < iov[i].len) {
+            break;
+        }
     }
+    return total;
+}
 
-    uint64_t remaining = (uint64_t)file_size - (uint64_t)f->offset;
-    uint64_t to_write = len < remaining ? len : remaining;
+int32_t syscall_file_open(const char *path, uint64_t flags) {
+    file_lock();
+    int32_t fd = file_open_locked(path, flags);
+    file_unlock();
+    return fd;
+}
+
+static bool file_iov_valid(const file_iovec_t *iov, uint32_t count) {
+    return iov != NULL && count != 0 && count <= FILE_IOV_MAX;
+}
+
+// Queued outside the lock: before the workers exist the write-back runs
+// inline and takes the file lock itself.
+static void file_queue_writeback(file_cache_t *dirtied) {
+    if (dirtied != NULL) {
+        workqueue_queue_delayed(&dirtied->writeback, FILE_WRITEBACK_DELAY_NS);
+    }
+}
+
+int64_t syscall_file_read(int32_t fd, uint8_t *buffer, uint64_t len) {
+    int64_t n = -1;
+    pipe_t *pipe = NULL;
+    file_lock();
+    kernel_file_t *f = file_get_locked(fd);
+    if (f != NULL && f->kind == FILE_KIND_PIPE) {
+        pipe = file_pipe_ref_locked(f, false);
+    } else if (f != NULL) {
+        n = file_pread_locked(f, buffer, len, f->offset);
+        if (n > 0) {
+            f->offset += (uint32_t)n;
+        }
+    }
+    file_unlock();
+    if (pipe != NULL) {
+        n = buffer != NULL ? pipe_read(pipe, buffer, len, true) : -1;
+        pipe_put(pipe);
+    }
+    return n;
+}
+
+int64_t syscall_file_write(int32_t fd, const uint8_t *buffer, uint64_t len) {
+    file_cache_t *dirtied = NULL;
+    int64_t n = -1;
+    pipe_t *pipe = NULL;
+    file_lock();
+    kernel_file_t *f = file_get_locked(fd);
+    if (f != NULL && f->kind == FILE_KIND_PIPE) {
+        pipe = file_pipe_ref_locked(f, true);
+    } else if (f != NULL) {
+        n = file_pwrite_locked(f, buffer, len, f->offset, &dirtied);
+        if (n > 0) {
+            f->offset += (uint32_t)n;
+        }
+    }
+    file_unlock();
+    if (pipe != NULL) {
+        n = buffer != NULL ? pipe_write(pipe, buffer, len) : -1;
+        pipe_put(pipe);
+    }
+    file_queue_writeback(dirtied);
+    return n;
+}
 
-    uint8_t *all_data = (uint8_t *)kmalloc(file_size);
-    if (!all_data) {
+// The positional calls never touch the fd offset, so several threads can
+// read one descriptor without seeking around each other.
+int64_t syscall_file_pread(int32_t fd, uint8_t *buffer, uint64_t len, uint64_t offset) {
+    int64_t n = -1;
+    file_lock();
+    kernel_file_t *f = file_get_locked(fd);
+    if (f != NULL) {
+        n = file_pread_locked(f, buffer, len, offset);
+    }
+    file_unlock();
+    return n;
+}
+
+int64_t syscall_file_pwrite(int32_t fd, const uint8_t *buffer, uint64_t len, uint64_t offset) {
+    file_cache_t *dirtied = NULL;
+    int64_t n = -1;
+    file_lock();
+    kernel_file_t *f = file_get_locked(fd);
+    if (f != NULL) {
+        n = file_pwrite_locked(f, buffer, len, offset, &dirtied);
+    }
+    file_unlock();
+    file_queue_writeback(dirtied);
+    return n;
+}
+
+int64_t syscall_file_readv(int32_t fd, const file_iovec_t *iov, uint32_t count) {
+    if (!file_iov_valid(iov, count)) {
         return -1;
     }
+    int64_t n = -1;
+    pipe_t *pipe = NULL;
+    file_lock();
+    kernel_file_t *f = file_get_locked(fd);
+    if (f != NULL && f->kind == FILE_KIND_PIPE) {
+        pipe = file_pipe_ref_locked(f, false);
+    } else if (f != NULL) {
+        n = file_readv_locked(f, iov, count, f->offset);
+        if (n > 0) {
+            f->offset += (uint32_t)n;
+        }
+    }
+    file_unlock();
+    if (pipe != NULL) {
+        n = file_pipe_readv(pipe, iov, count);
+        pipe_put(pipe);
+    }
+    return n;
+}
 
-    if (!fat32_read_file(&f->file, all_data)) {
-        kfree(all_data);
+int64_t syscall_file_writev(int32_t fd, const file_iovec_t *iov, uint32_t count) {
+    if (!file_iov_valid(iov, count)) {
         return -1;
     }
+    file_cache_t *dirtied = NULL;
+    int64_t n = -1;
+    pipe_t *pipe = NULL;
+    file_lock();
+    kernel_file_t *f = file_get_locked(fd);
+    if (f != NULL && f->kind == FILE_KIND_PIPE) {
+        pipe = file_pipe_ref_locked(f, true);
+    } else if (f != NULL) {
+        n = file_writev_locked(f, iov, count, f->offset, &dirtied);
+        if (n > 0) {
+            f->offset += (uint32_t)n;
+        }
+    }
+    file_unlock();
+    if (pipe != NULL) {
+        n = file_pipe_writev(pipe, iov, count);
+        pipe_put(pipe);
+    }
+    file_queue_writeback(dirtied);
+    return n;
+}
 
-    memcpy(all_data + f->offset, buffer, (size_t)to_write);
-    if (!fat32_write_file(&f->file, all_data)) {
-        kfree(all_data);
+// fds[0] is the read end, fds[1] the write end.
+int32_t syscall_file_pipe(int32_t *fds) {
+    if (fds == NULL) {
         return -1;
     }
+    file_lock();
+    int32_t rc = file_pipe_locked(fds);
+    file_unlock();
+    return rc;
+}
 
-    f->offset += (uint32_t)to_write;
-    kfree(all_data);
-    return (int64_t)to_write;
+// The file lock keeps the descriptor, and so its source, open until the
+// watcher is linked.
+int32_t syscall_file_poll_attach(int32_t fd, int32_t set_id, const poll_event_t *event) {
+    int32_t rc = -1;
+    file_lock();
+    kernel_file_t *f = file_get_locked(fd);
+    if (f != NULL && f->kind == FILE_KIND_PIPE) {
+        rc = poll_attach(set_id, event, pipe_poll_source(f->pipe, f->writable != 0), 0);
+    } else if (f != NULL) {
+        rc = poll_attach(set_id, event, &f->poll, 0);
+    }
+    file_unlock();
+    return rc;
 }
 
 int32_t syscall_file_close(int32_t fd) {
-    if (fd < 0 || fd >= FILE_MAX_FD || !g_files[fd].used) {
-        return -1;
+    file_lock();
+    int32_t rc = file_close_locked(fd);
+    file_unlock();
+    return rc;
+}
+
+int64_t syscall_file_size(const char *path) {
+    char fat_name[12];
+    FAT32_FILE file;
+    int64_t size = -1;
+    file_lock();
+    if (path_to_fat83(path, fat_name) && fat32_find_file(fat_name, &file)) {
+        size = file.size;
     }
+    file_unlock();
+    return size;
+}
 
-    memset(&g_files[fd], 0, sizeof(g_files[fd]));
-    return 0;
+// Overwrites a whole file in place for kernel writers such as the trace
+// dump. data must hold capacity bytes; everything past size up to the
+// file's length is zeroed. A cached copy takes the new contents and is
+// marked clean so a pending write-back cannot overwrite them.
+bool syscall_file_replace(const char *path, uint8_t *data, uint64_t size, uint64_t capacity) {
+    char fat_name[12];
+    FAT32_FILE file;
+    bool ok = false;
+    file_lock();
+    if (path_to_fat83(path, fat_name) && fat32_find_file(fat_name, &file) && file.size >= size &&
+        file.size <= capacity) {
+        memset(data + size, 0, (size_t)(file.size - size));
+        ok = fat32_write_file(&file, data);
+        for (int32_t i = 0; ok && i < FILE_MAX_FD; ++i) {
+            file_cache_t *cache = &g_file_caches[i];
+            if (file_cache_live(cache) && cache->file.first_cluster == file.first_cluster &&
+                memcmp(cache->file.name, file.name, 11) == 0) {
+                if (cache->data != NULL) {
+                    memcpy(cache->data, data, file.size);
+                }
+                cache->dirty = 0;
+                file_cache_release_locked(cache);
+            }
+        }
+    }
+    file_unlock();
+    return ok;
 }
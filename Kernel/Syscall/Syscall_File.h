@@ -1,9 +1,27 @@
 #pragma once
 
+#include "../ProcessManager/ProcessManager.h"
+
+#include <stdbool.h>
 #include <stdint.h>
 
+#define FILE_IOV_MAX 64
+
+typedef struct {
+    void *base;
+    uint64_t len;
+} file_iovec_t;
+
 void syscall_file_init(void);
 int32_t syscall_file_open(const char *path, uint64_t flags);
 int64_t syscall_file_read(int32_t fd, uint8_t *buffer, uint64_t len);
 int64_t syscall_file_write(int32_t fd, const uint8_t *buffer, uint64_t len);
+int64_t syscall_file_pread(int32_t fd, uint8_t *buffer, uint64_t len, uint64_t offset);
+int64_t syscall_file_pwrite(int32_t fd, const uint8_t *buffer, uint64_t len, uint64_t offset);
+int64_t syscall_file_readv(int32_t fd, const file_iovec_t *iov, uint32_t count);
+int64_t syscall_file_writev(int32_t fd, const file_iovec_t *iov, uint32_t count);
+int32_t syscall_file_pipe(int32_t *fds);
+int32_t syscall_file_poll_attach(int32_t fd, int32_t set_id, const poll_event_t *event);
 int32_t syscall_file_close(int32_t fd);
+int64_t syscall_file_size(const char *path);
+bool syscall_file_replace(const char *path, uint8_t *data, uint64_t size, uint64_t capacity);
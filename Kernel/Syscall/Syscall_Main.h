@@ -1,5 +1,7 @@
 #pragma once
+#include <stdbool.h>
 #include <stdint.h>
+#include "../CPU/CPU_Main.h"
 
 #define SYSCALL_SERIAL_PUTCHAR  1
 #define SYSCALL_SERIAL_PUTS     2
@@ -7,17 +9,52 @@
 #define SYSCALL_PROCESS_YIELD   4
 #define SYSCALL_PROCESS_EXIT    5
 #define SYSCALL_THREAD_CREATE   6
+#define SYSCALL_PROCESS_SET_PRIORITY 7
+#define SYSCALL_PROCESS_GET_PRIORITY 8
+#define SYSCALL_PROCESS_CPU     9
 #define SYSCALL_DRAW_PIXEL      10
 #define SYSCALL_DRAW_FILL_RECT  11
 #define SYSCALL_DRAW_PRESENT    12
+#define SYSCALL_PROCESS_WAIT    13
+#define SYSCALL_PROCESS_SLEEP   14
+#define SYSCALL_TIMER_STATS     15
+#define SYSCALL_THREAD_JOIN     16
+#define SYSCALL_THREAD_SET_FS   17
+#define SYSCALL_THREAD_ID       18
+#define SYSCALL_PROCESS_ID      19
 #define SYSCALL_FILE_OPEN       20
 #define SYSCALL_FILE_READ       21
 #define SYSCALL_FILE_WRITE      22
 #define SYSCALL_FILE_CLOSE      23
-#define SYSCALL_USER_KMALLOC    24
-#define SYSCALL_USER_KFREE      25
-#define SYSCALL_USER_MEMCPY     26
-#define SYSCALL_USER_MEMCMP     27
+#define SYSCALL_MEM_MAP         24
+#define SYSCALL_MEM_UNMAP       25
+#define SYSCALL_FUTEX_WAIT      28
+#define SYSCALL_FUTEX_WAKE      29
+#define SYSCALL_PROFILE_READ    30
+#define SYSCALL_PROCESS_SNAPSHOT 31
+#define SYSCALL_SCHED_SET       32
+#define SYSCALL_SET_AFFINITY    33
+#define SYSCALL_GET_AFFINITY    34
+#define SYSCALL_CPU_TOPOLOGY    35
+#define SYSCALL_RING_SETUP      36
+#define SYSCALL_RING_ENTER      37
+#define SYSCALL_RING_DESTROY    38
+#define SYSCALL_SERIAL_STATS    39
+#define SYSCALL_TRACE_CTL       40
+#define SYSCALL_FILE_PREAD      41
+#define SYSCALL_FILE_PWRITE     42
+#define SYSCALL_FILE_READV      43
+#define SYSCALL_FILE_WRITEV     44
+#define SYSCALL_FILE_PIPE       45
+#define SYSCALL_CHANNEL_CREATE  46
+#define SYSCALL_CHANNEL_DESTROY 47
+#define SYSCALL_CHANNEL_SEND    48
+#define SYSCALL_CHANNEL_CALL    49
+#define SYSCALL_CHANNEL_RECEIVE 50
+#define SYSCALL_POLL_CREATE     51
+#define SYSCALL_POLL_DESTROY    52
+#define SYSCALL_POLL_CTL        53
+#define SYSCALL_POLL_WAIT       54
 
 #define SYSCALL_FRAME_RAX 0
 #define SYSCALL_FRAME_RDX 1
@@ -34,15 +71,44 @@
 #define SYSCALL_FRAME_RBP 12
 #define SYSCALL_FRAME_RCX 13
 #define SYSCALL_FRAME_R11 14
-#define SYSCALL_FRAME_QWORDS 15
+#define SYSCALL_FRAME_USER_RSP 15
+#define SYSCALL_FRAME_QWORDS 16
+
+#define SYSCALL_TABLE_SIZE      64
+
+// The call can block, yield or make another task runnable. Calls without
+// it skip the system-time accounting and only look at need_resched.
+#define SYSCALL_FLAG_SCHED      (1u << 0)
+
+typedef uint64_t (*syscall_handler_t)(const uint64_t *args);
+
+typedef struct {
+    syscall_handler_t handler;
+    uint8_t argc;
+    uint8_t flags;
+} syscall_entry_t;
+
+// Dispatch cost histogram: 4 sub-buckets per power of two of TSC cycles.
+#define SYSCALL_PROFILE_SLOTS   SYSCALL_TABLE_SIZE
+#define SYSCALL_PROFILE_BUCKETS 160
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_cycles;
+    uint64_t max_cycles;
+    uint64_t buckets[SYSCALL_PROFILE_BUCKETS];
+} syscall_profile_t;
 
 void syscall_init(void);
-uint64_t syscall_get_user_rsp(void);
-void syscall_set_user_rsp(uint64_t user_rsp);
-
-uint64_t syscall_dispatch(uint64_t saved_rsp,
-                          uint64_t num,
-                          uint64_t arg1,
-                          uint64_t arg2,
-                          uint64_t arg3,
-                          uint64_t arg4);
+bool syscall_init_cpu(cpu_local_t *cpu);
+void syscall_exit(void);
+void syscall_profile_record(uint64_t num, uint64_t cycles);
+int32_t syscall_profile_read(uint64_t num, syscall_profile_t *out);
+
+const syscall_entry_t *syscall_lookup(uint64_t num);
+void syscall_dispatch(uint64_t saved_rsp,
+                      uint64_t num,
+                      uint64_t arg1,
+                      uint64_t arg2,
+                      uint64_t arg3,
+                      uint64_t arg4);
@@ -0,0 +1,92 @@
+#include "Syscall_Memory.h"
+
+#include "../Memory/Memory_Main.h"
+#include "../ProcessManager/ProcessManager.h"
+#include "../Sync/Sync_Main.h"
+
+#include <stddef.h>
+
+#define MEM_MAP_REGIONS 256
+
+typedef struct {
+    void *addr;
+    uint32_t pages;
+    int32_t owner;
+} mem_region_t;
+
+static mem_region_t g_regions[MEM_MAP_REGIONS];
+static spinlock_t g_regions_lock = SPINLOCK_INIT;
+
+void syscall_memory_init(void) {
+    for (uint32_t i = 0; i < MEM_MAP_REGIONS; ++i) {
+        g_regions[i].addr = NULL;
+        g_regions[i].pages = 0;
+        g_regions[i].owner = -1;
+    }
+}
+
+// Hands out whole pages to the calling process. Regions are remembered so
+// that unmap can only give back exactly what map returned to that process.
+void *syscall_mem_map(uint32_t pages) {
+    if (pages == 0 || pages > MEM_MAP_MAX_PAGES) {
+        return NULL;
+    }
+    void *addr = alloc_pages(pages);
+    if (addr == NULL) {
+        return NULL;
+    }
+
+    uint64_t flags = spinlock_acquire_irqsave(&g_regions_lock);
+    for (uint32_t i = 0; i < MEM_MAP_REGIONS; ++i) {
+        if (g_regions[i].addr == NULL) {
+            g_regions[i].addr = addr;
+            g_regions[i].pages = pages;
+            g_regions[i].owner = process_current_tgid();
+            spinlock_release_irqrestore(&g_regions_lock, flags);
+            return addr;
+        }
+    }
+    spinlock_release_irqrestore(&g_regions_lock, flags);
+    free_pages(addr, pages);
+    return NULL;
+}
+
+int32_t syscall_mem_unmap(void *addr, uint32_t pages) {
+    int32_t owner = process_current_tgid();
+    uint64_t flags = spinlock_acquire_irqsave(&g_regions_lock);
+    for (uint32_t i = 0; i < MEM_MAP_REGIONS; ++i) {
+        mem_region_t *region = &g_regions[i];
+        if (region->addr == addr && addr != NULL) {
+            if (region->pages != pages || region->owner != owner) {
+                break;
+            }
+            region->addr = NULL;
+            region->pages = 0;
+            region->owner = -1;
+            spinlock_release_irqrestore(&g_regions_lock, flags);
+            free_pages(addr, pages);
+            return 0;
+        }
+    }
+    spinlock_release_irqrestore(&g_regions_lock, flags);
+    return -1;
+}
+
+// Moves a whole region to another owner without touching its pages, so
+// channels can pass buffers along instead of copying them.
+int32_t syscall_memory_transfer(void *addr, uint32_t pages, int32_t from, int32_t to) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_regions_lock);
+    for (uint32_t i = 0; i < MEM_MAP_REGIONS; ++i) {
+        mem_region_t *region = &g_regions[i];
+        if (region->addr == addr && addr != NULL) {
+            if (region->pages != pages || region->owner != from) {
+                break;
+            }
+            region->owner = to;
+            spinlock_release_irqrestore(&g_regions_lock, flags);
+            return 0;
+        }
+    }
+    spinlock_release_irqrestore(&g_regions_lock, flags);
+    return -1;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+
+#define MEM_MAP_MAX_PAGES 4096
+#define MEM_OWNER_IN_FLIGHT (-2)
+
+void syscall_memory_init(void);
+void *syscall_mem_map(uint32_t pages);
+int32_t syscall_mem_unmap(void *addr, uint32_t pages);
+int32_t syscall_memory_transfer(void *addr, uint32_t pages, int32_t from, int32_t to);
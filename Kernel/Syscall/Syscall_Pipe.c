@@ -0,0 +1,190 @@
+#include "Syscall_Pipe.h"
+
+#include "../Memory/Memory_Main.h"
+#include "../ProcessManager/ProcessManager.h"
+
+#include <stddef.h>
+#include <string.h>
+
+typedef struct {
+    wait_queue_t queue;
+    volatile uint32_t waiting;
+} pipe_waiter_t;
+
+// head is only advanced by the writer and tail only by the reader, so the
+// data path needs no lock. Each end has a sleep lock that keeps it to one
+// producer and one consumer when an fd is shared between threads.
+struct pipe {
+    volatile uint64_t head;
+    uint8_t pad_head[56];
+    volatile uint64_t tail;
+    uint8_t pad_tail[56];
+    uint8_t *buffer;
+    volatile uint32_t refs;
+    volatile uint32_t readers;
+    volatile uint32_t writers;
+    sleep_lock_t read_lock;
+    sleep_lock_t write_lock;
+    pipe_waiter_t readable;
+    pipe_waiter_t writable;
+    poll_source_t read_src;
+    poll_source_t write_src;
+};
+
+static uint32_t pipe_read_poll(poll_source_t *source) {
+    pipe_t *pipe = (pipe_t *)((uint8_t *)source - offsetof(pipe_t, read_src));
+    uint32_t mask = __atomic_load_n(&pipe->head, __ATOMIC_ACQUIRE) != pipe->tail ? POLL_IN : 0;
+    return mask | (__atomic_load_n(&pipe->writers, __ATOMIC_ACQUIRE) == 0 ? POLL_HUP : 0);
+}
+
+static uint32_t pipe_write_poll(poll_source_t *source) {
+    pipe_t *pipe = (pipe_t *)((uint8_t *)source - offsetof(pipe_t, write_src));
+    uint64_t used = pipe->head - __atomic_load_n(&pipe->tail, __ATOMIC_ACQUIRE);
+    uint32_t mask = used < PIPE_BUFFER_SIZE ? POLL_OUT : 0;
+    return mask | (__atomic_load_n(&pipe->readers, __ATOMIC_ACQUIRE) == 0 ? POLL_ERR : 0);
+}
+
+pipe_t *pipe_create(void) {
+    pipe_t *pipe = (pipe_t *)kmalloc(sizeof(pipe_t));
+    if (pipe == NULL) {
+        return NULL;
+    }
+    memset(pipe, 0, sizeof(*pipe));
+    pipe->buffer = (uint8_t *)alloc_pages(PIPE_BUFFER_PAGES);
+    if (pipe->buffer == NULL) {
+        kfree(pipe);
+        return NULL;
+    }
+    pipe->refs = 2;
+    pipe->readers = 1;
+    pipe->writers = 1;
+    sleep_lock_init(&pipe->read_lock);
+    sleep_lock_init(&pipe->write_lock);
+    wait_queue_init(&pipe->readable.queue);
+    wait_queue_init(&pipe->writable.queue);
+    poll_source_init(&pipe->read_src, pipe_read_poll);
+    poll_source_init(&pipe->write_src, pipe_write_poll);
+    return pipe;
+}
+
+void pipe_get(pipe_t *pipe) {
+    __atomic_fetch_add(&pipe->refs, 1, __ATOMIC_RELAXED);
+}
+
+void pipe_put(pipe_t *pipe) {
+    if (__atomic_sub_fetch(&pipe->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free_pages(pipe->buffer, PIPE_BUFFER_PAGES);
+        kfree(pipe);
+    }
+}
+
+static bool pipe_can_read(pipe_t *pipe) {
+    return __atomic_load_n(&pipe->head, __ATOMIC_ACQUIRE) != pipe->tail ||
+           __atomic_load_n(&pipe->writers, __ATOMIC_ACQUIRE) == 0;
+}
+
+static bool pipe_can_write(pipe_t *pipe) {
+    return pipe->head - __atomic_load_n(&pipe->tail, __ATOMIC_ACQUIRE) < PIPE_BUFFER_SIZE ||
+           __atomic_load_n(&pipe->readers, __ATOMIC_ACQUIRE) == 0;
+}
+
+// The flag is raised before the last check and the waker fences before
+// testing it, so a wake between the check and the sleep is not lost; the
+// queue lock held across both keeps the waker behind the enqueue.
+static void pipe_wait(pipe_t *pipe, pipe_waiter_t *waiter, bool (*ready)(pipe_t *pipe)) {
+    uint64_t flags = spinlock_acquire_irqsave(&waiter->queue.lock);
+    __atomic_store_n(&waiter->waiting, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!ready(pipe)) {
+        process_sleep_locked(&waiter->queue, &waiter->queue.lock);
+    }
+    spinlock_release_irqrestore(&waiter->queue.lock, flags);
+}
+
+static void pipe_wake(pipe_waiter_t *waiter) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&waiter->waiting, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(&waiter->waiting, 0, __ATOMIC_ACQ_REL)) {
+        wait_queue_wake(&waiter->queue, UINT32_MAX, 0);
+    }
+}
+
+poll_source_t *pipe_poll_source(pipe_t *pipe, bool write_end) {
+    return write_end ? &pipe->write_src : &pipe->read_src;
+}
+
+void pipe_close_end(pipe_t *pipe, bool write_end) {
+    if (write_end) {
+        __atomic_sub_fetch(&pipe->writers, 1, __ATOMIC_ACQ_REL);
+        poll_source_detach(&pipe->write_src);
+        pipe_wake(&pipe->readable);
+        poll_source_notify(&pipe->read_src);
+    } else {
+        __atomic_sub_fetch(&pipe->readers, 1, __ATOMIC_ACQ_REL);
+        poll_source_detach(&pipe->read_src);
+        pipe_wake(&pipe->writable);
+        poll_source_notify(&pipe->write_src);
+    }
+}
+
+// Returns as soon as some data was copied, 0 once the buffer is empty and
+// every writer has closed. Non-blocking calls return 0 when empty.
+int64_t pipe_read(pipe_t *pipe, uint8_t *buffer, uint64_t len, bool block) {
+    if (len == 0) {
+        return 0;
+    }
+    sleep_lock_acquire(&pipe->read_lock);
+    uint64_t tail = pipe->tail;
+    uint64_t head = __atomic_load_n(&pipe->head, __ATOMIC_ACQUIRE);
+    while (head == tail) {
+        if (!block || __atomic_load_n(&pipe->writers, __ATOMIC_ACQUIRE) == 0) {
+            sleep_lock_release(&pipe->read_lock);
+            return 0;
+        }
+        pipe_wait(pipe, &pipe->readable, pipe_can_read);
+        head = __atomic_load_n(&pipe->head, __ATOMIC_ACQUIRE);
+    }
+
+    uint64_t avail = head - tail;
+    uint64_t n = len < avail ? len : avail;
+    uint64_t pos = tail % PIPE_BUFFER_SIZE;
+    uint64_t first = PIPE_BUFFER_SIZE - pos < n ? PIPE_BUFFER_SIZE - pos : n;
+    memcpy(buffer, pipe->buffer + pos, (size_t)first);
+    memcpy(buffer + first, pipe->buffer, (size_t)(n - first));
+    __atomic_store_n(&pipe->tail, tail + n, __ATOMIC_RELEASE);
+    sleep_lock_release(&pipe->read_lock);
+
+    pipe_wake(&pipe->writable);
+    poll_source_notify(&pipe->write_src);
+    return (int64_t)n;
+}
+
+// Blocks until everything is queued; fails with -1 if no reader is left
+// before the first byte, otherwise returns how much got in.
+int64_t pipe_write(pipe_t *pipe, const uint8_t *buffer, uint64_t len) {
+    uint64_t done = 0;
+    sleep_lock_acquire(&pipe->write_lock);
+    while (done < len) {
+        if (__atomic_load_n(&pipe->readers, __ATOMIC_ACQUIRE) == 0) {
+            break;
+        }
+        uint64_t head = pipe->head;
+        uint64_t space = PIPE_BUFFER_SIZE - (head - __atomic_load_n(&pipe->tail, __ATOMIC_ACQUIRE));
+        if (space == 0) {
+            pipe_wait(pipe, &pipe->writable, pipe_can_write);
+            continue;
+        }
+
+        uint64_t n = len - done < space ? len - done : space;
+        uint64_t pos = head % PIPE_BUFFER_SIZE;
+        uint64_t first = PIPE_BUFFER_SIZE - pos < n ? PIPE_BUFFER_SIZE - pos : n;
+        memcpy(pipe->buffer + pos, buffer + done, (size_t)first);
+        memcpy(pipe->buffer, buffer + done + first, (size_t)(n - first));
+        __atomic_store_n(&pipe->head, head + n, __ATOMIC_RELEASE);
+        done += n;
+        pipe_wake(&pipe->readable);
+        poll_source_notify(&pipe->read_src);
+    }
+    sleep_lock_release(&pipe->write_lock);
+    return done != 0 || len == 0 ? (int64_t)done : -1;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../ProcessManager/ProcessManager.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PIPE_BUFFER_PAGES 16
+#define PIPE_BUFFER_SIZE  (PIPE_BUFFER_PAGES * 4096ULL)
+
+typedef struct pipe pipe_t;
+
+pipe_t *pipe_create(void);
+void pipe_get(pipe_t *pipe);
+void pipe_put(pipe_t *pipe);
+void pipe_close_end(pipe_t *pipe, bool write_end);
+int64_t pipe_read(pipe_t *pipe, uint8_t *buffer, uint64_t len, bool block);
+int64_t pipe_write(pipe_t *pipe, const uint8_t *buffer, uint64_t len);
+poll_source_t *pipe_poll_source(pipe_t *pipe, bool write_end);
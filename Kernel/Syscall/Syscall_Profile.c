@@ -0,0 +1,56 @@
+#include "Syscall_Main.h"
+#include <stddef.h>
+
+#ifdef SYSCALL_PROFILE
+static syscall_profile_t g_syscall_profile[SYSCALL_PROFILE_SLOTS];
+
+static uint32_t syscall_profile_bucket(uint64_t cycles) {
+    if (cycles < 4) {
+        return (uint32_t)cycles;
+    }
+    uint32_t msb = 63u - (uint32_t)__builtin_clzll(cycles);
+    uint32_t sub = (uint32_t)(cycles >> (msb - 2)) & 3u;
+    uint32_t index = (msb - 1) * 4 + sub;
+    return index < SYSCALL_PROFILE_BUCKETS ? index : SYSCALL_PROFILE_BUCKETS - 1;
+}
+#endif
+
+void syscall_profile_record(uint64_t num, uint64_t cycles) {
+#ifdef SYSCALL_PROFILE
+    if (num >= SYSCALL_PROFILE_SLOTS) {
+        return;
+    }
+    syscall_profile_t *profile = &g_syscall_profile[num];
+    __atomic_fetch_add(&profile->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&profile->total_cycles, cycles, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&profile->buckets[syscall_profile_bucket(cycles)], 1, __ATOMIC_RELAXED);
+    uint64_t seen = __atomic_load_n(&profile->max_cycles, __ATOMIC_RELAXED);
+    while (cycles > seen &&
+           !__atomic_compare_exchange_n(&profile->max_cycles, &seen, cycles, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+#else
+    (void)num;
+    (void)cycles;
+#endif
+}
+
+int32_t syscall_profile_read(uint64_t num, syscall_profile_t *out) {
+#ifdef SYSCALL_PROFILE
+    if (out == NULL || num >= SYSCALL_PROFILE_SLOTS) {
+        return -1;
+    }
+    syscall_profile_t *profile = &g_syscall_profile[num];
+    out->count = profile->count;
+    out->total_cycles = profile->total_cycles;
+    out->max_cycles = profile->max_cycles;
+    for (uint32_t i = 0; i < SYSCALL_PROFILE_BUCKETS; ++i) {
+        out->buckets[i] = profile->buckets[i];
+    }
+    return 0;
+#else
+    (void)num;
+    (void)out;
+    return -1;
+#endif
+}
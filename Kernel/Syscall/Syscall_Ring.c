@@ -0,0 +1,175 @@
+#include "Syscall_Ring.h"
+#include "Syscall_File.h"
+
+#include "../Drivers/Display/Display_Main.h"
+#include "../ProcessManager/ProcessManager.h"
+#include "../Sync/Sync_Main.h"
+
+#include <stddef.h>
+
+#define RING_MAX 16
+
+// Geometry and array pointers are copied at setup; the io_ring_t copies
+// stay writable by the process and are never read back.
+typedef struct {
+    io_ring_t *ring;
+    ring_sqe_t *sqes;
+    ring_cqe_t *cqes;
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    int32_t owner;
+    sleep_lock_t lock;
+} kernel_ring_t;
+
+static kernel_ring_t g_rings[RING_MAX];
+static spinlock_t g_rings_lock = SPINLOCK_INIT;
+
+static bool ring_entries_valid(uint32_t entries) {
+    return entries != 0 && entries <= RING_MAX_ENTRIES && (entries & (entries - 1)) == 0;
+}
+
+void syscall_ring_init(void) {
+    for (uint32_t i = 0; i < RING_MAX; ++i) {
+        g_rings[i].ring = NULL;
+        g_rings[i].owner = -1;
+        sleep_lock_init(&g_rings[i].lock);
+    }
+}
+
+static kernel_ring_t *ring_lookup(int32_t ring_id) {
+    if (ring_id < 0 || ring_id >= RING_MAX) {
+        return NULL;
+    }
+    kernel_ring_t *kring = &g_rings[ring_id];
+    if (kring->ring == NULL || kring->owner != process_current_tgid()) {
+        return NULL;
+    }
+    return kring;
+}
+
+// Registers a ring for the calling process; returns its id.
+int32_t syscall_ring_setup(io_ring_t *ring) {
+    if (ring == NULL) {
+        return -1;
+    }
+    ring_sqe_t *sqes = ring->sqes;
+    ring_cqe_t *cqes = ring->cqes;
+    uint32_t sq_entries = ring->sq_entries;
+    uint32_t cq_entries = ring->cq_entries;
+    if (sqes == NULL || cqes == NULL || !ring_entries_valid(sq_entries) || !ring_entries_valid(cq_entries)) {
+        return -1;
+    }
+    ring->sq_head = ring->sq_tail;
+    ring->cq_tail = ring->cq_head;
+
+    int32_t id = -1;
+    uint64_t flags = spinlock_acquire_irqsave(&g_rings_lock);
+    for (int32_t i = 0; i < RING_MAX; ++i) {
+        if (g_rings[i].ring == NULL) {
+            g_rings[i].ring = ring;
+            g_rings[i].sqes = sqes;
+            g_rings[i].cqes = cqes;
+            g_rings[i].sq_entries = sq_entries;
+            g_rings[i].cq_entries = cq_entries;
+            g_rings[i].owner = process_current_tgid();
+            id = i;
+            break;
+        }
+    }
+    spinlock_release_irqrestore(&g_rings_lock, flags);
+    return id;
+}
+
+int32_t syscall_ring_destroy(int32_t ring_id) {
+    kernel_ring_t *kring = ring_lookup(ring_id);
+    if (kring == NULL) {
+        return -1;
+    }
+    sleep_lock_acquire(&kring->lock);
+    uint64_t flags = spinlock_acquire_irqsave(&g_rings_lock);
+    kring->ring = NULL;
+    kring->owner = -1;
+    spinlock_release_irqrestore(&g_rings_lock, flags);
+    sleep_lock_release(&kring->lock);
+    return 0;
+}
+
+// Called once the last thread of tgid has exited, so none of its threads
+// can be inside ring_enter and the sleep lock is not needed.
+void syscall_ring_release_owner(int32_t tgid) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_rings_lock);
+    for (int32_t i = 0; i < RING_MAX; ++i) {
+        if (g_rings[i].ring != NULL && g_rings[i].owner == tgid) {
+            g_rings[i].ring = NULL;
+            g_rings[i].owner = -1;
+        }
+    }
+    spinlock_release_irqrestore(&g_rings_lock, flags);
+}
+
+static int64_t ring_execute(const ring_sqe_t *sqe) {
+    switch (sqe->op) {
+    case RING_OP_NOP:
+        return 0;
+    case RING_OP_FILE_READ:
+        return syscall_file_read(sqe->fd, (uint8_t *)sqe->addr, sqe->len);
+    case RING_OP_FILE_WRITE:
+        return syscall_file_write(sqe->fd, (const uint8_t *)sqe->addr, sqe->len);
+    case RING_OP_DRAW_FILL_RECT:
+        display_fill_rect((uint32_t)(sqe->addr >> 32),
+                          (uint32_t)(sqe->addr & 0xFFFFFFFFu),
+                          (uint32_t)(sqe->len >> 32),
+                          (uint32_t)(sqe->len & 0xFFFFFFFFu),
+                          (uint32_t)sqe->arg);
+        return 0;
+    case RING_OP_DRAW_PRESENT:
+        display_present();
+        return 0;
+    case RING_OP_YIELD:
+        process_sched_yield();
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+// Runs up to to_submit queued entries in order and posts one completion
+// for each. Stops early when the completion ring is full; returns how many
+// entries were consumed.
+int64_t syscall_ring_enter(int32_t ring_id, uint32_t to_submit) {
+    kernel_ring_t *kring = ring_lookup(ring_id);
+    if (kring == NULL) {
+        return -1;
+    }
+    sleep_lock_acquire(&kring->lock);
+    io_ring_t *ring = kring->ring;
+    if (ring == NULL) {
+        sleep_lock_release(&kring->lock);
+        return -1;
+    }
+
+    uint32_t sq_mask = kring->sq_entries - 1;
+    uint32_t cq_mask = kring->cq_entries - 1;
+    uint32_t head = ring->sq_head;
+    uint32_t tail = __atomic_load_n(&ring->sq_tail, __ATOMIC_ACQUIRE);
+    uint32_t cq_tail = ring->cq_tail;
+    uint32_t done = 0;
+    while (done < to_submit && head != tail) {
+        if (cq_tail - __atomic_load_n(&ring->cq_head, __ATOMIC_ACQUIRE) >= kring->cq_entries) {
+            break;
+        }
+        ring_sqe_t sqe = kring->sqes[head & sq_mask];
+        head++;
+        __atomic_store_n(&ring->sq_head, head, __ATOMIC_RELEASE);
+
+        ring_cqe_t *cqe = &kring->cqes[cq_tail & cq_mask];
+        cqe->result = ring_execute(&sqe);
+        cqe->user_data = sqe.user_data;
+        cq_tail++;
+        __atomic_store_n(&ring->cq_tail, cq_tail, __ATOMIC_RELEASE);
+        done++;
+        process_preempt_point();
+    }
+    sleep_lock_release(&kring->lock);
+    return done;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+#define RING_OP_NOP            0
+#define RING_OP_FILE_READ      1
+#define RING_OP_FILE_WRITE     2
+#define RING_OP_DRAW_FILL_RECT 3
+#define RING_OP_DRAW_PRESENT   4
+#define RING_OP_YIELD          5
+
+#define RING_MAX_ENTRIES 4096
+
+// For DRAW_FILL_RECT addr packs x:y and len packs w:h (high:low 32 bits),
+// arg is the colour. File ops use fd, addr as the buffer and len.
+typedef struct {
+    uint32_t op;
+    int32_t fd;
+    uint64_t addr;
+    uint64_t len;
+    uint64_t arg;
+    uint64_t user_data;
+} ring_sqe_t;
+
+typedef struct {
+    uint64_t user_data;
+    int64_t result;
+} ring_cqe_t;
+
+// Lives in user memory. Userland advances sq_tail and cq_head, the kernel
+// sq_head and cq_tail; indices run freely and are masked by entries - 1.
+typedef struct {
+    volatile uint32_t sq_head;
+    volatile uint32_t sq_tail;
+    volatile uint32_t cq_head;
+    volatile uint32_t cq_tail;
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    ring_sqe_t *sqes;
+    ring_cqe_t *cqes;
+} io_ring_t;
+
+void syscall_ring_init(void);
+int32_t syscall_ring_setup(io_ring_t *ring);
+int64_t syscall_ring_enter(int32_t ring_id, uint32_t to_submit);
+int32_t syscall_ring_destroy(int32_t ring_id);
+void syscall_ring_release_owner(int32_t tgid);
@@ -0,0 +1,252 @@
+#include "Timer_Main.h"
+#include "../APIC/APIC_Main.h"
+#include "../CPU/CPU_Main.h"
+#include "../IDT/IDT_Main.h"
+#include "../Sync/Sync_Main.h"
+#include "../Serial.h"
+#include <stddef.h>
+
+#define TIMER_CALIBRATE_US 10000u
+#define TIMER_NS_PER_SEC 1000000000ULL
+#define CPUID_1_ECX_TSC_DEADLINE (1u << 24)
+#define IA32_TSC_DEADLINE 0x6E0
+#define TIMER_LATENCY_SLOW_NS 100000ULL
+
+typedef struct {
+    spinlock_t lock;
+    timer_event_t *head;
+    uint64_t slice_end;
+    uint64_t programmed;
+    uint64_t timer_interrupts;
+    uint64_t latency_samples;
+    uint64_t latency_total;
+    uint64_t latency_max;
+    uint64_t latency_slow;
+} timer_cpu_t;
+
+static timer_cpu_t g_timer_cpus[CPU_MAX];
+static uint64_t g_tsc_hz = 0;
+static uint64_t g_lapic_hz = 0;
+static bool g_tsc_deadline = false;
+static uint64_t g_latency_slow_tsc = 0;
+
+static uint64_t tsc_to_lapic_ticks(uint64_t delta) {
+    if (delta > g_tsc_hz) {
+        delta = g_tsc_hz;
+    }
+    uint64_t ticks = (delta * g_lapic_hz) / g_tsc_hz;
+    return ticks ? ticks : 1;
+}
+
+static void timer_program(timer_cpu_t *timer) {
+    uint64_t deadline = timer->slice_end;
+    if (timer->head != NULL && (deadline == 0 || timer->head->deadline < deadline)) {
+        deadline = timer->head->deadline;
+    }
+#ifdef TIMER_PERIODIC_HZ
+    uint64_t tick = rdtsc() + g_tsc_hz / TIMER_PERIODIC_HZ;
+    if (deadline == 0 || tick < deadline) {
+        deadline = tick;
+    }
+#endif
+    if (deadline == timer->programmed) {
+        return;
+    }
+    timer->programmed = deadline;
+
+    if (g_tsc_deadline) {
+        wrmsr(IA32_TSC_DEADLINE, deadline);
+        return;
+    }
+    if (deadline == 0) {
+        apic_timer_oneshot(0);
+        return;
+    }
+    uint64_t now = rdtsc();
+    apic_timer_oneshot((uint32_t)tsc_to_lapic_ticks(deadline > now ? deadline - now : 0));
+}
+
+static void timer_irq(void) {
+    timer_cpu_t *timer = &g_timer_cpus[cpu_current()->index];
+    uint64_t now = rdtsc();
+
+    spinlock_acquire(&timer->lock);
+    timer->timer_interrupts++;
+    // How late the handler runs past the programmed deadline is the time
+    // this CPU spent with interrupts masked.
+    if (timer->programmed != 0 && now >= timer->programmed) {
+        uint64_t late = now - timer->programmed;
+        timer->latency_samples++;
+        timer->latency_total += late;
+        if (late > timer->latency_max) {
+            timer->latency_max = late;
+        }
+        if (late >= g_latency_slow_tsc) {
+            timer->latency_slow++;
+        }
+    }
+    timer->programmed = 0;
+    if (timer->slice_end != 0 && timer->slice_end <= now) {
+        timer->slice_end = 0;
+        cpu_current()->need_resched = 1;
+    }
+    while (timer->head != NULL && timer->head->deadline <= now) {
+        timer_event_t *event = timer->head;
+        timer->head = event->next;
+        event->armed = 0;
+        event->next = NULL;
+        spinlock_release(&timer->lock);
+        event->callback(event);
+        spinlock_acquire(&timer->lock);
+    }
+    timer_program(timer);
+    spinlock_release(&timer->lock);
+}
+
+void timer_init(void) {
+    for (uint32_t i = 0; i < CPU_MAX; ++i) {
+        g_timer_cpus[i].lock.locked = 0;
+        g_timer_cpus[i].head = NULL;
+        g_timer_cpus[i].slice_end = 0;
+        g_timer_cpus[i].programmed = 0;
+        g_timer_cpus[i].timer_interrupts = 0;
+        g_timer_cpus[i].latency_samples = 0;
+        g_timer_cpus[i].latency_total = 0;
+        g_timer_cpus[i].latency_max = 0;
+        g_timer_cpus[i].latency_slow = 0;
+    }
+    if (!apic_is_ready()) {
+        serial_write_string("[OS] [TIMER] No local APIC, timer disabled\n");
+        return;
+    }
+
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+
+    apic_timer_init_cpu(false);
+    apic_timer_oneshot(0xFFFFFFFFu);
+    uint64_t tsc_start = rdtsc();
+    apic_delay_us(TIMER_CALIBRATE_US);
+    uint64_t tsc_end = rdtsc();
+    uint32_t lapic_elapsed = 0xFFFFFFFFu - apic_timer_current();
+    apic_timer_oneshot(0);
+
+    g_tsc_hz = (tsc_end - tsc_start) * (1000000u / TIMER_CALIBRATE_US);
+    g_lapic_hz = (uint64_t)lapic_elapsed * (1000000u / TIMER_CALIBRATE_US);
+    g_tsc_deadline = (ecx & CPUID_1_ECX_TSC_DEADLINE) != 0;
+    g_latency_slow_tsc = timer_ns_to_tsc(TIMER_LATENCY_SLOW_NS);
+
+    register_interrupt_handler(APIC_VECTOR_TIMER, timer_irq);
+    timer_init_cpu();
+
+    serial_write_string("[OS] [TIMER] TSC Hz: ");
+    serial_write_uint64(g_tsc_hz);
+    serial_write_string(", LAPIC Hz: ");
+    serial_write_uint64(g_lapic_hz);
+    serial_write_string(g_tsc_deadline ? ", TSC-deadline mode\n" : ", one-shot mode\n");
+}
+
+void timer_init_cpu(void) {
+    if (!timer_is_ready()) {
+        return;
+    }
+    apic_timer_init_cpu(g_tsc_deadline);
+    timer_cpu_t *timer = &g_timer_cpus[cpu_current()->index];
+    uint64_t flags = spinlock_acquire_irqsave(&timer->lock);
+    timer->programmed = 0;
+    timer_program(timer);
+    spinlock_release_irqrestore(&timer->lock, flags);
+}
+
+bool timer_is_ready(void) {
+    return g_tsc_hz != 0 && g_lapic_hz != 0;
+}
+
+uint64_t timer_tsc_to_ns(uint64_t tsc) {
+    if (g_tsc_hz == 0) {
+        return 0;
+    }
+    return (tsc / g_tsc_hz) * TIMER_NS_PER_SEC + ((tsc % g_tsc_hz) * TIMER_NS_PER_SEC) / g_tsc_hz;
+}
+
+uint64_t timer_now_ns(void) {
+    return timer_tsc_to_ns(rdtsc());
+}
+
+uint64_t timer_ns_to_tsc(uint64_t ns) {
+    return (ns / TIMER_NS_PER_SEC) * g_tsc_hz + ((ns % TIMER_NS_PER_SEC) * g_tsc_hz) / TIMER_NS_PER_SEC;
+}
+
+void timer_event_add(timer_event_t *event, uint64_t deadline_tsc) {
+    timer_cpu_t *timer = &g_timer_cpus[cpu_current()->index];
+    uint64_t flags = spinlock_acquire_irqsave(&timer->lock);
+    event->deadline = deadline_tsc;
+    event->cpu = (uint8_t)cpu_current()->index;
+    event->armed = 1;
+
+    timer_event_t **link = &timer->head;
+    while (*link != NULL && (*link)->deadline <= deadline_tsc) {
+        link = &(*link)->next;
+    }
+    event->next = *link;
+    *link = event;
+    timer_program(timer);
+    spinlock_release_irqrestore(&timer->lock, flags);
+}
+
+bool timer_event_cancel(timer_event_t *event) {
+    timer_cpu_t *timer = &g_timer_cpus[event->cpu];
+    bool removed = false;
+    uint64_t flags = spinlock_acquire_irqsave(&timer->lock);
+    if (event->armed) {
+        timer_event_t **link = &timer->head;
+        while (*link != NULL && *link != event) {
+            link = &(*link)->next;
+        }
+        if (*link == event) {
+            *link = event->next;
+            removed = true;
+        }
+        event->armed = 0;
+        event->next = NULL;
+    }
+    spinlock_release_irqrestore(&timer->lock, flags);
+    return removed;
+}
+
+void timer_set_slice_end(uint64_t deadline_tsc) {
+    if (!timer_is_ready()) {
+        return;
+    }
+    timer_cpu_t *timer = &g_timer_cpus[cpu_current()->index];
+    uint64_t flags = spinlock_acquire_irqsave(&timer->lock);
+    timer->slice_end = deadline_tsc;
+    timer_program(timer);
+    spinlock_release_irqrestore(&timer->lock, flags);
+}
+
+void timer_get_stats(timer_stats_t *out) {
+    out->now_ns = timer_now_ns();
+    out->interrupts = 0;
+    out->timer_interrupts = 0;
+    out->idle_wakeups = 0;
+    out->irq_latency_samples = 0;
+    out->irq_latency_slow = 0;
+    uint64_t latency_total = 0;
+    uint64_t latency_max = 0;
+    for (uint32_t i = 0; i < cpu_count(); ++i) {
+        cpu_local_t *cpu = cpu_get(i);
+        timer_cpu_t *timer = &g_timer_cpus[i];
+        out->interrupts += cpu->interrupts;
+        out->idle_wakeups += cpu->idle_wakeups;
+        out->timer_interrupts += timer->timer_interrupts;
+        out->irq_latency_samples += timer->latency_samples;
+        out->irq_latency_slow += timer->latency_slow;
+        latency_total += timer->latency_total;
+        if (timer->latency_max > latency_max) {
+            latency_max = timer->latency_max;
+        }
+    }
+    out->irq_latency_total_ns = timer_tsc_to_ns(latency_total);
+    out->irq_latency_max_ns = timer_tsc_to_ns(latency_max);
+}
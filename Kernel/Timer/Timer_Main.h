@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct timer_event {
+    uint64_t deadline;
+    uint64_t cookie;
+    void (*callback)(struct timer_event *event);
+    struct timer_event *next;
+    uint8_t armed;
+    uint8_t cpu;
+} timer_event_t;
+
+typedef struct {
+    uint64_t now_ns;
+    uint64_t interrupts;
+    uint64_t timer_interrupts;
+    uint64_t idle_wakeups;
+    uint64_t irq_latency_samples;
+    uint64_t irq_latency_total_ns;
+    uint64_t irq_latency_max_ns;
+    uint64_t irq_latency_slow;
+} timer_stats_t;
+
+void timer_init(void);
+void timer_init_cpu(void);
+bool timer_is_ready(void);
+uint64_t timer_now_ns(void);
+uint64_t timer_ns_to_tsc(uint64_t ns);
+uint64_t timer_tsc_to_ns(uint64_t tsc);
+void timer_event_add(timer_event_t *event, uint64_t deadline_tsc);
+bool timer_event_cancel(timer_event_t *event);
+void timer_set_slice_end(uint64_t deadline_tsc);
+void timer_get_stats(timer_stats_t *out);
@@ -0,0 +1,15 @@
+// Every tracepoint in the kernel. Phase is how the decoder shows it:
+// 'B'/'E' open and close a slice, 'I' is an instant, 'S' is a context
+// switch. Append new events at the end so recorded ids stay stable.
+//
+//          id               name              phase  arg0 / arg1 / arg2
+TRACE_EVENT(SCHED_SWITCH,    "sched_switch",   'S')   // prev tid / next tid / prev state
+TRACE_EVENT(SCHED_WAKEUP,    "sched_wakeup",   'I')   // tid / target cpu / -
+TRACE_EVENT(SYSCALL_ENTER,   "syscall",        'B')   // number / arg1 / arg2
+TRACE_EVENT(SYSCALL_EXIT,    "syscall",        'E')   // number / result / -
+TRACE_EVENT(KMALLOC,         "kmalloc",        'I')   // size / pointer / -
+TRACE_EVENT(KFREE,           "kfree",          'I')   // - / pointer / -
+TRACE_EVENT(DISK_BEGIN,      "disk_io",        'B')   // write / lba / sectors
+TRACE_EVENT(DISK_END,        "disk_io",        'E')   // write / lba / ok
+TRACE_EVENT(VIRTIO_SUBMIT,   "virtio_cmd",     'B')   // queue / command / length
+TRACE_EVENT(VIRTIO_COMPLETE, "virtio_cmd",     'E')   // queue / ok / -
@@ -0,0 +1,217 @@
+#include "Trace_Main.h"
+#include "../CPU/CPU_Main.h"
+#include "../Memory/Memory_Main.h"
+#include "../ProcessManager/ProcessManager.h"
+#include "../Syscall/Syscall_File.h"
+#include "../Timer/Timer_Main.h"
+#include "../Sync/Sync_Main.h"
+#include "../Serial.h"
+#include <stddef.h>
+
+#define TRACE_RECORDS_PER_CPU 4096
+#define TRACE_FILE_NAME "TRACE.BIN"
+#define TRACE_VERSION 2
+#define TRACE_HEX_BYTES 32
+
+// Dump layout, read by Tools/trace2json.py: header, one descriptor per
+// event id, then the records of each CPU oldest first.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t event_count;
+    uint64_t tsc_hz;
+    uint32_t record_size;
+    uint32_t record_count;
+} trace_file_header_t;
+
+typedef struct {
+    uint16_t id;
+    char phase;
+    char reserved;
+    char name[28];
+} trace_event_desc_t;
+
+#ifdef KERNEL_TRACE
+volatile uint32_t g_trace_enabled = 0;
+
+typedef struct {
+    uint64_t head;
+    trace_record_t records[TRACE_RECORDS_PER_CPU];
+} trace_buffer_t;
+
+static trace_buffer_t g_trace_buffers[CPU_MAX];
+static volatile uint32_t g_trace_dumping;
+
+static const trace_event_desc_t g_trace_events[TRACE_EVENT_COUNT] = {
+#define TRACE_EVENT(id, name, phase) [TRACE_##id] = { TRACE_##id, phase, 0, name },
+#include "Trace_Events.h"
+#undef TRACE_EVENT
+};
+
+// Each CPU only writes its own buffer, so masking interrupts is all the
+// exclusion needed. Old records are overwritten once the buffer wraps.
+void trace_record(trace_event_t event, uint32_t arg0, uint64_t arg1, uint64_t arg2) {
+    uint64_t flags = irq_save_disable();
+    cpu_local_t *cpu = cpu_current();
+    trace_buffer_t *buffer = &g_trace_buffers[cpu->index];
+    trace_record_t *record = &buffer->records[buffer->head % TRACE_RECORDS_PER_CPU];
+    record->tsc = rdtsc();
+    record->event = (uint16_t)event;
+    record->cpu = (uint16_t)cpu->index;
+    record->arg0 = arg0;
+    record->tid = (uint32_t)process_current_tid();
+    record->reserved = 0;
+    record->arg1 = arg1;
+    record->arg2 = arg2;
+    buffer->head++;
+    irq_restore(flags);
+}
+
+static uint32_t trace_cpu_records(uint32_t cpu) {
+    uint64_t head = g_trace_buffers[cpu].head;
+    return head < TRACE_RECORDS_PER_CPU ? (uint32_t)head : TRACE_RECORDS_PER_CPU;
+}
+
+static void trace_copy_bytes(uint8_t *dst, const void *src, uint64_t len) {
+    const uint8_t *s = (const uint8_t *)src;
+    for (uint64_t i = 0; i < len; ++i) {
+        dst[i] = s[i];
+    }
+}
+
+static uint64_t trace_build_image(uint8_t *out, uint32_t record_count) {
+    trace_file_header_t header = {
+        .magic = { 'K', 'T', 'R', 'A', 'C', 'E', '0', '1' },
+        .version = TRACE_VERSION,
+        .event_count = TRACE_EVENT_COUNT,
+        .tsc_hz = timer_ns_to_tsc(1000000000ULL),
+        .record_size = sizeof(trace_record_t),
+        .record_count = record_count,
+    };
+    uint64_t pos = 0;
+    trace_copy_bytes(out + pos, &header, sizeof(header));
+    pos += sizeof(header);
+    trace_copy_bytes(out + pos, g_trace_events, sizeof(g_trace_events));
+    pos += sizeof(g_trace_events);
+
+    for (uint32_t cpu = 0; cpu < CPU_MAX; ++cpu) {
+        trace_buffer_t *buffer = &g_trace_buffers[cpu];
+        uint32_t count = trace_cpu_records(cpu);
+        for (uint64_t i = buffer->head - count; i < buffer->head; ++i) {
+            trace_copy_bytes(out + pos, &buffer->records[i % TRACE_RECORDS_PER_CPU], sizeof(trace_record_t));
+            pos += sizeof(trace_record_t);
+        }
+    }
+    return pos;
+}
+
+// Hex lines prefixed with [TRACE]; flushed one line at a time so the
+// serial ring never has to drop any of them.
+static void trace_dump_serial(const uint8_t *image, uint64_t size) {
+    static const char hex[] = "0123456789abcdef";
+    char line[8 + TRACE_HEX_BYTES * 2 + 2];
+    for (uint64_t pos = 0; pos < size; pos += TRACE_HEX_BYTES) {
+        uint32_t n = size - pos < TRACE_HEX_BYTES ? (uint32_t)(size - pos) : TRACE_HEX_BYTES;
+        uint32_t len = 0;
+        const char *prefix = "[TRACE] ";
+        while (*prefix != '\0') {
+            line[len++] = *prefix++;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            line[len++] = hex[image[pos + i] >> 4];
+            line[len++] = hex[image[pos + i] & 0xF];
+        }
+        line[len++] = '\n';
+        line[len] = '\0';
+        serial_write_string(line);
+        serial_flush();
+    }
+}
+
+// Writes every buffered record to TRACE.BIN when the volume has one large
+// enough, otherwise to the serial port. KERNEL_TRACE_SERIAL always uses the
+// serial port. Tracing is paused meanwhile.
+static int64_t trace_dump(void) {
+    uint32_t record_count = 0;
+    for (uint32_t cpu = 0; cpu < CPU_MAX; ++cpu) {
+        record_count += trace_cpu_records(cpu);
+    }
+    uint64_t size = sizeof(trace_file_header_t) + sizeof(g_trace_events) +
+                    (uint64_t)record_count * sizeof(trace_record_t);
+#ifdef KERNEL_TRACE_SERIAL
+    int64_t file_size = -1;
+#else
+    int64_t file_size = syscall_file_size(TRACE_FILE_NAME);
+#endif
+    uint64_t capacity = file_size > 0 && (uint64_t)file_size > size ? (uint64_t)file_size : size;
+    uint32_t pages = (uint32_t)((capacity + 4095) / 4096);
+    uint8_t *image = (uint8_t *)alloc_pages(pages);
+    if (image == NULL) {
+        return -1;
+    }
+    trace_build_image(image, record_count);
+
+    if (file_size >= 0 && syscall_file_replace(TRACE_FILE_NAME, image, size, capacity)) {
+        serial_write_string("[OS] [TRACE] Dumped to TRACE.BIN, records: ");
+    } else {
+        trace_dump_serial(image, size);
+        serial_write_string("[OS] [TRACE] Dumped to serial, records: ");
+    }
+    serial_write_uint32(record_count);
+    serial_write_string("\n");
+    free_pages(image, pages);
+    return record_count;
+}
+
+void trace_init(void) {
+    for (uint32_t cpu = 0; cpu < CPU_MAX; ++cpu) {
+        g_trace_buffers[cpu].head = 0;
+    }
+    g_trace_enabled = 1;
+    serial_write_string("[OS] [TRACE] Recording, records per CPU: ");
+    serial_write_uint32(TRACE_RECORDS_PER_CPU);
+    serial_write_string("\n");
+}
+
+int64_t trace_control(uint32_t op) {
+    switch (op) {
+    case TRACE_CTL_STOP:
+        g_trace_enabled = 0;
+        return 0;
+    case TRACE_CTL_START:
+        g_trace_enabled = 1;
+        return 0;
+    case TRACE_CTL_CLEAR: {
+        uint32_t was = g_trace_enabled;
+        g_trace_enabled = 0;
+        for (uint32_t cpu = 0; cpu < CPU_MAX; ++cpu) {
+            g_trace_buffers[cpu].head = 0;
+        }
+        g_trace_enabled = was;
+        return 0;
+    }
+    case TRACE_CTL_DUMP: {
+        // Not a spinlock: the dump sleeps on the file lock and the disk.
+        if (__atomic_exchange_n(&g_trace_dumping, 1, __ATOMIC_ACQUIRE)) {
+            return -1;
+        }
+        uint32_t was = g_trace_enabled;
+        g_trace_enabled = 0;
+        int64_t records = trace_dump();
+        g_trace_enabled = was;
+        __atomic_store_n(&g_trace_dumping, 0, __ATOMIC_RELEASE);
+        return records;
+    }
+    default:
+        return -1;
+    }
+}
+#else
+void trace_init(void) {
+}
+
+int64_t trace_control(uint32_t op) {
+    (void)op;
+    return -1;
+}
+#endif
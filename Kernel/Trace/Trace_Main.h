@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TRACE_CTL_STOP  0
+#define TRACE_CTL_START 1
+#define TRACE_CTL_CLEAR 2
+#define TRACE_CTL_DUMP  3
+
+typedef enum {
+#define TRACE_EVENT(id, name, phase) TRACE_##id,
+#include "Trace_Events.h"
+#undef TRACE_EVENT
+    TRACE_EVENT_COUNT
+} trace_event_t;
+
+// tid is the task running when the record was taken, UINT32_MAX when idle.
+typedef struct {
+    uint64_t tsc;
+    uint16_t event;
+    uint16_t cpu;
+    uint32_t arg0;
+    uint32_t tid;
+    uint32_t reserved;
+    uint64_t arg1;
+    uint64_t arg2;
+} trace_record_t;
+
+// Built with KERNEL_TRACE=1 only; otherwise tracepoints compile away and
+// their arguments are never evaluated.
+#ifdef KERNEL_TRACE
+extern volatile uint32_t g_trace_enabled;
+
+void trace_record(trace_event_t event, uint32_t arg0, uint64_t arg1, uint64_t arg2);
+
+#define TRACE(event, a0, a1, a2)                                                    \
+    do {                                                                            \
+        if (g_trace_enabled) {                                                      \
+            trace_record(TRACE_##event, (uint32_t)(a0), (uint64_t)(a1), (uint64_t)(a2)); \
+        }                                                                           \
+    } while (0)
+#else
+#define TRACE(event, a0, a1, a2)                                                    \
+    do {                                                                            \
+        if (0) {                                                                    \
+            (void)(a0);                                                             \
+            (void)(a1);                                                             \
+            (void)(a2);                                                             \
+        }                                                                           \
+    } while (0)
+#endif
+
+void trace_init(void);
+int64_t trace_control(uint32_t op);
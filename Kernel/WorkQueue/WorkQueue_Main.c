@@ -0,0 +1,179 @@
+#include "WorkQueue_Main.h"
+#include "../CPU/CPU_Main.h"
+#include "../ProcessManager/ProcessManager.h"
+#include "../Sync/Sync_Main.h"
+#include "../Serial.h"
+#include <stddef.h>
+
+#define WORKQUEUE_WORKERS 2
+
+static spinlock_t g_work_lock = SPINLOCK_INIT;
+static work_item_t *g_work_head = NULL;
+static work_item_t *g_work_tail = NULL;
+static uint64_t g_work_next_seq = 1;
+static uint64_t g_worker_running[WORKQUEUE_WORKERS];
+static wait_queue_t g_work_idle;
+static wait_queue_t g_work_flushers;
+static volatile uint32_t g_workqueue_ready = 0;
+
+// An item queued again while it runs is not linked; the worker running it
+// runs it once more afterwards, so one item never runs on two workers.
+static void workqueue_push(work_item_t *work) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_work_lock);
+    work->seq = g_work_next_seq++;
+    if (work->running) {
+        work->rerun = 1;
+        spinlock_release_irqrestore(&g_work_lock, flags);
+        return;
+    }
+    work->next = NULL;
+    if (g_work_tail != NULL) {
+        g_work_tail->next = work;
+    } else {
+        g_work_head = work;
+    }
+    g_work_tail = work;
+    spinlock_release_irqrestore(&g_work_lock, flags);
+    wait_queue_wake(&g_work_idle, 1, 0);
+}
+
+// Clearing pending first lets the function queue itself again; the rerun
+// is deferred until this run returns.
+static void work_run(work_item_t *work) {
+    __atomic_store_n(&work->pending, 0, __ATOMIC_RELEASE);
+    work->func(work);
+}
+
+static int work_claim(work_item_t *work) {
+    return __atomic_exchange_n(&work->pending, 1, __ATOMIC_ACQ_REL) == 0;
+}
+
+// Smallest sequence number still queued or running, UINT64_MAX if idle.
+static uint64_t workqueue_oldest_locked(void) {
+    uint64_t oldest = g_work_head != NULL ? g_work_head->seq : UINT64_MAX;
+    for (uint32_t i = 0; i < WORKQUEUE_WORKERS; ++i) {
+        if (g_worker_running[i] != 0 && g_worker_running[i] < oldest) {
+            oldest = g_worker_running[i];
+        }
+    }
+    return oldest;
+}
+
+static void workqueue_worker(uint64_t index) {
+    uint64_t flags = spinlock_acquire_irqsave(&g_work_lock);
+    while (1) {
+        work_item_t *work = g_work_head;
+        if (work == NULL) {
+            process_sleep_locked(&g_work_idle, &g_work_lock);
+            continue;
+        }
+        g_work_head = work->next;
+        if (g_work_head == NULL) {
+            g_work_tail = NULL;
+        }
+        g_worker_running[index] = work->seq;
+        work->running = 1;
+        spinlock_release_irqrestore(&g_work_lock, flags);
+
+        while (1) {
+            work_run(work);
+            process_preempt_point();
+
+            flags = spinlock_acquire_irqsave(&g_work_lock);
+            if (!work->rerun) {
+                break;
+            }
+            work->rerun = 0;
+            g_worker_running[index] = work->seq;
+            spinlock_release_irqrestore(&g_work_lock, flags);
+        }
+        work->running = 0;
+        g_worker_running[index] = 0;
+        if (g_work_flushers.head != NULL) {
+            spinlock_release_irqrestore(&g_work_lock, flags);
+            wait_queue_wake(&g_work_flushers, UINT32_MAX, 0);
+            flags = spinlock_acquire_irqsave(&g_work_lock);
+        }
+    }
+}
+
+static void workqueue_delay_expired(timer_event_t *event) {
+    work_item_t *work = (work_item_t *)((uint8_t *)event - offsetof(work_item_t, timer));
+    workqueue_push(work);
+}
+
+void workqueue_init(void) {
+    wait_queue_init(&g_work_idle);
+    wait_queue_init(&g_work_flushers);
+
+    uint32_t started = 0;
+    for (uint32_t i = 0; i < WORKQUEUE_WORKERS; ++i) {
+        g_worker_running[i] = 0;
+        if (kernel_thread_create(workqueue_worker, i) >= 0) {
+            started++;
+        }
+    }
+    if (started == 0) {
+        serial_write_string("[OS] [WORK] No workers, running work inline\n");
+        return;
+    }
+    g_workqueue_ready = 1;
+    serial_write_string("[OS] [WORK] Workers started: ");
+    serial_write_uint32(started);
+    serial_write_string("\n");
+}
+
+void work_init(work_item_t *work, void (*func)(work_item_t *work)) {
+    work->func = func;
+    work->next = NULL;
+    work->seq = 0;
+    work->pending = 0;
+    work->running = 0;
+    work->rerun = 0;
+    work->timer.armed = 0;
+    work->timer.next = NULL;
+}
+
+// Returns false if the item is already queued or waiting on its delay.
+// Until the workers exist the function simply runs in the caller.
+bool workqueue_queue(work_item_t *work) {
+    if (!work_claim(work)) {
+        return false;
+    }
+    if (!g_workqueue_ready) {
+        work_run(work);
+        return true;
+    }
+    workqueue_push(work);
+    return true;
+}
+
+bool workqueue_queue_delayed(work_item_t *work, uint64_t delay_ns) {
+    if (delay_ns == 0 || !timer_is_ready()) {
+        return workqueue_queue(work);
+    }
+    if (!work_claim(work)) {
+        return false;
+    }
+    if (!g_workqueue_ready) {
+        work_run(work);
+        return true;
+    }
+    work->timer.callback = workqueue_delay_expired;
+    timer_event_add(&work->timer, rdtsc() + timer_ns_to_tsc(delay_ns));
+    return true;
+}
+
+// Waits for everything queued before the call; delayed items whose timer
+// has not fired yet are not included. Must not be called from work.
+void workqueue_flush(void) {
+    if (!g_workqueue_ready) {
+        return;
+    }
+    uint64_t flags = spinlock_acquire_irqsave(&g_work_lock);
+    uint64_t target = g_work_next_seq - 1;
+    while (workqueue_oldest_locked() <= target) {
+        process_sleep_locked(&g_work_flushers, &g_work_lock);
+    }
+    spinlock_release_irqrestore(&g_work_lock, flags);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../Timer/Timer_Main.h"
+
+typedef struct work_item {
+    void (*func)(struct work_item *work);
+    struct work_item *next;
+    uint64_t seq;
+    volatile uint32_t pending;
+    uint8_t running;
+    uint8_t rerun;
+    timer_event_t timer;
+} work_item_t;
+
+void workqueue_init(void);
+void work_init(work_item_t *work, void (*func)(work_item_t *work));
+bool workqueue_queue(work_item_t *work);
+bool workqueue_queue_delayed(work_item_t *work, uint64_t delay_ns);
+void workqueue_flush(void);
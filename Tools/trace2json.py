@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Convert a kernel trace dump into Chrome/Perfetto JSON.
+
+The kernel (built with `make KERNEL_TRACE=1`) writes its trace to
+TRACE.BIN on the boot volume. With `make KERNEL_TRACE_SERIAL=1`, or when
+that file is missing or too small, it prints "[TRACE] <hex>" lines on the
+serial port instead. Both are accepted:
+
+    make bench KERNEL_TRACE=1
+    mcopy -i Image/Bench/disk.iso@@1M ::TRACE.BIN trace.bin
+    Tools/trace2json.py trace.bin -o trace.json
+
+    make bench KERNEL_TRACE_SERIAL=1 | tee serial.log
+    Tools/trace2json.py serial.log -o trace.json
+
+Open the result in https://ui.perfetto.dev or chrome://tracing.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = b"KTRACE01"
+HEADER = struct.Struct("<8sIIQII")
+DESC = struct.Struct("<Hcc28s")
+RECORD = struct.Struct("<QHHIIIQQ")
+IDLE_TID = 0xFFFFFFFF
+
+
+def load_image(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data.startswith(MAGIC):
+        return data
+    # Not a binary dump, so treat it as a serial log.
+    out = bytearray()
+    for line in data.decode("utf-8", "replace").splitlines():
+        pos = line.find("[TRACE] ")
+        if pos < 0:
+            continue
+        payload = line[pos + 8:].strip()
+        try:
+            out += bytes.fromhex(payload)
+        except ValueError:
+            continue
+    if not out.startswith(MAGIC):
+        sys.exit(f"{path}: no trace found")
+    return bytes(out)
+
+
+def parse(data):
+    magic, version, event_count, tsc_hz, record_size, record_count = HEADER.unpack_from(data, 0)
+    if version != 2 or record_size != RECORD.size:
+        sys.exit(f"unsupported trace version {version}, record size {record_size}")
+    pos = HEADER.size
+    events = {}
+    for _ in range(event_count):
+        event_id, phase, _, name = DESC.unpack_from(data, pos)
+        events[event_id] = (name.split(b"\0", 1)[0].decode(), phase.decode())
+        pos += DESC.size
+    records = []
+    for _ in range(record_count):
+        if pos + RECORD.size > len(data):
+            break
+        records.append(RECORD.unpack_from(data, pos))
+        pos += RECORD.size
+    records.sort(key=lambda r: r[0])
+    return tsc_hz, events, records
+
+
+def tid_name(tid):
+    return "idle" if tid == IDLE_TID else f"tid {tid}"
+
+
+def convert(tsc_hz, events, records):
+    if not records:
+        return []
+    base = records[0][0]
+    scale = 1e6 / tsc_hz if tsc_hz else 1.0
+
+    def ts(tsc):
+        return (tsc - base) * scale
+
+    out = []
+    cpus = sorted({r[2] for r in records})
+    for cpu in cpus:
+        out.append({"ph": "M", "name": "thread_name", "pid": 0, "tid": cpu,
+                    "args": {"name": f"cpu {cpu}"}})
+        out.append({"ph": "M", "name": "thread_name", "pid": 1, "tid": cpu,
+                    "args": {"name": f"cpu {cpu} tasks"}})
+    for tid in sorted({r[4] for r in records if r[4] != IDLE_TID}):
+        out.append({"ph": "M", "name": "thread_name", "pid": 2, "tid": tid,
+                    "args": {"name": tid_name(tid)}})
+    out.append({"ph": "M", "name": "process_name", "pid": 0, "args": {"name": "kernel"}})
+    out.append({"ph": "M", "name": "process_name", "pid": 1, "args": {"name": "scheduler"}})
+    out.append({"ph": "M", "name": "process_name", "pid": 2, "args": {"name": "tasks"}})
+
+    running = {}
+    for tsc, event_id, cpu, arg0, tid, _, arg1, arg2 in records:
+        name, phase = events.get(event_id, (f"event {event_id}", "I"))
+        args = {"arg0": arg0, "arg1": arg1, "arg2": arg2, "cpu": cpu}
+        if phase == "S":
+            # arg0 is the previous task, arg1 the next one.
+            if cpu in running:
+                start, prev = running.pop(cpu)
+                out.append({"ph": "X", "name": tid_name(prev), "pid": 1, "tid": cpu,
+                            "ts": ts(start), "dur": ts(tsc) - ts(start),
+                            "args": {"end_state": arg2}})
+            running[cpu] = (tsc, arg1)
+            continue
+        if name == "syscall":
+            name = f"syscall {arg0}"
+        # Slices follow the task: one that blocks can end on another CPU,
+        # and other tasks' slices run on this CPU in between.
+        if phase in ("B", "E") and tid != IDLE_TID:
+            track = {"pid": 2, "tid": tid}
+        else:
+            track = {"pid": 0, "tid": cpu}
+        ev = {"ph": "i" if phase == "I" else phase, "name": name, **track,
+              "ts": ts(tsc), "args": args}
+        if phase == "I":
+            ev["s"] = "t"
+        out.append(ev)
+
+    end = records[-1][0]
+    for cpu, (start, tid) in running.items():
+        out.append({"ph": "X", "name": tid_name(tid), "pid": 1, "tid": cpu,
+                    "ts": ts(start), "dur": ts(end) - ts(start), "args": {}})
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="TRACE.BIN or a serial log with [TRACE] lines")
+    parser.add_argument("-o", "--output", help="output file, stdout by default")
+    opts = parser.parse_args()
+
+    tsc_hz, events, records = parse(load_image(opts.input))
+    trace = {"traceEvents": convert(tsc_hz, events, records), "displayTimeUnit": "ns"}
+    if opts.output:
+        with open(opts.output, "w") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+    print(f"{len(records)} records, tsc {tsc_hz} Hz", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,39 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdint.h>
+#include "../../Syscalls.h"
+
+// Same bucket layout as the kernel's dispatch profile, so both print alike.
+typedef syscall_profile_t bench_hist_t;
+
+void benchmark_run_all(void);
+
+uint64_t bench_rdtsc(void);
+void bench_print_u64(uint64_t value);
+void bench_print_result(const char *label, uint64_t value, const char *unit);
+
+void bench_hist_reset(bench_hist_t *hist);
+void bench_hist_add(bench_hist_t *hist, uint64_t cycles);
+uint64_t bench_hist_percentile(const bench_hist_t *hist, uint32_t per_mille);
+void bench_hist_print(const char *label, const bench_hist_t *hist);
+
+void benchmark_scheduler(void);
+void benchmark_parallel(void);
+void benchmark_balance(void);
+void benchmark_idle(void);
+void benchmark_futex(void);
+void benchmark_fpu(void);
+void benchmark_simd(void);
+void benchmark_latency(void);
+void benchmark_syscall(void);
+void benchmark_jitter(void);
+void benchmark_affinity(void);
+void benchmark_ring(void);
+void benchmark_heap(void);
+void benchmark_file(void);
+void benchmark_pipe(void);
+void benchmark_channel(void);
+void benchmark_poll(void);
+
+#endif
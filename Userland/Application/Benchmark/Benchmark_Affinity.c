@@ -0,0 +1,138 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_AFFINITY_MAX_CPUS 16
+#define BENCH_AFFINITY_ROUNDS 256
+#define BENCH_AFFINITY_BYTES (64 * 1024)
+#define BENCH_AFFINITY_ANY UINT32_MAX
+
+typedef struct {
+    uint32_t cpu;
+    uint32_t producer;
+} affinity_arg_t;
+
+static cpu_topology_t g_affinity_topology[BENCH_AFFINITY_MAX_CPUS];
+static uint64_t g_affinity_buffer[BENCH_AFFINITY_BYTES / sizeof(uint64_t)];
+static volatile uint32_t g_affinity_turn;
+static volatile uint64_t g_affinity_sink;
+static bench_hist_t g_affinity_hist;
+
+static void affinity_wait_turn(uint32_t turn) {
+    while (__atomic_load_n(&g_affinity_turn, __ATOMIC_ACQUIRE) != turn) {
+        process_yield();
+    }
+}
+
+// The producer rewrites the whole buffer each round and the consumer reads
+// it back, so each hand-off moves BENCH_AFFINITY_BYTES between the caches.
+static int32_t affinity_worker(void *arg) {
+    affinity_arg_t *config = (affinity_arg_t *)arg;
+    if (config->cpu != BENCH_AFFINITY_ANY && process_set_affinity(-1, 1ULL << config->cpu) < 0) {
+        return -1;
+    }
+    uint64_t words = BENCH_AFFINITY_BYTES / sizeof(uint64_t);
+    uint64_t sum = 0;
+    for (uint32_t round = 0; round < BENCH_AFFINITY_ROUNDS; ++round) {
+        if (config->producer) {
+            affinity_wait_turn(0);
+            uint64_t start = bench_rdtsc();
+            for (uint64_t i = 0; i < words; ++i) {
+                g_affinity_buffer[i] = i + round;
+            }
+            __atomic_store_n(&g_affinity_turn, 1, __ATOMIC_RELEASE);
+            affinity_wait_turn(0);
+            bench_hist_add(&g_affinity_hist, bench_rdtsc() - start);
+        } else {
+            affinity_wait_turn(1);
+            for (uint64_t i = 0; i < words; ++i) {
+                sum += g_affinity_buffer[i];
+            }
+            __atomic_store_n(&g_affinity_turn, 0, __ATOMIC_RELEASE);
+        }
+    }
+    g_affinity_sink += sum;
+    return 0;
+}
+
+static void affinity_run_pair(const char *label, uint32_t producer_cpu, uint32_t consumer_cpu) {
+    affinity_arg_t producer = {producer_cpu, 1};
+    affinity_arg_t consumer = {consumer_cpu, 0};
+    int32_t producer_rc = -1;
+    int32_t consumer_rc = -1;
+
+    g_affinity_turn = 0;
+    bench_hist_reset(&g_affinity_hist);
+    int32_t consumer_tid = thread_create(affinity_worker, &consumer);
+    int32_t producer_tid = thread_create(affinity_worker, &producer);
+    if (producer_tid >= 0) {
+        thread_join(producer_tid, &producer_rc);
+    }
+    if (consumer_tid >= 0) {
+        thread_join(consumer_tid, &consumer_rc);
+    }
+    if (producer_rc < 0 || consumer_rc < 0) {
+        serial_write_string("[BENCH] affinity ");
+        serial_write_string(label);
+        serial_write_string(" skipped\n");
+        return;
+    }
+    bench_hist_print(label, &g_affinity_hist);
+}
+
+// First pair of online CPUs whose closest shared cache matches `distance`:
+// 0 = same L2, 1 = same LLC only, 2 = nothing shared.
+static int affinity_find_pair(uint32_t count, uint32_t distance, uint32_t *a, uint32_t *b) {
+    for (uint32_t i = 0; i < count; ++i) {
+        for (uint32_t j = i + 1; j < count; ++j) {
+            const cpu_topology_t *x = &g_affinity_topology[i];
+            const cpu_topology_t *y = &g_affinity_topology[j];
+            if (!x->online || !y->online) {
+                continue;
+            }
+            uint32_t d = x->l2_id == y->l2_id ? 0 : (x->llc_id == y->llc_id ? 1 : 2);
+            if (d == distance) {
+                *a = i;
+                *b = j;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+void benchmark_affinity(void) {
+    uint32_t count = 0;
+    while (count < BENCH_AFFINITY_MAX_CPUS && cpu_get_topology(count, &g_affinity_topology[count]) == 0) {
+        count++;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        const cpu_topology_t *cpu = &g_affinity_topology[i];
+        serial_write_string("[BENCH] topology cpu=");
+        bench_print_u64(i);
+        serial_write_string(" core=");
+        bench_print_u64(cpu->core_id);
+        serial_write_string(" package=");
+        bench_print_u64(cpu->package_id);
+        serial_write_string(" l2=");
+        bench_print_u64(cpu->l2_id);
+        serial_write_string(" llc=");
+        bench_print_u64(cpu->llc_id);
+        serial_write_string("\n");
+    }
+
+    static const char *const labels[3] = {
+        "affinity hand-off shared L2",
+        "affinity hand-off shared LLC",
+        "affinity hand-off cross-cache",
+    };
+    affinity_run_pair("affinity hand-off unpinned", BENCH_AFFINITY_ANY, BENCH_AFFINITY_ANY);
+    affinity_run_pair("affinity hand-off same cpu", 0, 0);
+    for (uint32_t distance = 0; distance < 3; ++distance) {
+        uint32_t a;
+        uint32_t b;
+        if (affinity_find_pair(count, distance, &a, &b)) {
+            affinity_run_pair(labels[distance], a, b);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_BALANCE_MAX_CPUS 16
+#define BENCH_BALANCE_TASKS 32
+#define BENCH_BALANCE_CHUNKS 64
+#define BENCH_BALANCE_CHUNK_ITERS 20000
+
+static volatile uint32_t g_balance_chunks[BENCH_BALANCE_MAX_CPUS];
+static volatile uint64_t g_balance_sink;
+
+static int32_t balance_worker(void *arg) {
+    (void)arg;
+    uint64_t x = 0x2545F4914F6CDD1DULL;
+    for (uint32_t chunk = 0; chunk < BENCH_BALANCE_CHUNKS; ++chunk) {
+        for (uint32_t i = 0; i < BENCH_BALANCE_CHUNK_ITERS; ++i) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+        }
+        uint32_t cpu = process_current_cpu();
+        if (cpu < BENCH_BALANCE_MAX_CPUS) {
+            __sync_fetch_and_add(&g_balance_chunks[cpu], 1);
+        }
+        process_yield();
+    }
+    g_balance_sink += x;
+    return 0;
+}
+
+static uint64_t balance_run(uint32_t tasks) {
+    uint32_t created = 0;
+
+    for (uint32_t i = 0; i < BENCH_BALANCE_MAX_CPUS; ++i) {
+        g_balance_chunks[i] = 0;
+    }
+
+    uint64_t start = bench_rdtsc();
+    for (uint32_t i = 0; i < tasks; ++i) {
+        if (thread_create(balance_worker, NULL) < 0) {
+            break;
+        }
+        created++;
+    }
+    while (process_wait(-1, NULL) >= 0) {
+    }
+    uint64_t cycles = bench_rdtsc() - start;
+
+    serial_write_string("[BENCH] balance tasks=");
+    bench_print_u64(created);
+    serial_write_string(" cycles=");
+    bench_print_u64(cycles);
+    serial_write_string(" chunks/cpu:");
+    for (uint32_t i = 0; i < BENCH_BALANCE_MAX_CPUS; ++i) {
+        if (g_balance_chunks[i] == 0) {
+            continue;
+        }
+        serial_write_string(" ");
+        bench_print_u64(i);
+        serial_write_string("=");
+        bench_print_u64(g_balance_chunks[i]);
+    }
+    serial_write_string("\n");
+    return created ? cycles / created : 0;
+}
+
+void benchmark_balance(void) {
+    uint64_t single = balance_run(1);
+    uint64_t skewed = balance_run(BENCH_BALANCE_TASKS);
+    if (skewed != 0) {
+        bench_print_result("balance speedup", (single * 100) / skewed, "x/100");
+    }
+}
@@ -0,0 +1,80 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_CHANNEL_CALLS 5000
+#define BENCH_CHANNEL_PAGES 16
+
+static bench_hist_t g_channel_hist;
+static channel_msg_t g_channel_request;
+static channel_msg_t g_channel_reply;
+
+// Echo server: each reply goes out with the next receive, and any pages
+// that came with the request are handed straight back.
+static int32_t channel_server(void *arg) {
+    int32_t id = (int32_t)(intptr_t)arg;
+    channel_msg_t request;
+    channel_msg_t reply;
+    const channel_msg_t *answer = NULL;
+    while (channel_receive(id, answer, &request) == 0) {
+        reply.tag = request.tag + 1;
+        reply.len = 0;
+        reply.pages = request.pages;
+        reply.page_addr = request.page_addr;
+        answer = &reply;
+    }
+    return 0;
+}
+
+static void channel_run(const char *label, int32_t id, void *pages) {
+    g_channel_request.len = 8;
+    g_channel_request.pages = pages != NULL ? BENCH_CHANNEL_PAGES : 0;
+    g_channel_request.page_addr = (uint64_t)(uintptr_t)pages;
+
+    bench_hist_reset(&g_channel_hist);
+    uint32_t failed = 0;
+    for (uint32_t i = 0; i < BENCH_CHANNEL_CALLS; ++i) {
+        g_channel_request.tag = i;
+        uint64_t start = bench_rdtsc();
+        int32_t rc = channel_call(id, &g_channel_request, &g_channel_reply);
+        uint64_t cycles = bench_rdtsc() - start;
+        if (rc != 0 || g_channel_reply.tag != i + 1) {
+            failed++;
+            continue;
+        }
+        bench_hist_add(&g_channel_hist, cycles);
+    }
+    if (failed != 0) {
+        serial_write_string("[BENCH] channel ");
+        serial_write_string(label);
+        serial_write_string(" failed_calls=");
+        bench_print_u64(failed);
+        serial_write_string("\n");
+    }
+    bench_hist_print(label, &g_channel_hist);
+}
+
+void benchmark_channel(void) {
+    int32_t id = channel_create();
+    if (id < 0) {
+        serial_write_string("[BENCH] channel skipped, create failed\n");
+        return;
+    }
+    int32_t tid = thread_create(channel_server, (void *)(intptr_t)id);
+    if (tid < 0) {
+        channel_destroy(id);
+        serial_write_string("[BENCH] channel skipped, thread_create failed\n");
+        return;
+    }
+
+    // Compare with "yield round-trip" from the syscall benchmark.
+    channel_run("channel call round-trip", id, NULL);
+    void *pages = mem_map(BENCH_CHANNEL_PAGES);
+    if (pages != NULL) {
+        channel_run("channel call 64KiB pages", id, pages);
+        mem_unmap(pages, BENCH_CHANNEL_PAGES);
+    }
+
+    channel_destroy(id);
+    thread_join(tid, NULL);
+}
@@ -0,0 +1,117 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_FILE_NAME "LOGO.PNG"
+#define BENCH_FILE_SEGMENT 64
+#define BENCH_FILE_PASSES 8
+#define BENCH_FILE_READERS 2
+#define BENCH_FILE_CHUNK 4096
+
+static uint8_t g_file_segments[FILE_IOV_MAX][BENCH_FILE_SEGMENT];
+static uint8_t g_file_chunks[BENCH_FILE_READERS][BENCH_FILE_CHUNK];
+static iovec_t g_file_iov[FILE_IOV_MAX];
+static volatile uint64_t g_file_pread_bytes;
+static volatile uint64_t g_file_pread_calls;
+
+static void file_print(const char *label, uint64_t bytes, uint64_t calls, uint64_t cycles) {
+    serial_write_string("[BENCH] file ");
+    serial_write_string(label);
+    serial_write_string(" bytes=");
+    bench_print_u64(bytes);
+    serial_write_string(" syscalls=");
+    bench_print_u64(calls);
+    serial_write_string(" cycles_per_kib=");
+    bench_print_u64(bytes != 0 ? cycles * 1024 / bytes : 0);
+    serial_write_string("\n");
+}
+
+// Same small scattered reads, once as one syscall per segment and once
+// as a readv covering FILE_IOV_MAX segments per entry.
+static void file_bench_scatter(int32_t fd) {
+    uint64_t bytes = 0;
+    uint64_t calls = 0;
+    uint64_t start = bench_rdtsc();
+    for (uint32_t pass = 0; pass < BENCH_FILE_PASSES; ++pass) {
+        uint64_t offset = 0;
+        int64_t n;
+        uint32_t slot = 0;
+        while ((n = file_pread(fd, g_file_segments[slot], BENCH_FILE_SEGMENT, offset)) > 0) {
+            offset += (uint64_t)n;
+            slot = (slot + 1) % FILE_IOV_MAX;
+            calls++;
+        }
+        bytes += offset;
+    }
+    file_print("segment reads", bytes, calls, bench_rdtsc() - start);
+
+    for (uint32_t i = 0; i < FILE_IOV_MAX; ++i) {
+        g_file_iov[i].base = g_file_segments[i];
+        g_file_iov[i].len = BENCH_FILE_SEGMENT;
+    }
+    bytes = 0;
+    calls = 0;
+    start = bench_rdtsc();
+    for (uint32_t pass = 0; pass < BENCH_FILE_PASSES; ++pass) {
+        int32_t pass_fd = file_open(BENCH_FILE_NAME, 0);
+        if (pass_fd < 0) {
+            break;
+        }
+        int64_t n;
+        while ((n = file_readv(pass_fd, g_file_iov, FILE_IOV_MAX)) > 0) {
+            bytes += (uint64_t)n;
+            calls++;
+        }
+        file_close(pass_fd);
+    }
+    file_print("readv", bytes, calls, bench_rdtsc() - start);
+}
+
+static int32_t file_pread_reader(void *arg) {
+    int32_t fd = (int32_t)(intptr_t)arg;
+    uint8_t *buffer = g_file_chunks[thread_self() % BENCH_FILE_READERS];
+    for (uint32_t pass = 0; pass < BENCH_FILE_PASSES; ++pass) {
+        uint64_t offset = 0;
+        int64_t n;
+        uint64_t calls = 0;
+        while ((n = file_pread(fd, buffer, BENCH_FILE_CHUNK, offset)) > 0) {
+            offset += (uint64_t)n;
+            calls++;
+        }
+        __atomic_fetch_add(&g_file_pread_bytes, offset, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&g_file_pread_calls, calls, __ATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+// Readers share one descriptor; with pread none of them moves the fd
+// offset, so each still sees the whole file.
+static void file_bench_shared(int32_t fd) {
+    int32_t tids[BENCH_FILE_READERS];
+    uint32_t started = 0;
+    g_file_pread_bytes = 0;
+    g_file_pread_calls = 0;
+    uint64_t start = bench_rdtsc();
+    for (uint32_t i = 0; i < BENCH_FILE_READERS; ++i) {
+        tids[started] = thread_create(file_pread_reader, (void *)(intptr_t)fd);
+        if (tids[started] >= 0) {
+            started++;
+        }
+    }
+    for (uint32_t i = 0; i < started; ++i) {
+        thread_join(tids[i], NULL);
+    }
+    uint64_t cycles = bench_rdtsc() - start;
+    file_print("shared-fd pread", g_file_pread_bytes, g_file_pread_calls, cycles);
+}
+
+void benchmark_file(void) {
+    int32_t fd = file_open(BENCH_FILE_NAME, 0);
+    if (fd < 0) {
+        serial_write_string("[BENCH] file skipped, " BENCH_FILE_NAME " missing\n");
+        return;
+    }
+    file_bench_scatter(fd);
+    file_bench_shared(fd);
+    file_close(fd);
+}
@@ -0,0 +1,69 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_FPU_WORKERS 8
+#define BENCH_FPU_YIELDS 2000
+
+static volatile uint32_t g_fpu_errors;
+
+static int32_t fpu_integer_worker(void *arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < BENCH_FPU_YIELDS; ++i) {
+        process_yield();
+    }
+    return 0;
+}
+
+static int32_t fpu_vector_worker(void *arg) {
+    uint64_t seed = (uint64_t)(uintptr_t)arg + 1;
+    __asm__ volatile ("movq %0, %%xmm7" :: "r"(seed) : "xmm7");
+    for (uint32_t i = 0; i < BENCH_FPU_YIELDS; ++i) {
+        __asm__ volatile ("paddq %%xmm7, %%xmm6" ::: "xmm6");
+        process_yield();
+        uint64_t check;
+        __asm__ volatile ("movq %%xmm7, %0" : "=r"(check));
+        if (check != seed) {
+            __sync_fetch_and_add(&g_fpu_errors, 1);
+        }
+    }
+    return 0;
+}
+
+static uint64_t fpu_run(const char *label, int32_t (*worker)(void *)) {
+    int32_t tids[BENCH_FPU_WORKERS];
+    uint32_t created = 0;
+
+    g_fpu_errors = 0;
+    uint64_t start = bench_rdtsc();
+    for (uint32_t i = 0; i < BENCH_FPU_WORKERS; ++i) {
+        tids[created] = thread_create(worker, (void *)(uintptr_t)i);
+        if (tids[created] < 0) {
+            break;
+        }
+        created++;
+    }
+    for (uint32_t i = 0; i < created; ++i) {
+        thread_join(tids[i], NULL);
+    }
+    uint64_t cycles = bench_rdtsc() - start;
+    uint64_t switches = (uint64_t)created * BENCH_FPU_YIELDS;
+    uint64_t per_switch = switches ? cycles / switches : 0;
+
+    serial_write_string("[BENCH] fpu ");
+    serial_write_string(label);
+    serial_write_string(" workers=");
+    bench_print_u64(created);
+    serial_write_string(" cycles/switch=");
+    bench_print_u64(per_switch);
+    serial_write_string(" corrupted=");
+    bench_print_u64(g_fpu_errors);
+    serial_write_string("\n");
+    return per_switch;
+}
+
+void benchmark_fpu(void) {
+    uint64_t integer = fpu_run("integer", fpu_integer_worker);
+    uint64_t vector = fpu_run("vector", fpu_vector_worker);
+    bench_print_result("fpu state overhead", vector > integer ? vector - integer : 0, "cycles/switch");
+}
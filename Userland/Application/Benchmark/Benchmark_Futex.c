@@ -0,0 +1,93 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "../../Sync.h"
+#include "Benchmark.h"
+
+#define BENCH_FUTEX_MAX_WORKERS 4
+#define BENCH_FUTEX_ITERATIONS 20000
+#define BENCH_FUTEX_HOLD_ITERS 64
+
+typedef struct {
+    void (*lock)(void);
+    void (*unlock)(void);
+} futex_lock_ops_t;
+
+static const uint32_t g_futex_worker_counts[] = {1, 2, BENCH_FUTEX_MAX_WORKERS};
+
+static mutex_t g_futex_mutex = MUTEX_INIT;
+static volatile uint32_t g_spin_lock = 0;
+static volatile uint64_t g_futex_counter = 0;
+static volatile uint64_t g_futex_sink = 0;
+
+static void futex_mutex_lock(void) {
+    mutex_lock(&g_futex_mutex);
+}
+
+static void futex_mutex_unlock(void) {
+    mutex_unlock(&g_futex_mutex);
+}
+
+static void spin_yield_lock(void) {
+    while (__atomic_exchange_n(&g_spin_lock, 1, __ATOMIC_ACQUIRE) != 0) {
+        process_yield();
+    }
+}
+
+static void spin_yield_unlock(void) {
+    __atomic_store_n(&g_spin_lock, 0, __ATOMIC_RELEASE);
+}
+
+static const futex_lock_ops_t g_futex_ops = {futex_mutex_lock, futex_mutex_unlock};
+static const futex_lock_ops_t g_spin_ops = {spin_yield_lock, spin_yield_unlock};
+
+static int32_t futex_worker(void *arg) {
+    const futex_lock_ops_t *ops = (const futex_lock_ops_t *)arg;
+    for (uint32_t i = 0; i < BENCH_FUTEX_ITERATIONS; ++i) {
+        ops->lock();
+        uint64_t x = g_futex_counter;
+        for (uint32_t j = 0; j < BENCH_FUTEX_HOLD_ITERS; ++j) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+        g_futex_sink = x;
+        g_futex_counter++;
+        ops->unlock();
+    }
+    return 0;
+}
+
+static void futex_run(const char *label, const futex_lock_ops_t *ops, uint32_t workers) {
+    int32_t tids[BENCH_FUTEX_MAX_WORKERS];
+    uint32_t created = 0;
+
+    g_futex_counter = 0;
+    uint64_t start = bench_rdtsc();
+    for (uint32_t i = 0; i < workers; ++i) {
+        tids[created] = thread_create(futex_worker, (void *)ops);
+        if (tids[created] < 0) {
+            break;
+        }
+        created++;
+    }
+    for (uint32_t i = 0; i < created; ++i) {
+        thread_join(tids[i], NULL);
+    }
+    uint64_t cycles = bench_rdtsc() - start;
+    uint64_t ops_done = (uint64_t)created * BENCH_FUTEX_ITERATIONS;
+
+    serial_write_string("[BENCH] ");
+    serial_write_string(label);
+    serial_write_string(" workers=");
+    bench_print_u64(created);
+    serial_write_string(" cycles/op=");
+    bench_print_u64(ops_done ? cycles / ops_done : 0);
+    serial_write_string(" lost=");
+    bench_print_u64(ops_done - g_futex_counter);
+    serial_write_string("\n");
+}
+
+void benchmark_futex(void) {
+    for (uint32_t i = 0; i < sizeof(g_futex_worker_counts) / sizeof(g_futex_worker_counts[0]); ++i) {
+        futex_run("futex-mutex", &g_futex_ops, g_futex_worker_counts[i]);
+        futex_run("spin-yield", &g_spin_ops, g_futex_worker_counts[i]);
+    }
+}
@@ -0,0 +1,114 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "../../Heap.h"
+#include "../PNG_Decoder/PNG_Decoder.h"
+#include "Benchmark.h"
+
+#define BENCH_HEAP_ITERS 20000
+#define BENCH_HEAP_THREADS 4
+#define BENCH_HEAP_THREAD_ITERS 50000
+#define BENCH_HEAP_BATCH 64
+#define BENCH_HEAP_DECODE_ROUNDS 8
+#define BENCH_HEAP_FILE "LOGO.PNG"
+#define BENCH_HEAP_FILE_MAX (1024 * 1024)
+
+static bench_hist_t g_heap_hist;
+
+static void heap_bench_pair(const char *label, uint32_t size) {
+    bench_hist_reset(&g_heap_hist);
+    for (uint32_t i = 0; i < BENCH_HEAP_ITERS; ++i) {
+        uint64_t start = bench_rdtsc();
+        void *ptr = malloc(size);
+        free(ptr);
+        bench_hist_add(&g_heap_hist, bench_rdtsc() - start);
+    }
+    bench_hist_print(label, &g_heap_hist);
+}
+
+static void heap_bench_map(void) {
+    bench_hist_reset(&g_heap_hist);
+    for (uint32_t i = 0; i < BENCH_HEAP_ITERS; ++i) {
+        uint64_t start = bench_rdtsc();
+        void *ptr = mem_map(1);
+        mem_unmap(ptr, 1);
+        bench_hist_add(&g_heap_hist, bench_rdtsc() - start);
+    }
+    bench_hist_print("mem_map+unmap 1 page", &g_heap_hist);
+}
+
+// Each thread keeps a batch live so blocks move between its cache and the
+// shared lists rather than bouncing one block back and forth.
+static int32_t heap_worker(void *arg) {
+    void *live[BENCH_HEAP_BATCH];
+    uint32_t size = 16u << ((uintptr_t)arg % 4);
+    for (uint32_t i = 0; i < BENCH_HEAP_THREAD_ITERS; i += BENCH_HEAP_BATCH) {
+        for (uint32_t j = 0; j < BENCH_HEAP_BATCH; ++j) {
+            live[j] = malloc(size);
+        }
+        for (uint32_t j = 0; j < BENCH_HEAP_BATCH; ++j) {
+            free(live[j]);
+        }
+    }
+    return 0;
+}
+
+static void heap_bench_threads(void) {
+    int32_t tids[BENCH_HEAP_THREADS];
+    uint32_t started = 0;
+    uint64_t start = bench_rdtsc();
+    for (uint32_t i = 0; i < BENCH_HEAP_THREADS; ++i) {
+        tids[started] = thread_create(heap_worker, (void *)(uintptr_t)i);
+        if (tids[started] >= 0) {
+            started++;
+        }
+    }
+    for (uint32_t i = 0; i < started; ++i) {
+        thread_join(tids[i], NULL);
+    }
+    uint64_t cycles = bench_rdtsc() - start;
+    uint64_t pairs = (uint64_t)started * BENCH_HEAP_THREAD_ITERS;
+
+    serial_write_string("[BENCH] heap threads=");
+    bench_print_u64(started);
+    serial_write_string(" cycles/pair=");
+    bench_print_u64(pairs != 0 ? cycles / pairs : 0);
+    serial_write_string("\n");
+}
+
+static void heap_bench_decode(void) {
+    uint8_t *file = malloc(BENCH_HEAP_FILE_MAX);
+    int32_t fd = file_open(BENCH_HEAP_FILE, 0);
+    if (file == NULL || fd < 0) {
+        serial_write_string("[BENCH] png decode skipped, no " BENCH_HEAP_FILE "\n");
+        free(file);
+        return;
+    }
+    uint64_t size = 0;
+    int64_t n;
+    while (size < BENCH_HEAP_FILE_MAX &&
+           (n = file_read(fd, file + size, BENCH_HEAP_FILE_MAX - size)) > 0) {
+        size += (uint64_t)n;
+    }
+    file_close(fd);
+
+    bench_hist_reset(&g_heap_hist);
+    for (uint32_t round = 0; round < BENCH_HEAP_DECODE_ROUNDS; ++round) {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint64_t start = bench_rdtsc();
+        uint32_t *rgba = png_decode_buffer(file, size, &width, &height);
+        bench_hist_add(&g_heap_hist, bench_rdtsc() - start);
+        free(rgba);
+    }
+    free(file);
+    bench_hist_print("png decode " BENCH_HEAP_FILE, &g_heap_hist);
+}
+
+void benchmark_heap(void) {
+    heap_bench_pair("malloc+free 64", 64);
+    heap_bench_pair("malloc+free 2048", 2048);
+    heap_bench_pair("malloc+free 64K", 64 * 1024);
+    heap_bench_map();
+    heap_bench_threads();
+    heap_bench_decode();
+}
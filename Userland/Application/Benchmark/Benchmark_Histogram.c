@@ -0,0 +1,82 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+static uint32_t hist_bucket(uint64_t cycles) {
+    if (cycles < 4) {
+        return (uint32_t)cycles;
+    }
+    uint32_t msb = 63u - (uint32_t)__builtin_clzll(cycles);
+    uint32_t sub = (uint32_t)(cycles >> (msb - 2)) & 3u;
+    uint32_t index = (msb - 1) * 4 + sub;
+    return index < SYSCALL_PROFILE_BUCKETS ? index : SYSCALL_PROFILE_BUCKETS - 1;
+}
+
+static uint64_t hist_bucket_floor(uint32_t index) {
+    if (index < 4) {
+        return index;
+    }
+    uint32_t msb = index / 4 + 1;
+    return (uint64_t)(4 + index % 4) << (msb - 2);
+}
+
+void bench_hist_reset(bench_hist_t *hist) {
+    hist->count = 0;
+    hist->total_cycles = 0;
+    hist->max_cycles = 0;
+    for (uint32_t i = 0; i < SYSCALL_PROFILE_BUCKETS; ++i) {
+        hist->buckets[i] = 0;
+    }
+}
+
+void bench_hist_add(bench_hist_t *hist, uint64_t cycles) {
+    hist->count++;
+    hist->total_cycles += cycles;
+    if (cycles > hist->max_cycles) {
+        hist->max_cycles = cycles;
+    }
+    hist->buckets[hist_bucket(cycles)]++;
+}
+
+uint64_t bench_hist_percentile(const bench_hist_t *hist, uint32_t per_mille) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint64_t rank = (hist->count * per_mille + 999) / 1000;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < SYSCALL_PROFILE_BUCKETS; ++i) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint64_t value = hist_bucket_floor(i);
+            return value < hist->max_cycles ? value : hist->max_cycles;
+        }
+    }
+    return hist->max_cycles;
+}
+
+void bench_hist_print(const char *label, const bench_hist_t *hist) {
+    serial_write_string("[BENCH] hist ");
+    serial_write_string(label);
+    serial_write_string(" n=");
+    bench_print_u64(hist->count);
+    if (hist->count != 0) {
+        serial_write_string(" avg=");
+        bench_print_u64(hist->total_cycles / hist->count);
+        serial_write_string(" min=");
+        bench_print_u64(bench_hist_percentile(hist, 0));
+        serial_write_string(" p50=");
+        bench_print_u64(bench_hist_percentile(hist, 500));
+        serial_write_string(" p90=");
+        bench_print_u64(bench_hist_percentile(hist, 900));
+        serial_write_string(" p99=");
+        bench_print_u64(bench_hist_percentile(hist, 990));
+        serial_write_string(" p999=");
+        bench_print_u64(bench_hist_percentile(hist, 999));
+        serial_write_string(" max=");
+        bench_print_u64(hist->max_cycles);
+    }
+    serial_write_string(" cycles\n");
+}
@@ -0,0 +1,26 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_IDLE_SLEEP_NS 2000000000ULL
+
+void benchmark_idle(void) {
+    timer_stats_t before;
+    timer_stats_t after;
+
+    if (timer_get_stats(&before) < 0 || before.now_ns == 0) {
+        serial_write_string("[BENCH] idle skipped, no timer\n");
+        return;
+    }
+    process_sleep_ns(BENCH_IDLE_SLEEP_NS);
+    timer_get_stats(&after);
+
+    uint64_t elapsed_ms = (after.now_ns - before.now_ns) / 1000000ULL;
+    if (elapsed_ms == 0) {
+        return;
+    }
+    bench_print_result("idle elapsed", elapsed_ms, "ms");
+    bench_print_result("idle interrupts", ((after.interrupts - before.interrupts) * 1000ULL) / elapsed_ms, "/s");
+    bench_print_result("idle timer interrupts", ((after.timer_interrupts - before.timer_interrupts) * 1000ULL) / elapsed_ms, "/s");
+    bench_print_result("idle wakeups", ((after.idle_wakeups - before.idle_wakeups) * 1000ULL) / elapsed_ms, "/s");
+}
@@ -0,0 +1,143 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_JITTER_FRAMES 120
+#define BENCH_JITTER_HOGS 8
+#define BENCH_JITTER_PERIOD_NS 10000000ULL
+#define BENCH_JITTER_WORK_NS 1000000ULL
+#define BENCH_JITTER_RUNTIME_NS 3000000ULL
+#define BENCH_JITTER_RT_PRIORITY 16
+#define BENCH_JITTER_CALIBRATE_NS 20000000ULL
+
+static volatile uint32_t g_jitter_stop = 0;
+static volatile uint64_t g_jitter_sink = 0;
+static uint64_t g_jitter_tsc_per_ms = 0;
+static uint32_t g_jitter_missed = 0;
+static bench_hist_t g_jitter_hist;
+
+static uint64_t jitter_now_ns(void) {
+    timer_stats_t stats;
+    timer_get_stats(&stats);
+    return stats.now_ns;
+}
+
+static uint64_t jitter_calibrate(void) {
+    uint64_t ns_start = jitter_now_ns();
+    uint64_t tsc_start = bench_rdtsc();
+    process_sleep_ns(BENCH_JITTER_CALIBRATE_NS);
+    uint64_t ns = jitter_now_ns() - ns_start;
+    uint64_t tsc = bench_rdtsc() - tsc_start;
+    return ns != 0 ? (tsc * 1000000ULL) / ns : 0;
+}
+
+static int32_t jitter_hog(void *arg) {
+    (void)arg;
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    while (!__atomic_load_n(&g_jitter_stop, __ATOMIC_ACQUIRE)) {
+        for (uint32_t i = 0; i < 1000; ++i) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+        }
+    }
+    g_jitter_sink += x;
+    return 0;
+}
+
+static void jitter_spin(uint64_t cycles) {
+    uint64_t end = bench_rdtsc() + cycles;
+    while (bench_rdtsc() < end) {
+    }
+}
+
+// Frame k should start at start + k * period; the histogram records how
+// far off each frame actually started.
+static int32_t jitter_frame_loop(void *arg) {
+    int32_t policy = (int32_t)(uintptr_t)arg;
+    int32_t rc = 0;
+    if (policy == SCHED_POLICY_FIFO) {
+        rc = sched_set(SCHED_POLICY_FIFO, BENCH_JITTER_RT_PRIORITY, 0);
+    } else if (policy == SCHED_POLICY_DEADLINE) {
+        rc = sched_set(SCHED_POLICY_DEADLINE, BENCH_JITTER_RUNTIME_NS, BENCH_JITTER_PERIOD_NS);
+    }
+    if (rc < 0) {
+        return -1;
+    }
+
+    uint64_t period = (g_jitter_tsc_per_ms * BENCH_JITTER_PERIOD_NS) / 1000000ULL;
+    uint64_t work = (g_jitter_tsc_per_ms * BENCH_JITTER_WORK_NS) / 1000000ULL;
+    uint64_t start = bench_rdtsc();
+    for (uint32_t frame = 0; frame < BENCH_JITTER_FRAMES; ++frame) {
+        uint64_t ideal = start + (uint64_t)frame * period;
+        uint64_t now = bench_rdtsc();
+        bench_hist_add(&g_jitter_hist, now > ideal ? now - ideal : ideal - now);
+        if (now > ideal + period) {
+            g_jitter_missed++;
+        }
+        jitter_spin(work);
+
+        if (policy == SCHED_POLICY_DEADLINE) {
+            // Giving up the budget parks the task until its next period.
+            process_yield();
+            continue;
+        }
+        uint64_t next = ideal + period;
+        now = bench_rdtsc();
+        if (next > now) {
+            process_sleep_ns(((next - now) * 1000000ULL) / g_jitter_tsc_per_ms);
+        }
+    }
+    sched_set(SCHED_POLICY_NORMAL, 0, 0);
+    return 0;
+}
+
+static void jitter_phase(const char *label, int32_t policy) {
+    int32_t hogs[BENCH_JITTER_HOGS];
+    uint32_t hog_count = 0;
+    int32_t exit_code = -1;
+
+    g_jitter_stop = 0;
+    g_jitter_missed = 0;
+    bench_hist_reset(&g_jitter_hist);
+    for (uint32_t i = 0; i < BENCH_JITTER_HOGS; ++i) {
+        hogs[hog_count] = thread_create(jitter_hog, NULL);
+        if (hogs[hog_count] >= 0) {
+            hog_count++;
+        }
+    }
+    int32_t tid = thread_create(jitter_frame_loop, (void *)(uintptr_t)policy);
+    if (tid >= 0) {
+        thread_join(tid, &exit_code);
+    }
+    __atomic_store_n(&g_jitter_stop, 1, __ATOMIC_RELEASE);
+    for (uint32_t i = 0; i < hog_count; ++i) {
+        thread_join(hogs[i], NULL);
+    }
+
+    if (exit_code < 0) {
+        serial_write_string("[BENCH] jitter ");
+        serial_write_string(label);
+        serial_write_string(" skipped, sched_set failed\n");
+        return;
+    }
+    serial_write_string("[BENCH] jitter ");
+    serial_write_string(label);
+    serial_write_string(" hogs=");
+    bench_print_u64(hog_count);
+    serial_write_string(" missed_frames=");
+    bench_print_u64(g_jitter_missed);
+    serial_write_string("\n");
+    bench_hist_print(label, &g_jitter_hist);
+}
+
+void benchmark_jitter(void) {
+    g_jitter_tsc_per_ms = jitter_calibrate();
+    if (g_jitter_tsc_per_ms == 0) {
+        serial_write_string("[BENCH] jitter skipped, no timer\n");
+        return;
+    }
+    jitter_phase("frame start normal", SCHED_POLICY_NORMAL);
+    jitter_phase("frame start fifo", SCHED_POLICY_FIFO);
+    jitter_phase("frame start deadline", SCHED_POLICY_DEADLINE);
+}
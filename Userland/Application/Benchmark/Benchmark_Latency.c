@@ -0,0 +1,122 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_LATENCY_READERS 2
+#define BENCH_LATENCY_TICKERS 4
+#define BENCH_LATENCY_READ_PASSES 8
+#define BENCH_LATENCY_IDLE_NS 200000000ULL
+#define BENCH_LATENCY_TICK_NS 1000000ULL
+#define BENCH_LATENCY_CHUNK 4096
+#define BENCH_LATENCY_FILE "LOGO.PNG"
+
+static volatile uint32_t g_latency_stop = 0;
+static volatile uint64_t g_latency_overshoot_max = 0;
+static volatile uint64_t g_latency_bytes = 0;
+static uint8_t g_latency_buffer[BENCH_LATENCY_READERS][BENCH_LATENCY_CHUNK];
+
+static uint64_t latency_now_ns(void) {
+    timer_stats_t stats;
+    timer_get_stats(&stats);
+    return stats.now_ns;
+}
+
+static int32_t latency_ticker(void *arg) {
+    (void)arg;
+    while (!__atomic_load_n(&g_latency_stop, __ATOMIC_ACQUIRE)) {
+        uint64_t start = latency_now_ns();
+        process_sleep_ns(BENCH_LATENCY_TICK_NS);
+        uint64_t slept = latency_now_ns() - start;
+        uint64_t over = slept > BENCH_LATENCY_TICK_NS ? slept - BENCH_LATENCY_TICK_NS : 0;
+        uint64_t seen = __atomic_load_n(&g_latency_overshoot_max, __ATOMIC_RELAXED);
+        while (over > seen &&
+               !__atomic_compare_exchange_n(&g_latency_overshoot_max, &seen, over, 0,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+    }
+    return 0;
+}
+
+static int32_t latency_reader(void *arg) {
+    uint8_t *buffer = g_latency_buffer[(uintptr_t)arg];
+    for (uint32_t pass = 0; pass < BENCH_LATENCY_READ_PASSES; ++pass) {
+        int32_t fd = file_open(BENCH_LATENCY_FILE, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        int64_t n;
+        while ((n = file_read(fd, buffer, BENCH_LATENCY_CHUNK)) > 0) {
+            __atomic_fetch_add(&g_latency_bytes, (uint64_t)n, __ATOMIC_RELAXED);
+        }
+        file_close(fd);
+    }
+    return 0;
+}
+
+static void latency_phase(const char *label, uint32_t readers) {
+    int32_t tickers[BENCH_LATENCY_TICKERS];
+    int32_t workers[BENCH_LATENCY_READERS];
+    uint32_t ticker_count = 0;
+    uint32_t reader_count = 0;
+    timer_stats_t before;
+    timer_stats_t after;
+
+    g_latency_stop = 0;
+    g_latency_overshoot_max = 0;
+    g_latency_bytes = 0;
+    timer_get_stats(&before);
+
+    for (uint32_t i = 0; i < BENCH_LATENCY_TICKERS; ++i) {
+        tickers[ticker_count] = thread_create(latency_ticker, NULL);
+        if (tickers[ticker_count] >= 0) {
+            ticker_count++;
+        }
+    }
+    for (uint32_t i = 0; i < readers; ++i) {
+        workers[reader_count] = thread_create(latency_reader, (void *)(uintptr_t)i);
+        if (workers[reader_count] >= 0) {
+            reader_count++;
+        }
+    }
+    if (reader_count == 0) {
+        process_sleep_ns(BENCH_LATENCY_IDLE_NS);
+    }
+    for (uint32_t i = 0; i < reader_count; ++i) {
+        thread_join(workers[i], NULL);
+    }
+    __atomic_store_n(&g_latency_stop, 1, __ATOMIC_RELEASE);
+    for (uint32_t i = 0; i < ticker_count; ++i) {
+        thread_join(tickers[i], NULL);
+    }
+    timer_get_stats(&after);
+
+    uint64_t samples = after.irq_latency_samples - before.irq_latency_samples;
+    uint64_t total_ns = after.irq_latency_total_ns - before.irq_latency_total_ns;
+
+    serial_write_string("[BENCH] latency ");
+    serial_write_string(label);
+    serial_write_string(" bytes=");
+    bench_print_u64(g_latency_bytes);
+    serial_write_string(" elapsed_ms=");
+    bench_print_u64((after.now_ns - before.now_ns) / 1000000ULL);
+    serial_write_string(" timer_avg_ns=");
+    bench_print_u64(samples != 0 ? total_ns / samples : 0);
+    serial_write_string(" timer_slow=");
+    bench_print_u64(after.irq_latency_slow - before.irq_latency_slow);
+    serial_write_string(" sleep_overshoot_max_us=");
+    bench_print_u64(g_latency_overshoot_max / 1000ULL);
+    serial_write_string("\n");
+}
+
+void benchmark_latency(void) {
+    timer_stats_t probe;
+    if (timer_get_stats(&probe) < 0 || probe.now_ns == 0) {
+        serial_write_string("[BENCH] latency skipped, no timer\n");
+        return;
+    }
+    latency_phase("idle", 0);
+    latency_phase("file-io", BENCH_LATENCY_READERS);
+
+    timer_get_stats(&probe);
+    bench_print_result("latency timer max since boot", probe.irq_latency_max_ns / 1000ULL, "us");
+}
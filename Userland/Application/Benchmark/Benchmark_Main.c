@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+uint64_t bench_rdtsc(void) {
+    uint32_t low, high;
+    __asm__ volatile ("lfence; rdtsc" : "=a"(low), "=d"(high) :: "memory");
+    return ((uint64_t)high << 32) | low;
+}
+
+void bench_print_u64(uint64_t value) {
+    char digits[21];
+    int pos = 20;
+    digits[pos] = '\0';
+    do {
+        digits[--pos] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+    serial_write_string(&digits[pos]);
+}
+
+void bench_print_result(const char *label, uint64_t value, const char *unit) {
+    serial_write_string("[BENCH] ");
+    serial_write_string(label);
+    serial_write_string(" = ");
+    bench_print_u64(value);
+    serial_write_string(" ");
+    serial_write_string(unit);
+    serial_write_string("\n");
+}
+
+void benchmark_run_all(void) {
+    serial_write_string("[BENCH] ===== Benchmarks Starting =====\n");
+    benchmark_scheduler();
+    benchmark_parallel();
+    benchmark_balance();
+    benchmark_idle();
+    benchmark_futex();
+    benchmark_fpu();
+    benchmark_simd();
+    benchmark_latency();
+    benchmark_syscall();
+    benchmark_jitter();
+    benchmark_affinity();
+    benchmark_ring();
+    benchmark_heap();
+    benchmark_file();
+    benchmark_pipe();
+    benchmark_channel();
+    benchmark_poll();
+
+    // Benchmarks log a lot; anything the serial ring had to drop shows here.
+    serial_stats_t serial;
+    if (serial_get_stats(&serial) == 0) {
+        serial_write_string("[BENCH] serial written=");
+        bench_print_u64(serial.written_bytes);
+        serial_write_string(" dropped_msgs=");
+        bench_print_u64(serial.dropped_messages);
+        serial_write_string(" dropped_bytes=");
+        bench_print_u64(serial.dropped_bytes);
+        serial_write_string("\n");
+    }
+    // Only does anything on a KERNEL_TRACE=1 kernel.
+    if (trace_control(TRACE_CTL_DUMP) >= 0) {
+        serial_write_string("[BENCH] trace dumped, decode with Tools/trace2json.py\n");
+    }
+    serial_write_string("[BENCH] ===== Benchmarks Complete =====\n");
+}
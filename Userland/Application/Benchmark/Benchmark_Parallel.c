@@ -0,0 +1,84 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_PARALLEL_MAX_WORKERS 4
+#define BENCH_PARALLEL_CHUNKS 256
+#define BENCH_PARALLEL_CHUNK_ITERS 20000
+
+typedef struct {
+    uint64_t result;
+} parallel_tls_t;
+
+static const uint32_t g_parallel_worker_counts[] = {1, 2, BENCH_PARALLEL_MAX_WORKERS};
+
+static parallel_tls_t g_parallel_tls[BENCH_PARALLEL_MAX_WORKERS];
+
+static parallel_tls_t *parallel_tls_self(void) {
+    return (parallel_tls_t *)thread_get_tls();
+}
+
+static int32_t parallel_worker(void *arg) {
+    parallel_tls_t *tls = (parallel_tls_t *)arg;
+    if (thread_set_tls(tls) < 0) {
+        return -1;
+    }
+
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (uint32_t chunk = 0; chunk < BENCH_PARALLEL_CHUNKS; ++chunk) {
+        for (uint32_t i = 0; i < BENCH_PARALLEL_CHUNK_ITERS; ++i) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+        process_yield();
+    }
+    parallel_tls_self()->result = x;
+    return parallel_tls_self() == tls ? 0 : -1;
+}
+
+static uint64_t parallel_run(uint32_t workers) {
+    int32_t tids[BENCH_PARALLEL_MAX_WORKERS];
+    uint32_t created = 0;
+    uint32_t errors = 0;
+
+    uint64_t start = bench_rdtsc();
+    for (uint32_t i = 0; i < workers; ++i) {
+        tids[created] = thread_create(parallel_worker, &g_parallel_tls[i]);
+        if (tids[created] < 0) {
+            break;
+        }
+        created++;
+    }
+    for (uint32_t i = 0; i < created; ++i) {
+        int32_t exit_code = 0;
+        if (thread_join(tids[i], &exit_code) != tids[i] || exit_code != 0) {
+            errors++;
+        }
+    }
+    uint64_t cycles = bench_rdtsc() - start;
+
+    serial_write_string("[BENCH] parallel workers=");
+    bench_print_u64(created);
+    serial_write_string(" cycles=");
+    bench_print_u64(cycles);
+    serial_write_string(" chunks/Mcycle=");
+    bench_print_u64(cycles ? ((uint64_t)created * BENCH_PARALLEL_CHUNKS * 1000000ULL) / cycles : 0);
+    serial_write_string(" tls_errors=");
+    bench_print_u64(errors);
+    serial_write_string("\n");
+    return created ? cycles / created : 0;
+}
+
+void benchmark_parallel(void) {
+    uint64_t base = 0;
+    for (uint32_t i = 0; i < sizeof(g_parallel_worker_counts) / sizeof(g_parallel_worker_counts[0]); ++i) {
+        uint64_t per_worker = parallel_run(g_parallel_worker_counts[i]);
+        if (i == 0) {
+            base = per_worker;
+        }
+        if (per_worker != 0) {
+            serial_write_string("[BENCH] parallel scaling x100 = ");
+            bench_print_u64((base * 100) / per_worker);
+            serial_write_string("\n");
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_PIPE_BYTES (64ULL * 1024 * 1024)
+#define BENCH_PIPE_SMALL_MSGS 20000
+#define BENCH_PIPE_SMALL 64
+#define BENCH_PIPE_CHUNK_MAX (64 * 1024)
+
+static uint8_t g_pipe_tx[BENCH_PIPE_CHUNK_MAX];
+static uint8_t g_pipe_rx[BENCH_PIPE_CHUNK_MAX];
+static int32_t g_pipe_fds[2];
+static uint64_t g_pipe_chunk;
+static uint64_t g_pipe_total;
+
+static uint64_t pipe_now_ns(void) {
+    timer_stats_t stats;
+    timer_get_stats(&stats);
+    return stats.now_ns;
+}
+
+static int32_t pipe_writer(void *arg) {
+    (void)arg;
+    uint64_t sent = 0;
+    while (sent < g_pipe_total) {
+        uint64_t n = g_pipe_total - sent < g_pipe_chunk ? g_pipe_total - sent : g_pipe_chunk;
+        if (file_write(g_pipe_fds[1], g_pipe_tx, n) <= 0) {
+            break;
+        }
+        sent += n;
+    }
+    file_close(g_pipe_fds[1]);
+    return 0;
+}
+
+// The writer closes its end when done, so the reader runs until EOF and
+// the byte count also checks nothing was lost.
+static void pipe_run(const char *label, uint64_t chunk, uint64_t total) {
+    if (file_pipe(g_pipe_fds) < 0) {
+        serial_write_string("[BENCH] pipe skipped, no free descriptors\n");
+        return;
+    }
+    g_pipe_chunk = chunk;
+    g_pipe_total = total;
+
+    uint64_t start = pipe_now_ns();
+    int32_t tid = thread_create(pipe_writer, NULL);
+    if (tid < 0) {
+        file_close(g_pipe_fds[0]);
+        file_close(g_pipe_fds[1]);
+        return;
+    }
+    uint64_t received = 0;
+    int64_t n;
+    while ((n = file_read(g_pipe_fds[0], g_pipe_rx, chunk)) > 0) {
+        received += (uint64_t)n;
+    }
+    uint64_t elapsed_ns = pipe_now_ns() - start;
+    thread_join(tid, NULL);
+    file_close(g_pipe_fds[0]);
+
+    serial_write_string("[BENCH] pipe ");
+    serial_write_string(label);
+    serial_write_string(" bytes=");
+    bench_print_u64(received);
+    serial_write_string(" elapsed_us=");
+    bench_print_u64(elapsed_ns / 1000ULL);
+    serial_write_string(" mb_per_sec=");
+    bench_print_u64(elapsed_ns != 0 ? received * 1000ULL / elapsed_ns : 0);
+    serial_write_string(" msgs_per_sec=");
+    bench_print_u64(elapsed_ns != 0 ? (received / chunk) * 1000000000ULL / elapsed_ns : 0);
+    serial_write_string("\n");
+}
+
+void benchmark_pipe(void) {
+    for (uint32_t i = 0; i < BENCH_PIPE_CHUNK_MAX; ++i) {
+        g_pipe_tx[i] = (uint8_t)i;
+    }
+    pipe_run("64B", BENCH_PIPE_SMALL, (uint64_t)BENCH_PIPE_SMALL * BENCH_PIPE_SMALL_MSGS);
+    pipe_run("4KiB", 4096, BENCH_PIPE_BYTES);
+    pipe_run("64KiB", BENCH_PIPE_CHUNK_MAX, BENCH_PIPE_BYTES);
+}
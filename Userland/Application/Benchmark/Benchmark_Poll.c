@@ -0,0 +1,154 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_POLL_PIPES 5
+#define BENCH_POLL_CHANNELS 8
+#define BENCH_POLL_ROUNDS 5000
+#define BENCH_POLL_CHECKS 5000
+#define BENCH_POLL_BATCH 16
+
+static bench_hist_t g_poll_hist;
+static int32_t g_poll_fds[BENCH_POLL_PIPES][2];
+static int32_t g_poll_reply[2];
+static int32_t g_poll_channels[BENCH_POLL_CHANNELS];
+static uint32_t g_poll_pipes;
+static uint32_t g_poll_channel_count;
+
+// Drains whichever request pipes came back ready and answers each byte on
+// the reply pipe. Stops once every watched pipe reports POLL_HUP.
+static int32_t poll_echo(void *arg) {
+    int32_t set = (int32_t)(intptr_t)arg;
+    poll_event_t ready[BENCH_POLL_BATCH];
+    uint32_t open = g_poll_pipes;
+    uint8_t byte;
+    while (open != 0) {
+        int32_t n = poll_wait(set, ready, BENCH_POLL_BATCH, POLL_WAIT_FOREVER);
+        if (n < 0) {
+            break;
+        }
+        for (int32_t i = 0; i < n; ++i) {
+            int32_t fd = g_poll_fds[ready[i].user_data][0];
+            // One byte is in flight at a time, so a single read drains the
+            // pipe in both modes.
+            if (ready[i].events & POLL_IN) {
+                if (file_read(fd, &byte, 1) == 1) {
+                    file_write(g_poll_reply[1], &byte, 1);
+                }
+            } else if (ready[i].events & POLL_HUP) {
+                poll_event_t del = { .source = POLL_SOURCE_FD, .id = fd };
+                poll_ctl(set, POLL_CTL_DEL, &del);
+                open--;
+            }
+        }
+    }
+    return 0;
+}
+
+static int32_t poll_watch(int32_t set, uint32_t source, int32_t id, uint32_t flags, uint64_t user_data) {
+    poll_event_t event = {
+        .source = source, .id = id, .events = POLL_IN, .flags = flags, .user_data = user_data
+    };
+    return poll_ctl(set, POLL_CTL_ADD, &event);
+}
+
+// Idle sets should cost the same to check however many items they hold.
+static void poll_bench_check(int32_t set) {
+    poll_event_t ready[BENCH_POLL_BATCH];
+    bench_hist_reset(&g_poll_hist);
+    for (uint32_t i = 0; i < BENCH_POLL_CHECKS; ++i) {
+        uint64_t start = bench_rdtsc();
+        poll_wait(set, ready, BENCH_POLL_BATCH, 0);
+        bench_hist_add(&g_poll_hist, bench_rdtsc() - start);
+    }
+    bench_hist_print("poll idle check", &g_poll_hist);
+}
+
+static void poll_bench_round_trip(const char *label, uint32_t flags) {
+    int32_t set = poll_create();
+    if (set < 0) {
+        serial_write_string("[BENCH] poll skipped, create failed\n");
+        return;
+    }
+    for (uint32_t i = 0; i < g_poll_pipes; ++i) {
+        poll_watch(set, POLL_SOURCE_FD, g_poll_fds[i][0], flags, i);
+    }
+    for (uint32_t i = 0; i < g_poll_channel_count; ++i) {
+        poll_watch(set, POLL_SOURCE_CHANNEL, g_poll_channels[i], flags, 0);
+    }
+    if (flags == 0) {
+        poll_bench_check(set);
+    }
+
+    int32_t tid = thread_create(poll_echo, (void *)(intptr_t)set);
+    if (tid < 0) {
+        poll_destroy(set);
+        serial_write_string("[BENCH] poll skipped, thread_create failed\n");
+        return;
+    }
+    bench_hist_reset(&g_poll_hist);
+    uint8_t byte = 0;
+    for (uint32_t i = 0; i < BENCH_POLL_ROUNDS; ++i) {
+        uint64_t start = bench_rdtsc();
+        file_write(g_poll_fds[i % g_poll_pipes][1], &byte, 1);
+        if (file_read(g_poll_reply[0], &byte, 1) != 1) {
+            break;
+        }
+        bench_hist_add(&g_poll_hist, bench_rdtsc() - start);
+    }
+    // Closing the write ends hangs up every watched pipe and ends the echo.
+    for (uint32_t i = 0; i < g_poll_pipes; ++i) {
+        file_close(g_poll_fds[i][1]);
+    }
+    thread_join(tid, NULL);
+    poll_destroy(set);
+    bench_hist_print(label, &g_poll_hist);
+}
+
+static int poll_open_pipes(void) {
+    g_poll_pipes = 0;
+    for (uint32_t i = 0; i < BENCH_POLL_PIPES; ++i) {
+        if (file_pipe(g_poll_fds[i]) < 0) {
+            break;
+        }
+        g_poll_pipes++;
+    }
+    return g_poll_pipes != 0;
+}
+
+static void poll_close_pipes(void) {
+    for (uint32_t i = 0; i < g_poll_pipes; ++i) {
+        file_close(g_poll_fds[i][0]);
+    }
+}
+
+void benchmark_poll(void) {
+    if (file_pipe(g_poll_reply) < 0) {
+        serial_write_string("[BENCH] poll skipped, no free descriptors\n");
+        return;
+    }
+    g_poll_channel_count = 0;
+    for (uint32_t i = 0; i < BENCH_POLL_CHANNELS; ++i) {
+        g_poll_channels[i] = channel_create();
+        if (g_poll_channels[i] < 0) {
+            break;
+        }
+        g_poll_channel_count++;
+    }
+
+    // Idle channels pad the set so the wait has far more watched than ready.
+    if (poll_open_pipes()) {
+        poll_bench_round_trip("poll level round-trip", 0);
+        poll_close_pipes();
+    }
+    if (poll_open_pipes()) {
+        poll_bench_round_trip("poll edge round-trip", POLL_EDGE);
+        poll_close_pipes();
+    }
+
+    for (uint32_t i = 0; i < g_poll_channel_count; ++i) {
+        channel_destroy(g_poll_channels[i]);
+    }
+    file_close(g_poll_reply[0]);
+    file_close(g_poll_reply[1]);
+}
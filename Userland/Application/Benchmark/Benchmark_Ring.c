@@ -0,0 +1,134 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "../../Ring.h"
+#include "Benchmark.h"
+
+#define BENCH_RING_OPS 20000
+#define BENCH_RING_ENTRIES 256
+#define BENCH_RING_DRAW_OPS 4096
+#define BENCH_RING_CHUNK 256
+#define BENCH_RING_FILE "LOGO.PNG"
+
+static ring_sqe_t g_ring_sqes[BENCH_RING_ENTRIES];
+static ring_cqe_t g_ring_cqes[BENCH_RING_ENTRIES * 2];
+static uint8_t g_ring_buffer[BENCH_RING_CHUNK];
+
+typedef enum {
+    RING_BENCH_NOP,
+    RING_BENCH_DRAW,
+    RING_BENCH_READ,
+} ring_bench_kind_t;
+
+static uint64_t ring_now_ns(void) {
+    timer_stats_t stats;
+    timer_get_stats(&stats);
+    return stats.now_ns;
+}
+
+static void ring_print_rate(const char *label, uint64_t ops, uint64_t elapsed_ns) {
+    serial_write_string("[BENCH] ring ");
+    serial_write_string(label);
+    serial_write_string(" ops=");
+    bench_print_u64(ops);
+    serial_write_string(" ops_per_sec=");
+    bench_print_u64(elapsed_ns != 0 ? ops * 1000000000ULL / elapsed_ns : 0);
+    serial_write_string("\n");
+}
+
+static void ring_prep(ring_bench_kind_t kind, ring_sqe_t *sqe, int32_t fd, uint32_t i) {
+    switch (kind) {
+        case RING_BENCH_NOP:
+            ring_prep_nop(sqe, i);
+            break;
+        case RING_BENCH_DRAW:
+            ring_prep_fill_rect(sqe, i % 64, (i / 64) % 64, 1, 1, 0xFF000000u | i);
+            break;
+        case RING_BENCH_READ:
+            ring_prep_read(sqe, fd, g_ring_buffer, BENCH_RING_CHUNK, i);
+            break;
+    }
+}
+
+static void ring_call(ring_bench_kind_t kind, int32_t fd, uint32_t i) {
+    switch (kind) {
+        case RING_BENCH_NOP:
+            (void)thread_self();
+            break;
+        case RING_BENCH_DRAW:
+            draw_fill_rect(i % 64, (i / 64) % 64, 1, 1, 0xFF000000u | i);
+            break;
+        case RING_BENCH_READ:
+            (void)file_read(fd, g_ring_buffer, BENCH_RING_CHUNK);
+            break;
+    }
+}
+
+// Reads past the end of the file return 0 either way, so the read case
+// measures the call path rather than how much data there is.
+static void ring_compare(const char *label, ring_bench_kind_t kind, uint32_t ops, uint32_t batch) {
+    int32_t fd = -1;
+    if (kind == RING_BENCH_READ) {
+        fd = file_open(BENCH_RING_FILE, 0);
+        if (fd < 0) {
+            serial_write_string("[BENCH] ring read skipped, no " BENCH_RING_FILE "\n");
+            return;
+        }
+    }
+
+    uint64_t start = ring_now_ns();
+    for (uint32_t i = 0; i < ops; ++i) {
+        ring_call(kind, fd, i);
+    }
+    uint64_t plain_ns = ring_now_ns() - start;
+
+    ring_t ring;
+    if (ring_init(&ring, g_ring_sqes, BENCH_RING_ENTRIES, g_ring_cqes, BENCH_RING_ENTRIES * 2) < 0) {
+        serial_write_string("[BENCH] ring skipped, setup failed\n");
+        if (fd >= 0) {
+            file_close(fd);
+        }
+        return;
+    }
+    uint32_t done = 0;
+    start = ring_now_ns();
+    for (uint32_t i = 0; i < ops;) {
+        uint32_t queued = 0;
+        while (queued < batch && i < ops) {
+            ring_sqe_t *sqe = ring_get_sqe(&ring);
+            if (sqe == NULL) {
+                break;
+            }
+            ring_prep(kind, sqe, fd, i++);
+            queued++;
+        }
+        if (ring_submit(&ring) < 0) {
+            break;
+        }
+        done += ring_drain(&ring);
+    }
+    uint64_t ring_ns = ring_now_ns() - start;
+    ring_destroy(&ring);
+    if (fd >= 0) {
+        file_close(fd);
+    }
+
+    serial_write_string("[BENCH] ring ");
+    serial_write_string(label);
+    serial_write_string(" batch=");
+    bench_print_u64(batch);
+    serial_write_string("\n");
+    ring_print_rate("  syscall", ops, plain_ns);
+    ring_print_rate("  ring", done, ring_ns);
+}
+
+void benchmark_ring(void) {
+    if (ring_now_ns() == 0) {
+        serial_write_string("[BENCH] ring skipped, no timer\n");
+        return;
+    }
+    ring_compare("nop", RING_BENCH_NOP, BENCH_RING_OPS, 1);
+    ring_compare("nop", RING_BENCH_NOP, BENCH_RING_OPS, 32);
+    ring_compare("nop", RING_BENCH_NOP, BENCH_RING_OPS, BENCH_RING_ENTRIES);
+    ring_compare("draw", RING_BENCH_DRAW, BENCH_RING_DRAW_OPS, BENCH_RING_ENTRIES);
+    ring_compare("read", RING_BENCH_READ, BENCH_RING_OPS, BENCH_RING_ENTRIES);
+}
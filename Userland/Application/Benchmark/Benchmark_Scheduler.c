@@ -0,0 +1,58 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_SCHED_ROUNDS 64
+
+static const uint32_t g_sched_task_counts[] = {1, 16, 64, 256, 1024, 2048};
+
+static volatile uint32_t g_sched_stop;
+static volatile uint32_t g_sched_alive;
+
+static int32_t sched_worker(void *arg) {
+    (void)arg;
+    __sync_fetch_and_add(&g_sched_alive, 1);
+    while (!g_sched_stop) {
+        process_yield();
+    }
+    return 0;
+}
+
+static void sched_run(uint32_t task_count) {
+    uint32_t created = 0;
+
+    g_sched_stop = 0;
+    g_sched_alive = 0;
+    for (uint32_t i = 1; i < task_count; ++i) {
+        if (thread_create(sched_worker, NULL) < 0) {
+            break;
+        }
+        created++;
+    }
+    while (g_sched_alive < created) {
+        process_yield();
+    }
+
+    uint64_t start = bench_rdtsc();
+    for (uint32_t round = 0; round < BENCH_SCHED_ROUNDS; ++round) {
+        process_yield();
+    }
+    uint64_t cycles = bench_rdtsc() - start;
+
+    g_sched_stop = 1;
+    while (process_wait(-1, NULL) >= 0) {
+    }
+
+    uint64_t switches = (uint64_t)BENCH_SCHED_ROUNDS * (created + 1);
+    serial_write_string("[BENCH] sched tasks=");
+    bench_print_u64(created + 1);
+    serial_write_string(" cycles/switch=");
+    bench_print_u64(cycles / switches);
+    serial_write_string("\n");
+}
+
+void benchmark_scheduler(void) {
+    for (uint32_t i = 0; i < sizeof(g_sched_task_counts) / sizeof(g_sched_task_counts[0]); ++i) {
+        sched_run(g_sched_task_counts[i]);
+    }
+}
@@ -0,0 +1,59 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "../../Heap.h"
+#include "../../String.h"
+#include "Benchmark.h"
+
+#define BENCH_SIMD_COPY_SIZE (1024 * 1024)
+#define BENCH_SIMD_COPY_ROUNDS 16
+#define BENCH_SIMD_FILL_SIZE 256
+#define BENCH_SIMD_FILL_ROUNDS 64
+
+static void simd_copy_run(uint32_t size) {
+    uint8_t *src = (uint8_t *)malloc(size);
+    uint8_t *dst = (uint8_t *)malloc(size);
+    if (src == NULL || dst == NULL) {
+        serial_write_string("[BENCH] simd memcpy allocation failed\n");
+        free(src);
+        free(dst);
+        return;
+    }
+    for (uint32_t i = 0; i < size; ++i) {
+        src[i] = (uint8_t)(i * 31);
+    }
+
+    uint64_t start = bench_rdtsc();
+    for (uint32_t round = 0; round < BENCH_SIMD_COPY_ROUNDS; ++round) {
+        memcpy(dst, src, size);
+    }
+    uint64_t cycles = bench_rdtsc() - start;
+
+    serial_write_string("[BENCH] user memcpy size=");
+    bench_print_u64(size);
+    serial_write_string(" bytes/kcycle=");
+    bench_print_u64(cycles ? ((uint64_t)size * BENCH_SIMD_COPY_ROUNDS * 1000ULL) / cycles : 0);
+    serial_write_string(" mismatch=");
+    bench_print_u64(memcmp(dst, src, size) != 0);
+    serial_write_string("\n");
+
+    free(src);
+    free(dst);
+}
+
+static void simd_fill_run(void) {
+    uint64_t start = bench_rdtsc();
+    for (uint32_t round = 0; round < BENCH_SIMD_FILL_ROUNDS; ++round) {
+        draw_fill_rect(0, 0, BENCH_SIMD_FILL_SIZE, BENCH_SIMD_FILL_SIZE, 0xFF000000u | round);
+    }
+    uint64_t cycles = bench_rdtsc() - start;
+    uint64_t pixels = (uint64_t)BENCH_SIMD_FILL_SIZE * BENCH_SIMD_FILL_SIZE * BENCH_SIMD_FILL_ROUNDS;
+
+    bench_print_result("kernel fill_rect", cycles ? (pixels * 1000ULL) / cycles : 0, "pixels/kcycle");
+    draw_fill_rect(0, 0, BENCH_SIMD_FILL_SIZE, BENCH_SIMD_FILL_SIZE, 0xFF000000u);
+}
+
+void benchmark_simd(void) {
+    simd_copy_run(4096);
+    simd_copy_run(BENCH_SIMD_COPY_SIZE);
+    simd_fill_run();
+}
@@ -0,0 +1,183 @@
+#include <stdint.h>
+#include "../../Syscalls.h"
+#include "Benchmark.h"
+
+#define BENCH_SYSCALL_NULL_ITERS 20000
+#define BENCH_SYSCALL_PINGPONG_ROUNDS 2000
+#define BENCH_SYSCALL_CREATE_ITERS 256
+
+static const char *const g_syscall_names[SYSCALL_PROFILE_SLOTS] = {
+    [1] = "serial_putchar",
+    [2] = "serial_puts",
+    [3] = "process_create",
+    [4] = "process_yield",
+    [5] = "process_exit",
+    [6] = "thread_create",
+    [7] = "set_priority",
+    [8] = "get_priority",
+    [9] = "process_cpu",
+    [10] = "draw_pixel",
+    [11] = "draw_fill_rect",
+    [12] = "draw_present",
+    [13] = "process_wait",
+    [14] = "process_sleep",
+    [15] = "timer_stats",
+    [16] = "thread_join",
+    [17] = "thread_set_fs",
+    [18] = "thread_id",
+    [19] = "process_id",
+    [20] = "file_open",
+    [21] = "file_read",
+    [22] = "file_write",
+    [23] = "file_close",
+    [24] = "mem_map",
+    [25] = "mem_unmap",
+    [28] = "futex_wait",
+    [29] = "futex_wake",
+    [30] = "profile_read",
+    [31] = "process_snapshot",
+    [32] = "sched_set",
+    [33] = "set_affinity",
+    [34] = "get_affinity",
+    [35] = "cpu_topology",
+    [36] = "ring_setup",
+    [37] = "ring_enter",
+    [38] = "ring_destroy",
+    [39] = "serial_stats",
+    [40] = "trace_ctl",
+    [41] = "file_pread",
+    [42] = "file_pwrite",
+    [43] = "file_readv",
+    [44] = "file_writev",
+    [45] = "file_pipe",
+    [46] = "channel_create",
+    [47] = "channel_destroy",
+    [48] = "channel_send",
+    [49] = "channel_call",
+    [50] = "channel_receive",
+    [51] = "poll_create",
+    [52] = "poll_destroy",
+    [53] = "poll_ctl",
+    [54] = "poll_wait",
+};
+
+static bench_hist_t g_hist;
+static bench_hist_t g_hist_start;
+static syscall_profile_t g_profile;
+
+static volatile uint32_t g_pingpong_turn;
+static volatile uint32_t g_pingpong_cpu;
+static volatile uint64_t g_create_started;
+
+static void syscall_bench_tsc(void) {
+    bench_hist_reset(&g_hist);
+    for (uint32_t i = 0; i < BENCH_SYSCALL_NULL_ITERS; ++i) {
+        uint64_t start = bench_rdtsc();
+        bench_hist_add(&g_hist, bench_rdtsc() - start);
+    }
+    bench_hist_print("rdtsc overhead", &g_hist);
+}
+
+static void syscall_bench_null(void) {
+    bench_hist_reset(&g_hist);
+    for (uint32_t i = 0; i < BENCH_SYSCALL_NULL_ITERS; ++i) {
+        uint64_t start = bench_rdtsc();
+        (void)thread_self();
+        bench_hist_add(&g_hist, bench_rdtsc() - start);
+    }
+    bench_hist_print("null syscall", &g_hist);
+}
+
+static int32_t pingpong_partner(void *arg) {
+    (void)arg;
+    g_pingpong_cpu = process_current_cpu();
+    for (uint32_t round = 0; round < BENCH_SYSCALL_PINGPONG_ROUNDS; ++round) {
+        while (g_pingpong_turn != 1) {
+            process_yield();
+        }
+        g_pingpong_turn = 0;
+    }
+    return 0;
+}
+
+static void syscall_bench_pingpong(void) {
+    g_pingpong_turn = 0;
+    g_pingpong_cpu = UINT32_MAX;
+    int32_t tid = thread_create(pingpong_partner, NULL);
+    if (tid < 0) {
+        serial_write_string("[BENCH] yield round-trip skipped, thread_create failed\n");
+        return;
+    }
+    while (g_pingpong_cpu == UINT32_MAX) {
+        process_yield();
+    }
+    uint32_t self_cpu = process_current_cpu();
+
+    bench_hist_reset(&g_hist);
+    for (uint32_t round = 0; round < BENCH_SYSCALL_PINGPONG_ROUNDS; ++round) {
+        uint64_t start = bench_rdtsc();
+        g_pingpong_turn = 1;
+        while (g_pingpong_turn != 0) {
+            process_yield();
+        }
+        bench_hist_add(&g_hist, bench_rdtsc() - start);
+    }
+    thread_join(tid, NULL);
+
+    // Both threads may sit on different CPUs; then this measures the
+    // cross-CPU hand-off rather than two local switches.
+    serial_write_string("[BENCH] yield round-trip same_cpu=");
+    bench_print_u64(self_cpu == g_pingpong_cpu ? 1 : 0);
+    serial_write_string("\n");
+    bench_hist_print("yield round-trip", &g_hist);
+}
+
+static int32_t create_child(void *arg) {
+    (void)arg;
+    g_create_started = bench_rdtsc();
+    return 0;
+}
+
+static void syscall_bench_create(void) {
+    bench_hist_reset(&g_hist);
+    bench_hist_reset(&g_hist_start);
+    for (uint32_t i = 0; i < BENCH_SYSCALL_CREATE_ITERS; ++i) {
+        g_create_started = 0;
+        uint64_t start = bench_rdtsc();
+        int32_t tid = thread_create(create_child, NULL);
+        uint64_t end = bench_rdtsc();
+        if (tid < 0) {
+            break;
+        }
+        bench_hist_add(&g_hist, end - start);
+        thread_join(tid, NULL);
+        if (g_create_started > start) {
+            bench_hist_add(&g_hist_start, g_create_started - start);
+        }
+    }
+    bench_hist_print("thread create", &g_hist);
+    bench_hist_print("thread create-to-run", &g_hist_start);
+}
+
+static void syscall_bench_dispatch(void) {
+    if (syscall_profile_read(0, &g_profile) < 0) {
+        serial_write_string("[BENCH] dispatch profile off, build with KERNEL_SYSCALL_PROFILE=1\n");
+        return;
+    }
+    // Counted since boot; blocking calls include the time spent asleep.
+    serial_write_string("[BENCH] dispatch cost per syscall since boot\n");
+    for (uint32_t num = 1; num < SYSCALL_PROFILE_SLOTS; ++num) {
+        if (syscall_profile_read(num, &g_profile) < 0 || g_profile.count == 0) {
+            continue;
+        }
+        bench_hist_print(g_syscall_names[num] != NULL ? g_syscall_names[num] : "unknown", &g_profile);
+    }
+}
+
+void benchmark_syscall(void) {
+    syscall_bench_tsc();
+    syscall_bench_null();
+    syscall_bench_pingpong();
+    syscall_bench_create();
+    syscall_bench_dispatch();
+}
@@ -1,10 +1,8 @@
 #include <stdint.h>
-#include "../../Syscalls.h"
+#include "../../Heap.h"
+#include "../../String.h"
 #include "PNG_Decoder.h"
 
-extern void* kmalloc(uint32_t size);
-extern void kfree(void* ptr);
-
 static uint32_t read_be32(const uint8_t* p) {
     return (p[0] << 24) |
            (p[1] << 16) |
@@ -96,7 +94,7 @@ static uint8_t* zlib_decompress_uncompressed(
     uint16_t len  = p[0] | (p[1] << 8);
     p += 4;
 
-    uint8_t* out = kmalloc(len);
+    uint8_t* out = malloc(len);
     if (!out)
         return NULL;
 
@@ -171,9 +169,9 @@ uint32_t* png_decode_buffer(
     png_unfilter(decomp, width, height);
 
     uint32_t* out =
-        kmalloc(width * height * 4);
+        malloc(width * height * 4);
     if (!out) {
-        kfree(decomp);
+        free(decomp);
         return NULL;
     }
 
@@ -188,7 +186,7 @@ uint32_t* png_decode_buffer(
         src += stride + 1;
     }
 
-    kfree(decomp);
+    free(decomp);
 
     *out_w = width;
     *out_h = height;
@@ -0,0 +1,90 @@
+#include <stdint.h>
+#include "../../../Syscalls.h"
+#include "Top.h"
+
+#define TOP_MAX_TASKS 64
+
+static process_info_t g_top_tasks[TOP_MAX_TASKS];
+
+static void top_put_padded(const char *text, uint32_t len, uint32_t width) {
+    char pad[2] = {' ', '\0'};
+    for (uint32_t i = len; i < width; ++i) {
+        serial_write_string(pad);
+    }
+    serial_write_string(text);
+}
+
+static void top_put_u64(uint64_t value, uint32_t width) {
+    char digits[21];
+    int pos = 20;
+    digits[pos] = '\0';
+    do {
+        digits[--pos] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+    top_put_padded(&digits[pos], (uint32_t)(20 - pos), width);
+}
+
+static void top_put_i32(int32_t value, uint32_t width) {
+    if (value >= 0) {
+        top_put_u64((uint64_t)value, width);
+        return;
+    }
+    char digits[12];
+    int pos = 11;
+    uint32_t magnitude = (uint32_t)(-(int64_t)value);
+    digits[pos] = '\0';
+    do {
+        digits[--pos] = (char)('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude != 0);
+    digits[--pos] = '-';
+    top_put_padded(&digits[pos], (uint32_t)(11 - pos), width);
+}
+
+static const char *top_state_name(const process_info_t *task) {
+    switch (task->state) {
+    case PROCESS_INFO_READY:
+        return "R";
+    case PROCESS_INFO_RUNNING:
+        return "R*";
+    case PROCESS_INFO_BLOCKED:
+        return "S";
+    case PROCESS_INFO_THROTTLED:
+        return "T";
+    case PROCESS_INFO_DEAD:
+    case PROCESS_INFO_ZOMBIE:
+        return "Z";
+    default:
+        return "?";
+    }
+}
+
+// One snapshot over serial: times in microseconds, cs = vol/invol switches.
+void top_print(void) {
+    int32_t count = process_snapshot(g_top_tasks, TOP_MAX_TASKS);
+    if (count < 0) {
+        serial_write_string("[TOP] snapshot failed\n");
+        return;
+    }
+
+    serial_write_string("[TOP]   PID  TGID  PPID ST CPU NICE    USER_US     SYS_US    WAIT_US      VCS     IVCS  SYSCALLS\n");
+    for (int32_t i = 0; i < count; ++i) {
+        const process_info_t *task = &g_top_tasks[i];
+        serial_write_string("[TOP] ");
+        top_put_i32(task->pid, 5);
+        top_put_i32(task->tgid, 6);
+        top_put_i32(task->parent_pid, 6);
+        const char *state = top_state_name(task);
+        top_put_padded(state, state[1] != '\0' ? 2 : 1, 3);
+        top_put_u64(task->cpu, 4);
+        top_put_i32(task->nice, 5);
+        top_put_u64(task->user_ns / 1000ULL, 11);
+        top_put_u64(task->system_ns / 1000ULL, 11);
+        top_put_u64(task->wait_ns / 1000ULL, 11);
+        top_put_u64(task->voluntary_switches, 9);
+        top_put_u64(task->involuntary_switches, 9);
+        top_put_u64(task->syscalls, 10);
+        serial_write_string(task->kernel ? " [kthread]\n" : "\n");
+    }
+}
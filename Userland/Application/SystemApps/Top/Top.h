@@ -0,0 +1,6 @@
+#ifndef TOP_H
+#define TOP_H
+
+void top_print(void);
+
+#endif
@@ -0,0 +1,200 @@
+#include "Heap.h"
+#include "String.h"
+#include "Sync.h"
+#include "Syscalls.h"
+#include "Thread.h"
+
+#define HEAP_PAGE_SIZE 4096
+#define HEAP_MIN_SHIFT 4
+#define HEAP_MAX_SMALL (16u << (HEAP_CLASSES - 1))
+#define HEAP_SPAN_PAGES 16
+#define HEAP_CACHE_BATCH 32
+#define HEAP_CACHE_MAX 64
+#define HEAP_CLASS_LARGE UINT32_MAX
+
+// Sits in front of every allocation and keeps the payload 16-byte aligned.
+typedef struct {
+    uint32_t class_index;
+    uint32_t pages;
+    uint64_t reserved;
+} heap_header_t;
+
+static mutex_t g_heap_lock = MUTEX_INIT;
+static heap_block_t *g_heap_central[HEAP_CLASSES];
+
+static uint32_t heap_class_size(uint32_t index) {
+    return 1u << (index + HEAP_MIN_SHIFT);
+}
+
+static uint32_t heap_class_of(size_t size) {
+    uint32_t index = 0;
+    while (heap_class_size(index) < size) {
+        index++;
+    }
+    return index;
+}
+
+static heap_cache_t *heap_cache_current(void) {
+    return &thread_block_current()->heap;
+}
+
+// Cuts a fresh span into blocks of one class and chains them up.
+static heap_block_t *heap_span_carve(uint32_t index) {
+    uint32_t stride = heap_class_size(index) + sizeof(heap_header_t);
+    uint8_t *span = (uint8_t *)mem_map(HEAP_SPAN_PAGES);
+    if (span == NULL) {
+        return NULL;
+    }
+    uint32_t blocks = (HEAP_SPAN_PAGES * HEAP_PAGE_SIZE) / stride;
+    heap_block_t *head = NULL;
+    for (uint32_t i = blocks; i-- > 0;) {
+        heap_header_t *header = (heap_header_t *)(span + i * stride);
+        header->class_index = index;
+        header->pages = 0;
+        heap_block_t *block = (heap_block_t *)(header + 1);
+        block->next = head;
+        head = block;
+    }
+    return head;
+}
+
+// Moves up to a batch of blocks from the shared lists into the cache.
+static void heap_cache_refill(heap_cache_t *cache, uint32_t index) {
+    mutex_lock(&g_heap_lock);
+    if (g_heap_central[index] == NULL) {
+        g_heap_central[index] = heap_span_carve(index);
+    }
+    heap_block_t *head = g_heap_central[index];
+    heap_block_t *tail = head;
+    uint32_t taken = 0;
+    while (tail != NULL && ++taken < HEAP_CACHE_BATCH && tail->next != NULL) {
+        tail = tail->next;
+    }
+    if (tail != NULL) {
+        g_heap_central[index] = tail->next;
+        tail->next = cache->free[index];
+        cache->free[index] = head;
+        cache->count[index] += taken;
+    }
+    mutex_unlock(&g_heap_lock);
+}
+
+static void heap_cache_flush(heap_cache_t *cache, uint32_t index, uint32_t keep) {
+    if (cache->count[index] <= keep) {
+        return;
+    }
+    heap_block_t *head = cache->free[index];
+    heap_block_t *tail = head;
+    for (uint32_t i = cache->count[index] - keep; i > 1; --i) {
+        tail = tail->next;
+    }
+    cache->free[index] = tail->next;
+    cache->count[index] = keep;
+
+    mutex_lock(&g_heap_lock);
+    tail->next = g_heap_central[index];
+    g_heap_central[index] = head;
+    mutex_unlock(&g_heap_lock);
+}
+
+void heap_thread_init(heap_cache_t *cache) {
+    for (uint32_t i = 0; i < HEAP_CLASSES; ++i) {
+        cache->free[i] = NULL;
+        cache->count[i] = 0;
+    }
+}
+
+// Hands the exiting thread's cached blocks back to the shared lists.
+void heap_thread_exit(void) {
+    heap_cache_t *cache = heap_cache_current();
+    for (uint32_t i = 0; i < HEAP_CLASSES; ++i) {
+        heap_cache_flush(cache, i, 0);
+    }
+}
+
+void *malloc(size_t size) {
+    if (size > HEAP_MAX_SMALL) {
+        size_t bytes = size + sizeof(heap_header_t);
+        if (bytes < size) {
+            return NULL;
+        }
+        size_t pages = (bytes + HEAP_PAGE_SIZE - 1) / HEAP_PAGE_SIZE;
+        if (pages > UINT32_MAX) {
+            return NULL;
+        }
+        heap_header_t *header = (heap_header_t *)mem_map((uint32_t)pages);
+        if (header == NULL) {
+            return NULL;
+        }
+        header->class_index = HEAP_CLASS_LARGE;
+        header->pages = (uint32_t)pages;
+        return header + 1;
+    }
+
+    uint32_t index = heap_class_of(size);
+    heap_cache_t *cache = heap_cache_current();
+    if (cache->free[index] == NULL) {
+        heap_cache_refill(cache, index);
+        if (cache->free[index] == NULL) {
+            return NULL;
+        }
+    }
+    heap_block_t *block = cache->free[index];
+    cache->free[index] = block->next;
+    cache->count[index]--;
+    return block;
+}
+
+void free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    heap_header_t *header = (heap_header_t *)ptr - 1;
+    if (header->class_index == HEAP_CLASS_LARGE) {
+        mem_unmap(header, header->pages);
+        return;
+    }
+
+    uint32_t index = header->class_index;
+    heap_cache_t *cache = heap_cache_current();
+    heap_block_t *block = (heap_block_t *)ptr;
+    block->next = cache->free[index];
+    cache->free[index] = block;
+    if (++cache->count[index] > HEAP_CACHE_MAX) {
+        heap_cache_flush(cache, index, HEAP_CACHE_MAX - HEAP_CACHE_BATCH);
+    }
+}
+
+void *calloc(size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    void *ptr = malloc(count * size);
+    if (ptr != NULL) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void *realloc(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return malloc(size);
+    }
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    heap_header_t *header = (heap_header_t *)ptr - 1;
+    size_t usable = header->class_index == HEAP_CLASS_LARGE
+        ? (size_t)header->pages * HEAP_PAGE_SIZE - sizeof(heap_header_t)
+        : heap_class_size(header->class_index);
+    if (size <= usable) {
+        return ptr;
+    }
+    void *grown = malloc(size);
+    if (grown != NULL) {
+        memcpy(grown, ptr, usable);
+        free(ptr);
+    }
+    return grown;
+}
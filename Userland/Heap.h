@@ -0,0 +1,23 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#define HEAP_CLASSES 8
+
+typedef struct heap_block {
+    struct heap_block *next;
+} heap_block_t;
+
+// Per-thread free lists, kept in the thread's runtime block (Thread.h).
+typedef struct heap_cache {
+    heap_block_t *free[HEAP_CLASSES];
+    uint32_t count[HEAP_CLASSES];
+} heap_cache_t;
+
+void heap_thread_init(heap_cache_t *cache);
+void heap_thread_exit(void);
+
+void *malloc(size_t size);
+void *calloc(size_t count, size_t size);
+void *realloc(void *ptr, size_t size);
+void free(void *ptr);
@@ -0,0 +1,107 @@
+#include "Ring.h"
+
+// Entries must be powers of two; the completion ring should be at least
+// as large as the submission ring so one submit never stalls on it.
+int32_t ring_init(ring_t *ring, ring_sqe_t *sqes, uint32_t sq_entries, ring_cqe_t *cqes, uint32_t cq_entries)
+{
+    ring->shared.sq_head = 0;
+    ring->shared.sq_tail = 0;
+    ring->shared.cq_head = 0;
+    ring->shared.cq_tail = 0;
+    ring->shared.sq_entries = sq_entries;
+    ring->shared.cq_entries = cq_entries;
+    ring->shared.sqes = sqes;
+    ring->shared.cqes = cqes;
+    ring->sqe_tail = 0;
+    ring->id = io_ring_setup(&ring->shared);
+    return ring->id;
+}
+
+int32_t ring_destroy(ring_t *ring)
+{
+    int32_t rc = io_ring_destroy(ring->id);
+    ring->id = -1;
+    return rc;
+}
+
+// Returns NULL when every slot is queued and not yet consumed by the kernel.
+ring_sqe_t *ring_get_sqe(ring_t *ring)
+{
+    uint32_t head = __atomic_load_n(&ring->shared.sq_head, __ATOMIC_ACQUIRE);
+    if (ring->sqe_tail - head >= ring->shared.sq_entries) {
+        return NULL;
+    }
+    ring_sqe_t *sqe = &ring->shared.sqes[ring->sqe_tail & (ring->shared.sq_entries - 1)];
+    ring->sqe_tail++;
+    return sqe;
+}
+
+// Publishes everything prepared since the last submit and enters the
+// kernel once to run it.
+int64_t ring_submit(ring_t *ring)
+{
+    uint32_t pending = ring->sqe_tail - ring->shared.sq_tail;
+    if (pending == 0) {
+        return 0;
+    }
+    __atomic_store_n(&ring->shared.sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+    return io_ring_enter(ring->id, pending);
+}
+
+ring_cqe_t *ring_peek_cqe(ring_t *ring)
+{
+    uint32_t head = ring->shared.cq_head;
+    if (head == __atomic_load_n(&ring->shared.cq_tail, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return &ring->shared.cqes[head & (ring->shared.cq_entries - 1)];
+}
+
+void ring_cqe_seen(ring_t *ring)
+{
+    __atomic_store_n(&ring->shared.cq_head, ring->shared.cq_head + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t ring_drain(ring_t *ring)
+{
+    uint32_t head = ring->shared.cq_head;
+    uint32_t tail = __atomic_load_n(&ring->shared.cq_tail, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&ring->shared.cq_head, tail, __ATOMIC_RELEASE);
+    return tail - head;
+}
+
+static void ring_prep(ring_sqe_t *sqe, uint32_t op, int32_t fd, uint64_t addr, uint64_t len, uint64_t arg,
+                      uint64_t user_data)
+{
+    sqe->op = op;
+    sqe->fd = fd;
+    sqe->addr = addr;
+    sqe->len = len;
+    sqe->arg = arg;
+    sqe->user_data = user_data;
+}
+
+void ring_prep_nop(ring_sqe_t *sqe, uint64_t user_data)
+{
+    ring_prep(sqe, RING_OP_NOP, -1, 0, 0, 0, user_data);
+}
+
+void ring_prep_read(ring_sqe_t *sqe, int32_t fd, void *buffer, uint64_t len, uint64_t user_data)
+{
+    ring_prep(sqe, RING_OP_FILE_READ, fd, (uint64_t)buffer, len, 0, user_data);
+}
+
+void ring_prep_write(ring_sqe_t *sqe, int32_t fd, const void *buffer, uint64_t len, uint64_t user_data)
+{
+    ring_prep(sqe, RING_OP_FILE_WRITE, fd, (uint64_t)buffer, len, 0, user_data);
+}
+
+void ring_prep_fill_rect(ring_sqe_t *sqe, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color)
+{
+    ring_prep(sqe, RING_OP_DRAW_FILL_RECT, -1, ((uint64_t)x << 32) | y, ((uint64_t)w << 32) | h, color, 0);
+}
+
+void ring_prep_present(ring_sqe_t *sqe)
+{
+    ring_prep(sqe, RING_OP_DRAW_PRESENT, -1, 0, 0, 0, 0);
+}
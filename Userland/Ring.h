@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+#include "Syscalls.h"
+
+typedef struct {
+    io_ring_t shared;
+    int32_t id;
+    uint32_t sqe_tail;
+} ring_t;
+
+int32_t ring_init(ring_t *ring, ring_sqe_t *sqes, uint32_t sq_entries, ring_cqe_t *cqes, uint32_t cq_entries);
+int32_t ring_destroy(ring_t *ring);
+ring_sqe_t *ring_get_sqe(ring_t *ring);
+int64_t ring_submit(ring_t *ring);
+ring_cqe_t *ring_peek_cqe(ring_t *ring);
+void ring_cqe_seen(ring_t *ring);
+uint32_t ring_drain(ring_t *ring);
+
+void ring_prep_nop(ring_sqe_t *sqe, uint64_t user_data);
+void ring_prep_read(ring_sqe_t *sqe, int32_t fd, void *buffer, uint64_t len, uint64_t user_data);
+void ring_prep_write(ring_sqe_t *sqe, int32_t fd, const void *buffer, uint64_t len, uint64_t user_data);
+void ring_prep_fill_rect(ring_sqe_t *sqe, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color);
+void ring_prep_present(ring_sqe_t *sqe);
@@ -0,0 +1,143 @@
+#include "String.h"
+
+// Userland always runs with SSE enabled and its registers are saved per
+// thread, so these use 16-byte loads and stores directly.
+
+void *memcpy(void *dst, const void *src, size_t n) {
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+
+    if (n >= 64) {
+        while (((uintptr_t)d & 15) != 0) {
+            *d++ = *s++;
+            n--;
+        }
+        while (n >= 64) {
+            __asm__ volatile (
+                "movdqu 0(%1), %%xmm0\n\t"
+                "movdqu 16(%1), %%xmm1\n\t"
+                "movdqu 32(%1), %%xmm2\n\t"
+                "movdqu 48(%1), %%xmm3\n\t"
+                "movdqa %%xmm0, 0(%0)\n\t"
+                "movdqa %%xmm1, 16(%0)\n\t"
+                "movdqa %%xmm2, 32(%0)\n\t"
+                "movdqa %%xmm3, 48(%0)"
+                :: "r"(d), "r"(s) : "xmm0", "xmm1", "xmm2", "xmm3", "memory");
+            d += 64;
+            s += 64;
+            n -= 64;
+        }
+    }
+    while (n >= 8) {
+        *(uint64_t *)d = *(const uint64_t *)s;
+        d += 8;
+        s += 8;
+        n -= 8;
+    }
+    while (n != 0) {
+        *d++ = *s++;
+        n--;
+    }
+    return dst;
+}
+
+void *memmove(void *dst, const void *src, size_t n) {
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    if (d <= s || d >= s + n) {
+        return memcpy(dst, src, n);
+    }
+    while (n >= 8) {
+        n -= 8;
+        *(uint64_t *)(d + n) = *(const uint64_t *)(s + n);
+    }
+    while (n != 0) {
+        n--;
+        d[n] = s[n];
+    }
+    return dst;
+}
+
+void *memset(void *dst, int value, size_t n) {
+    uint8_t *d = (uint8_t *)dst;
+    uint64_t pattern = (uint8_t)value * 0x0101010101010101ULL;
+
+    if (n >= 64) {
+        while (((uintptr_t)d & 15) != 0) {
+            *d++ = (uint8_t)value;
+            n--;
+        }
+        __asm__ volatile (
+            "movq %0, %%xmm0\n\t"
+            "punpcklqdq %%xmm0, %%xmm0"
+            :: "r"(pattern) : "xmm0");
+        while (n >= 64) {
+            __asm__ volatile (
+                "movdqa %%xmm0, 0(%0)\n\t"
+                "movdqa %%xmm0, 16(%0)\n\t"
+                "movdqa %%xmm0, 32(%0)\n\t"
+                "movdqa %%xmm0, 48(%0)"
+                :: "r"(d) : "memory");
+            d += 64;
+            n -= 64;
+        }
+    }
+    while (n >= 8) {
+        *(uint64_t *)d = pattern;
+        d += 8;
+        n -= 8;
+    }
+    while (n != 0) {
+        *d++ = (uint8_t)value;
+        n--;
+    }
+    return dst;
+}
+
+int memcmp(const void *s1, const void *s2, size_t n) {
+    const uint8_t *a = (const uint8_t *)s1;
+    const uint8_t *b = (const uint8_t *)s2;
+
+    // Skip equal 16-byte blocks, then find the differing byte the slow way.
+    while (n >= 16) {
+        uint32_t mask;
+        __asm__ (
+            "movdqu (%1), %%xmm0\n\t"
+            "movdqu (%2), %%xmm1\n\t"
+            "pcmpeqb %%xmm1, %%xmm0\n\t"
+            "pmovmskb %%xmm0, %0"
+            : "=r"(mask) : "r"(a), "r"(b), "m"(*(const uint8_t (*)[16])a), "m"(*(const uint8_t (*)[16])b)
+            : "xmm0", "xmm1");
+        if (mask != 0xFFFF) {
+            break;
+        }
+        a += 16;
+        b += 16;
+        n -= 16;
+    }
+    while (n != 0) {
+        if (*a != *b) {
+            return (int)*a - (int)*b;
+        }
+        a++;
+        b++;
+        n--;
+    }
+    return 0;
+}
+
+size_t strlen(const char *str) {
+    const char *p = str;
+    while (*p != '\0') {
+        p++;
+    }
+    return (size_t)(p - str);
+}
+
+int strcmp(const char *a, const char *b) {
+    while (*a != '\0' && *a == *b) {
+        a++;
+        b++;
+    }
+    return (int)*(const uint8_t *)a - (int)*(const uint8_t *)b;
+}
@@ -0,0 +1,108 @@
+#include "Sync.h"
+#include "Syscalls.h"
+
+#define MUTEX_UNLOCKED  0
+#define MUTEX_LOCKED    1
+#define MUTEX_CONTENDED 2
+#define MUTEX_SPIN_COUNT 64
+
+static inline uint32_t atomic_cmpxchg(volatile uint32_t *addr, uint32_t expected, uint32_t desired)
+{
+    __atomic_compare_exchange_n(addr, &expected, desired, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    return expected;
+}
+
+static inline void cpu_relax(void)
+{
+    __asm__ volatile ("pause" ::: "memory");
+}
+
+int32_t mutex_try_lock(mutex_t *mutex)
+{
+    return atomic_cmpxchg(&mutex->state, MUTEX_UNLOCKED, MUTEX_LOCKED) == MUTEX_UNLOCKED ? 0 : -1;
+}
+
+void mutex_lock(mutex_t *mutex)
+{
+    uint32_t state = atomic_cmpxchg(&mutex->state, MUTEX_UNLOCKED, MUTEX_LOCKED);
+    if (state == MUTEX_UNLOCKED) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < MUTEX_SPIN_COUNT && state == MUTEX_LOCKED; ++i) {
+        cpu_relax();
+        state = atomic_cmpxchg(&mutex->state, MUTEX_UNLOCKED, MUTEX_LOCKED);
+        if (state == MUTEX_UNLOCKED) {
+            return;
+        }
+    }
+
+    if (state != MUTEX_CONTENDED) {
+        state = __atomic_exchange_n(&mutex->state, MUTEX_CONTENDED, __ATOMIC_ACQUIRE);
+    }
+    while (state != MUTEX_UNLOCKED) {
+        futex_wait(&mutex->state, MUTEX_CONTENDED, 0);
+        state = __atomic_exchange_n(&mutex->state, MUTEX_CONTENDED, __ATOMIC_ACQUIRE);
+    }
+}
+
+void mutex_unlock(mutex_t *mutex)
+{
+    if (__atomic_exchange_n(&mutex->state, MUTEX_UNLOCKED, __ATOMIC_RELEASE) == MUTEX_CONTENDED) {
+        futex_wake(&mutex->state, 1);
+    }
+}
+
+int32_t cond_timed_wait(cond_t *cond, mutex_t *mutex, uint64_t timeout_ns)
+{
+    uint32_t seq = __atomic_load_n(&cond->seq, __ATOMIC_RELAXED);
+    mutex_unlock(mutex);
+    int32_t result = futex_wait(&cond->seq, seq, timeout_ns);
+    mutex_lock(mutex);
+    return result == FUTEX_RESULT_TIMEOUT ? -1 : 0;
+}
+
+void cond_wait(cond_t *cond, mutex_t *mutex)
+{
+    (void)cond_timed_wait(cond, mutex, 0);
+}
+
+void cond_signal(cond_t *cond)
+{
+    __atomic_add_fetch(&cond->seq, 1, __ATOMIC_RELEASE);
+    futex_wake(&cond->seq, 1);
+}
+
+void cond_broadcast(cond_t *cond)
+{
+    __atomic_add_fetch(&cond->seq, 1, __ATOMIC_RELEASE);
+    futex_wake(&cond->seq, UINT32_MAX);
+}
+
+int32_t semaphore_try_wait(semaphore_t *sem)
+{
+    uint32_t count = __atomic_load_n(&sem->count, __ATOMIC_RELAXED);
+    while (count != 0) {
+        if (__atomic_compare_exchange_n(&sem->count, &count, count - 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void semaphore_wait(semaphore_t *sem)
+{
+    while (semaphore_try_wait(sem) != 0) {
+        __atomic_add_fetch(&sem->waiters, 1, __ATOMIC_SEQ_CST);
+        futex_wait(&sem->count, 0, 0);
+        __atomic_sub_fetch(&sem->waiters, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+void semaphore_post(semaphore_t *sem)
+{
+    __atomic_add_fetch(&sem->count, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&sem->waiters, __ATOMIC_SEQ_CST) != 0) {
+        futex_wake(&sem->count, 1);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t state;
+} mutex_t;
+
+typedef struct {
+    volatile uint32_t seq;
+} cond_t;
+
+typedef struct {
+    volatile uint32_t count;
+    volatile uint32_t waiters;
+} semaphore_t;
+
+#define MUTEX_INIT {0}
+#define COND_INIT {0}
+#define SEMAPHORE_INIT(n) {(n), 0}
+
+void mutex_lock(mutex_t *mutex);
+int32_t mutex_try_lock(mutex_t *mutex);
+void mutex_unlock(mutex_t *mutex);
+
+void cond_wait(cond_t *cond, mutex_t *mutex);
+int32_t cond_timed_wait(cond_t *cond, mutex_t *mutex, uint64_t timeout_ns);
+void cond_signal(cond_t *cond);
+void cond_broadcast(cond_t *cond);
+
+void semaphore_wait(semaphore_t *sem);
+int32_t semaphore_try_wait(semaphore_t *sem);
+void semaphore_post(semaphore_t *sem);
@@ -2,10 +2,209 @@
 #include <stddef.h>
 #include <stdint.h>
 
+typedef struct {
+    uint64_t now_ns;
+    uint64_t interrupts;
+    uint64_t timer_interrupts;
+    uint64_t idle_wakeups;
+    uint64_t irq_latency_samples;
+    uint64_t irq_latency_total_ns;
+    uint64_t irq_latency_max_ns;
+    uint64_t irq_latency_slow;
+} timer_stats_t;
+
+typedef struct {
+    uint64_t written_bytes;
+    uint64_t dropped_messages;
+    uint64_t dropped_bytes;
+} serial_stats_t;
+
+#define CHANNEL_INLINE_MAX 104
+
+// pages/page_addr name a mem_map region that the receiver takes over.
+typedef struct {
+    uint64_t tag;
+    uint32_t len;
+    uint32_t pages;
+    uint64_t page_addr;
+    uint8_t data[CHANNEL_INLINE_MAX];
+} channel_msg_t;
+
+#define POLL_IN  0x001
+#define POLL_OUT 0x004
+#define POLL_ERR 0x008
+#define POLL_HUP 0x010
+
+#define POLL_EDGE 0x1
+
+#define POLL_SOURCE_FD      0
+#define POLL_SOURCE_CHANNEL 1
+#define POLL_SOURCE_PROCESS 2
+
+#define POLL_CTL_ADD 1
+#define POLL_CTL_DEL 2
+#define POLL_CTL_MOD 3
+
+#define POLL_WAIT_FOREVER UINT64_MAX
+
+// (source, id) names what is watched; events is the interest mask going
+// in and the ready mask coming back from poll_wait.
+typedef struct {
+    uint32_t source;
+    int32_t id;
+    uint32_t events;
+    uint32_t flags;
+    uint64_t user_data;
+} poll_event_t;
+
+#define FILE_IOV_MAX 64
+
+typedef struct {
+    void *base;
+    uint64_t len;
+} iovec_t;
+
+#define TRACE_CTL_STOP  0
+#define TRACE_CTL_START 1
+#define TRACE_CTL_CLEAR 2
+#define TRACE_CTL_DUMP  3
+
+#define SYSCALL_PROFILE_SLOTS   64
+#define SYSCALL_PROFILE_BUCKETS 160
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_cycles;
+    uint64_t max_cycles;
+    uint64_t buckets[SYSCALL_PROFILE_BUCKETS];
+} syscall_profile_t;
+
+#define PROCESS_INFO_READY   1
+#define PROCESS_INFO_RUNNING 2
+#define PROCESS_INFO_DEAD    3
+#define PROCESS_INFO_BLOCKED 4
+#define PROCESS_INFO_ZOMBIE  5
+#define PROCESS_INFO_THROTTLED 6
+
+// Same ids as the kernel: equal l2_id means the two CPUs share an L2.
+typedef struct {
+    uint32_t index;
+    uint32_t online;
+    uint32_t apic_id;
+    uint32_t core_id;
+    uint32_t package_id;
+    uint32_t l2_id;
+    uint32_t llc_id;
+} cpu_topology_t;
+
+#define RING_OP_NOP            0
+#define RING_OP_FILE_READ      1
+#define RING_OP_FILE_WRITE     2
+#define RING_OP_DRAW_FILL_RECT 3
+#define RING_OP_DRAW_PRESENT   4
+#define RING_OP_YIELD          5
+
+#define RING_MAX_ENTRIES 4096
+
+typedef struct {
+    uint32_t op;
+    int32_t fd;
+    uint64_t addr;
+    uint64_t len;
+    uint64_t arg;
+    uint64_t user_data;
+} ring_sqe_t;
+
+typedef struct {
+    uint64_t user_data;
+    int64_t result;
+} ring_cqe_t;
+
+typedef struct {
+    volatile uint32_t sq_head;
+    volatile uint32_t sq_tail;
+    volatile uint32_t cq_head;
+    volatile uint32_t cq_tail;
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    ring_sqe_t *sqes;
+    ring_cqe_t *cqes;
+} io_ring_t;
+
+#define SCHED_POLICY_NORMAL   0
+#define SCHED_POLICY_FIFO     1
+#define SCHED_POLICY_RR       2
+#define SCHED_POLICY_DEADLINE 3
+#define SCHED_RT_PRIORITY_MAX 32
+
+typedef struct {
+    int32_t pid;
+    int32_t tgid;
+    int32_t parent_pid;
+    uint8_t state;
+    uint8_t cpu;
+    uint8_t kernel;
+    int8_t nice;
+    uint64_t user_ns;
+    uint64_t system_ns;
+    uint64_t wait_ns;
+    uint64_t voluntary_switches;
+    uint64_t involuntary_switches;
+    uint64_t syscalls;
+} process_info_t;
+
+void serial_write_string(const char *str);
+int32_t serial_get_stats(serial_stats_t *stats);
+int64_t trace_control(uint32_t op);
+int32_t thread_create(int32_t (*entry)(void *), void *arg);
+int32_t thread_join(int32_t tid, int32_t *exit_code);
+__attribute__((noreturn)) void thread_exit(int32_t exit_code);
+int32_t thread_set_tls(void *base);
+void *thread_get_tls(void);
+int32_t thread_self(void);
+int32_t process_self(void);
+void process_yield(void);
+__attribute__((noreturn)) void process_exit(void);
+int32_t process_set_priority(int32_t pid, int32_t nice);
+int32_t process_get_priority(int32_t pid);
+int32_t process_wait(int32_t pid, int32_t *exit_code);
+uint32_t process_current_cpu(void);
+void process_sleep_ns(uint64_t ns);
+int32_t timer_get_stats(timer_stats_t *out);
+int32_t syscall_profile_read(uint32_t num, syscall_profile_t *out);
+int32_t process_snapshot(process_info_t *out, uint32_t max_entries);
+int32_t sched_set(int32_t policy, uint64_t param, uint64_t period_ns);
+int32_t process_set_affinity(int32_t pid, uint64_t mask);
+int32_t process_get_affinity(int32_t pid, uint64_t *mask);
+int32_t cpu_get_topology(uint32_t index, cpu_topology_t *out);
+int32_t io_ring_setup(io_ring_t *ring);
+int64_t io_ring_enter(int32_t ring_id, uint32_t to_submit);
+int32_t io_ring_destroy(int32_t ring_id);
+
+#define FUTEX_RESULT_MISMATCH (-1)
+#define FUTEX_RESULT_TIMEOUT  (-2)
+
+int32_t futex_wait(volatile uint32_t *addr, uint32_t expected, uint64_t timeout_ns);
+int32_t futex_wake(volatile uint32_t *addr, uint32_t count);
+int32_t channel_create(void);
+int32_t channel_destroy(int32_t id);
+int32_t channel_send(int32_t id, const channel_msg_t *msg);
+int32_t channel_call(int32_t id, const channel_msg_t *msg, channel_msg_t *reply);
+int32_t channel_receive(int32_t id, const channel_msg_t *reply, channel_msg_t *out);
+int32_t poll_create(void);
+int32_t poll_destroy(int32_t set);
+int32_t poll_ctl(int32_t set, uint32_t op, const poll_event_t *event);
+int32_t poll_wait(int32_t set, poll_event_t *out, uint32_t max, uint64_t timeout_ns);
+void draw_fill_rect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color);
+void draw_present(void);
 int32_t file_open(const char *path, uint64_t flags);
 int64_t file_read(int32_t fd, void *buffer, uint64_t len);
+int64_t file_write(int32_t fd, const void *buffer, uint64_t len);
+int64_t file_pread(int32_t fd, void *buffer, uint64_t len, uint64_t offset);
+int64_t file_pwrite(int32_t fd, const void *buffer, uint64_t len, uint64_t offset);
+int64_t file_readv(int32_t fd, const iovec_t *iov, uint32_t count);
+int64_t file_writev(int32_t fd, const iovec_t *iov, uint32_t count);
+int32_t file_pipe(int32_t fds[2]);
 int32_t file_close(int32_t fd);
-void* kmalloc(uint32_t size);
-void kfree(void* ptr);
-void* memcpy(void* dst, const void* src, size_t n);
-int memcmp(const void *s1, const void *s2, size_t n);
\ No newline at end of file
+void *mem_map(uint32_t pages);
+int32_t mem_unmap(void *addr, uint32_t pages);
\ No newline at end of file
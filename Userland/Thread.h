@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+#include "Heap.h"
+
+// Every thread's FS base points at its runtime block; self lets %fs:0
+// load the block's own address. thread_set_tls only changes tls.
+typedef struct thread_block {
+    struct thread_block *self;
+    void *tls;
+    heap_cache_t heap;
+} thread_block_t;
+
+static inline thread_block_t *thread_block_current(void) {
+    thread_block_t *block;
+    __asm__ volatile ("mov %%fs:0, %0" : "=r"(block));
+    return block;
+}
+
+void thread_block_init(thread_block_t *block);
@@ -1,6 +1,11 @@
 #include <stdint.h>
-#include "../Kernel/Memory/Other_Utils.h"
+#include "Syscalls.h"
+#include "Heap.h"
+#include "Thread.h"
+#include "Ring.h"
 #include "Application/PNG_Decoder/PNG_Decoder.h"
+#include "Application/Benchmark/Benchmark.h"
+#include "Application/SystemApps/Top/Top.h"
 
 #define SYSCALL_SERIAL_PUTCHAR  1ULL
 #define SYSCALL_SERIAL_PUTS     2ULL
@@ -8,17 +13,52 @@
 #define SYSCALL_PROCESS_YIELD   4ULL
 #define SYSCALL_PROCESS_EXIT    5ULL
 #define SYSCALL_THREAD_CREATE   6ULL
+#define SYSCALL_PROCESS_SET_PRIORITY 7ULL
+#define SYSCALL_PROCESS_GET_PRIORITY 8ULL
+#define SYSCALL_PROCESS_CPU     9ULL
 #define SYSCALL_DRAW_PIXEL      10ULL
 #define SYSCALL_DRAW_FILL_RECT  11ULL
 #define SYSCALL_DRAW_PRESENT    12ULL
+#define SYSCALL_PROCESS_WAIT    13ULL
+#define SYSCALL_PROCESS_SLEEP   14ULL
+#define SYSCALL_TIMER_STATS     15ULL
+#define SYSCALL_THREAD_JOIN     16ULL
+#define SYSCALL_THREAD_SET_FS   17ULL
+#define SYSCALL_THREAD_ID       18ULL
+#define SYSCALL_PROCESS_ID      19ULL
 #define SYSCALL_FILE_OPEN       20ULL
 #define SYSCALL_FILE_READ       21ULL
 #define SYSCALL_FILE_WRITE      22ULL
 #define SYSCALL_FILE_CLOSE      23ULL
-#define SYSCALL_USER_KMALLOC    24ULL
-#define SYSCALL_USER_KFREE      25ULL
-#define SYSCALL_USER_MEMCPY     26ULL
-#define SYSCALL_USER_MEMCMP     27ULL
+#define SYSCALL_MEM_MAP         24ULL
+#define SYSCALL_MEM_UNMAP       25ULL
+#define SYSCALL_FUTEX_WAIT      28ULL
+#define SYSCALL_FUTEX_WAKE      29ULL
+#define SYSCALL_PROFILE_READ    30ULL
+#define SYSCALL_PROCESS_SNAPSHOT 31ULL
+#define SYSCALL_SCHED_SET       32ULL
+#define SYSCALL_SET_AFFINITY    33ULL
+#define SYSCALL_GET_AFFINITY    34ULL
+#define SYSCALL_CPU_TOPOLOGY    35ULL
+#define SYSCALL_RING_SETUP      36ULL
+#define SYSCALL_RING_ENTER      37ULL
+#define SYSCALL_RING_DESTROY    38ULL
+#define SYSCALL_SERIAL_STATS    39ULL
+#define SYSCALL_TRACE_CTL       40ULL
+#define SYSCALL_FILE_PREAD      41ULL
+#define SYSCALL_FILE_PWRITE     42ULL
+#define SYSCALL_FILE_READV      43ULL
+#define SYSCALL_FILE_WRITEV     44ULL
+#define SYSCALL_FILE_PIPE       45ULL
+#define SYSCALL_CHANNEL_CREATE  46ULL
+#define SYSCALL_CHANNEL_DESTROY 47ULL
+#define SYSCALL_CHANNEL_SEND    48ULL
+#define SYSCALL_CHANNEL_CALL    49ULL
+#define SYSCALL_CHANNEL_RECEIVE 50ULL
+#define SYSCALL_POLL_CREATE     51ULL
+#define SYSCALL_POLL_DESTROY    52ULL
+#define SYSCALL_POLL_CTL        53ULL
+#define SYSCALL_POLL_WAIT       54ULL
 
 static inline uint64_t syscall0(uint64_t num)
 {
@@ -81,28 +121,220 @@ static inline uint64_t syscall4(uint64_t num, uint64_t arg1, uint64_t arg2, uint
     return ret;
 }
 
-static void serial_write_string(const char *str)
+void serial_write_string(const char *str)
 {
     (void)syscall1(SYSCALL_SERIAL_PUTS, (uint64_t)str);
 }
 
-static int32_t thread_create(void (*entry)(void))
+int32_t serial_get_stats(serial_stats_t *stats)
 {
-    return (int32_t)syscall1(SYSCALL_THREAD_CREATE, (uint64_t)entry);
+    return (int32_t)syscall1(SYSCALL_SERIAL_STATS, (uint64_t)stats);
 }
 
-static void process_yield(void)
+int64_t trace_control(uint32_t op)
+{
+    return (int64_t)syscall1(SYSCALL_TRACE_CTL, op);
+}
+
+__attribute__((noreturn))
+void thread_exit(int32_t exit_code)
+{
+    heap_thread_exit();
+    (void)syscall1(SYSCALL_PROCESS_EXIT, (uint64_t)(int64_t)exit_code);
+    while (1) {
+    }
+}
+
+void thread_block_init(thread_block_t *block)
+{
+    block->self = block;
+    block->tls = NULL;
+    heap_thread_init(&block->heap);
+    (void)syscall1(SYSCALL_THREAD_SET_FS, (uint64_t)block);
+}
+
+static void thread_start(void *arg, int32_t (*entry)(void *))
+{
+    thread_block_t block;
+    thread_block_init(&block);
+    thread_exit(entry(arg));
+}
+
+int32_t thread_create(int32_t (*entry)(void *), void *arg)
+{
+    return (int32_t)syscall3(SYSCALL_THREAD_CREATE, (uint64_t)thread_start, (uint64_t)arg, (uint64_t)entry);
+}
+
+int32_t thread_join(int32_t tid, int32_t *exit_code)
+{
+    return (int32_t)syscall2(SYSCALL_THREAD_JOIN, (uint64_t)(int64_t)tid, (uint64_t)exit_code);
+}
+
+// FS stays on the runtime block; programs get their own pointer in it.
+int32_t thread_set_tls(void *base)
+{
+    thread_block_current()->tls = base;
+    return 0;
+}
+
+void *thread_get_tls(void)
+{
+    return thread_block_current()->tls;
+}
+
+int32_t thread_self(void)
+{
+    return (int32_t)syscall0(SYSCALL_THREAD_ID);
+}
+
+int32_t process_self(void)
+{
+    return (int32_t)syscall0(SYSCALL_PROCESS_ID);
+}
+
+void process_yield(void)
 {
     (void)syscall0(SYSCALL_PROCESS_YIELD);
 }
 
-static void draw_fill_rect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color)
+int32_t process_set_priority(int32_t pid, int32_t nice)
+{
+    return (int32_t)syscall2(SYSCALL_PROCESS_SET_PRIORITY, (uint64_t)(int64_t)pid, (uint64_t)(int64_t)nice);
+}
+
+int32_t process_get_priority(int32_t pid)
+{
+    return (int32_t)syscall1(SYSCALL_PROCESS_GET_PRIORITY, (uint64_t)(int64_t)pid);
+}
+
+int32_t process_wait(int32_t pid, int32_t *exit_code)
+{
+    return (int32_t)syscall2(SYSCALL_PROCESS_WAIT, (uint64_t)(int64_t)pid, (uint64_t)exit_code);
+}
+
+void process_sleep_ns(uint64_t ns)
+{
+    (void)syscall1(SYSCALL_PROCESS_SLEEP, ns);
+}
+
+int32_t futex_wait(volatile uint32_t *addr, uint32_t expected, uint64_t timeout_ns)
+{
+    return (int32_t)syscall3(SYSCALL_FUTEX_WAIT, (uint64_t)addr, expected, timeout_ns);
+}
+
+int32_t futex_wake(volatile uint32_t *addr, uint32_t count)
+{
+    return (int32_t)syscall2(SYSCALL_FUTEX_WAKE, (uint64_t)addr, count);
+}
+
+int32_t channel_create(void)
+{
+    return (int32_t)syscall0(SYSCALL_CHANNEL_CREATE);
+}
+
+int32_t channel_destroy(int32_t id)
+{
+    return (int32_t)syscall1(SYSCALL_CHANNEL_DESTROY, (uint64_t)id);
+}
+
+int32_t channel_send(int32_t id, const channel_msg_t *msg)
+{
+    return (int32_t)syscall2(SYSCALL_CHANNEL_SEND, (uint64_t)id, (uint64_t)msg);
+}
+
+int32_t channel_call(int32_t id, const channel_msg_t *msg, channel_msg_t *reply)
+{
+    return (int32_t)syscall3(SYSCALL_CHANNEL_CALL, (uint64_t)id, (uint64_t)msg, (uint64_t)reply);
+}
+
+int32_t channel_receive(int32_t id, const channel_msg_t *reply, channel_msg_t *out)
+{
+    return (int32_t)syscall3(SYSCALL_CHANNEL_RECEIVE, (uint64_t)id, (uint64_t)reply, (uint64_t)out);
+}
+
+int32_t poll_create(void)
+{
+    return (int32_t)syscall0(SYSCALL_POLL_CREATE);
+}
+
+int32_t poll_destroy(int32_t set)
+{
+    return (int32_t)syscall1(SYSCALL_POLL_DESTROY, (uint64_t)set);
+}
+
+int32_t poll_ctl(int32_t set, uint32_t op, const poll_event_t *event)
+{
+    return (int32_t)syscall3(SYSCALL_POLL_CTL, (uint64_t)set, op, (uint64_t)event);
+}
+
+int32_t poll_wait(int32_t set, poll_event_t *out, uint32_t max, uint64_t timeout_ns)
+{
+    return (int32_t)syscall4(SYSCALL_POLL_WAIT, (uint64_t)set, (uint64_t)out, max, timeout_ns);
+}
+
+int32_t timer_get_stats(timer_stats_t *out)
+{
+    return (int32_t)syscall1(SYSCALL_TIMER_STATS, (uint64_t)out);
+}
+
+int32_t syscall_profile_read(uint32_t num, syscall_profile_t *out)
+{
+    return (int32_t)syscall2(SYSCALL_PROFILE_READ, num, (uint64_t)out);
+}
+
+int32_t process_snapshot(process_info_t *out, uint32_t max_entries)
+{
+    return (int32_t)syscall2(SYSCALL_PROCESS_SNAPSHOT, (uint64_t)out, max_entries);
+}
+
+// param is the RT priority for FIFO/RR and the runtime in ns for DEADLINE.
+int32_t sched_set(int32_t policy, uint64_t param, uint64_t period_ns)
+{
+    return (int32_t)syscall3(SYSCALL_SCHED_SET, (uint64_t)(int64_t)policy, param, period_ns);
+}
+
+int32_t process_set_affinity(int32_t pid, uint64_t mask)
+{
+    return (int32_t)syscall2(SYSCALL_SET_AFFINITY, (uint64_t)(int64_t)pid, mask);
+}
+
+int32_t process_get_affinity(int32_t pid, uint64_t *mask)
+{
+    return (int32_t)syscall2(SYSCALL_GET_AFFINITY, (uint64_t)(int64_t)pid, (uint64_t)mask);
+}
+
+int32_t cpu_get_topology(uint32_t index, cpu_topology_t *out)
+{
+    return (int32_t)syscall2(SYSCALL_CPU_TOPOLOGY, index, (uint64_t)out);
+}
+
+int32_t io_ring_setup(io_ring_t *ring)
+{
+    return (int32_t)syscall1(SYSCALL_RING_SETUP, (uint64_t)ring);
+}
+
+int64_t io_ring_enter(int32_t ring_id, uint32_t to_submit)
+{
+    return (int64_t)syscall2(SYSCALL_RING_ENTER, (uint64_t)(int64_t)ring_id, to_submit);
+}
+
+int32_t io_ring_destroy(int32_t ring_id)
+{
+    return (int32_t)syscall1(SYSCALL_RING_DESTROY, (uint64_t)(int64_t)ring_id);
+}
+
+uint32_t process_current_cpu(void)
+{
+    return (uint32_t)syscall0(SYSCALL_PROCESS_CPU);
+}
+
+void draw_fill_rect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color)
 {
     uint64_t packed_wh = ((uint64_t)w << 32) | (uint64_t)h;
     (void)syscall4(SYSCALL_DRAW_FILL_RECT, x, y, packed_wh, color);
 }
 
-static void draw_present(void)
+void draw_present(void)
 {
     (void)syscall0(SYSCALL_DRAW_PRESENT);
 }
@@ -122,39 +354,50 @@ __attribute__((unused)) int64_t file_write(int32_t fd, const void *buffer, uint6
     return (int64_t)syscall3(SYSCALL_FILE_WRITE, (uint64_t)fd, (uint64_t)buffer, len);
 }
 
-__attribute__((unused)) int32_t file_close(int32_t fd)
+int64_t file_pread(int32_t fd, void *buffer, uint64_t len, uint64_t offset)
 {
-    return (int32_t)syscall1(SYSCALL_FILE_CLOSE, (uint64_t)fd);
+    return (int64_t)syscall4(SYSCALL_FILE_PREAD, (uint64_t)fd, (uint64_t)buffer, len, offset);
+}
+
+int64_t file_pwrite(int32_t fd, const void *buffer, uint64_t len, uint64_t offset)
+{
+    return (int64_t)syscall4(SYSCALL_FILE_PWRITE, (uint64_t)fd, (uint64_t)buffer, len, offset);
 }
 
-void* kmalloc(uint32_t size) {
-    return (void*)syscall1(SYSCALL_USER_KMALLOC, size);
+int64_t file_readv(int32_t fd, const iovec_t *iov, uint32_t count)
+{
+    return (int64_t)syscall3(SYSCALL_FILE_READV, (uint64_t)fd, (uint64_t)iov, count);
+}
+
+int64_t file_writev(int32_t fd, const iovec_t *iov, uint32_t count)
+{
+    return (int64_t)syscall3(SYSCALL_FILE_WRITEV, (uint64_t)fd, (uint64_t)iov, count);
 }
 
-void kfree(void* ptr) {
-    (void)syscall1(SYSCALL_USER_KFREE, (uint64_t)ptr);
+int32_t file_pipe(int32_t fds[2])
+{
+    return (int32_t)syscall1(SYSCALL_FILE_PIPE, (uint64_t)fds);
 }
 
-void* memcpy(void* dst, const void* src, size_t n) {
-    return (void*)syscall3(SYSCALL_USER_MEMCPY,
-                           (uint64_t)dst,
-                           (uint64_t)src,
-                           (uint64_t)n);
+__attribute__((unused)) int32_t file_close(int32_t fd)
+{
+    return (int32_t)syscall1(SYSCALL_FILE_CLOSE, (uint64_t)fd);
 }
 
-int memcmp(const void *s1, const void *s2, size_t n) {
-    return (int)syscall3(SYSCALL_USER_MEMCMP,
-                         (uint64_t)s1,
-                         (uint64_t)s2,
-                         (uint64_t)n);
+void *mem_map(uint32_t pages)
+{
+    return (void *)syscall1(SYSCALL_MEM_MAP, (uint64_t)pages);
+}
+
+int32_t mem_unmap(void *addr, uint32_t pages)
+{
+    return (int32_t)syscall2(SYSCALL_MEM_UNMAP, (uint64_t)addr, (uint64_t)pages);
 }
 
 __attribute__((noreturn))
-static void process_exit(void)
+void process_exit(void)
 {
-    (void)syscall0(SYSCALL_PROCESS_EXIT);
-    while (1) {
-    }
+    thread_exit(0);
 }
 
 typedef struct {
@@ -170,7 +413,7 @@ uint32_t* load_png(const char* path, ImageSize* out_size) {
         return NULL;
     }
 
-    uint8_t* file_buffer = kmalloc(1024 * 1024);
+    uint8_t* file_buffer = malloc(1024 * 1024);
     if (!file_buffer) {
         serial_write_string("[U] Failed to allocate memory for PNG\n");
         file_close(fd);
@@ -191,7 +434,7 @@ uint32_t* load_png(const char* path, ImageSize* out_size) {
 
     uint32_t width = 0, height = 0;
     uint32_t* rgba = png_decode_buffer(file_buffer, offset, &width, &height);
-    kfree(file_buffer);
+    free(file_buffer);
 
     if (!rgba || width == 0 || height == 0) {
         serial_write_string("[U] Failed to decode PNG\n");
@@ -204,23 +447,81 @@ uint32_t* load_png(const char* path, ImageSize* out_size) {
     return rgba;
 }
 
+#define DRAW_RING_ENTRIES 256
+
+static ring_sqe_t g_draw_sqes[DRAW_RING_ENTRIES];
+static ring_cqe_t g_draw_cqes[DRAW_RING_ENTRIES * 2];
+
+static void draw_ring_push(ring_t *ring, uint32_t x, uint32_t y, uint32_t w, uint32_t color) {
+    ring_sqe_t *sqe = ring_get_sqe(ring);
+    if (sqe == NULL) {
+        ring_submit(ring);
+        ring_drain(ring);
+        sqe = ring_get_sqe(ring);
+    }
+    ring_prep_fill_rect(sqe, x, y, w, 1, color);
+}
+
+// Draws each run of equal pixels as one rectangle and sends them in
+// batches through a ring instead of one syscall per pixel.
+static void draw_image(const uint32_t *rgba, uint32_t width, uint32_t height) {
+    ring_t ring;
+    if (ring_init(&ring, g_draw_sqes, DRAW_RING_ENTRIES, g_draw_cqes, DRAW_RING_ENTRIES * 2) < 0) {
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                draw_fill_rect(x, y, 1, 1, rgba[y * width + x]);
+            }
+        }
+        draw_present();
+        return;
+    }
+    for (uint32_t y = 0; y < height; y++) {
+        const uint32_t *row = &rgba[y * width];
+        uint32_t start = 0;
+        for (uint32_t x = 1; x <= width; x++) {
+            if (x == width || row[x] != row[start]) {
+                draw_ring_push(&ring, start, y, x - start, row[start]);
+                start = x;
+            }
+        }
+    }
+    ring_sqe_t *sqe = ring_get_sqe(&ring);
+    if (sqe == NULL) {
+        ring_submit(&ring);
+        ring_drain(&ring);
+        sqe = ring_get_sqe(&ring);
+    }
+    ring_prep_present(sqe);
+    ring_submit(&ring);
+    ring_drain(&ring);
+    ring_destroy(&ring);
+}
+
+static thread_block_t g_main_block;
+
 void _start(void) {
+    thread_block_init(&g_main_block);
     serial_write_string("[U] userland start\n");
 
+#ifdef USERLAND_BENCH
+    benchmark_run_all();
+#endif
+
     draw_fill_rect(50, 50, 100, 250, 0xFFFFFFFF);
     draw_present();
 
     ImageSize img;
     uint32_t* rgba = load_png("LOGO.PNG", &img);
     if (rgba) {
-        for (uint32_t y = 0; y < img.height; y++) {
-            for (uint32_t x = 0; x < img.width; x++) {
-                draw_fill_rect(x, y, 1, 1, rgba[y * img.width + x]);
-            }
-        }
-        draw_present();
-        kfree(rgba);
+        draw_image(rgba, img.width, img.height);
+        free(rgba);
+    }
+
+#ifdef USERLAND_BENCH
+    top_print();
+#endif
+
+    while (process_wait(-1, NULL) >= 0) {
     }
-    
-    while(1) process_yield();
+    process_exit();
 }
\ No newline at end of file